@@ -0,0 +1,459 @@
+/**
+ * Functions for goal directed search with landmarks (ALT).
+ *
+ * Landmark files start with a fixed size header followed by arrays `nodes`,
+ * `from` and `to`, laid out as described in binfile.h.
+ *
+ * @file    alt.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "alt.h"
+#include "binfile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Magic bytes identifying a landmark file */
+static const char ALT_MAGIC[8] = "DIMELAND";
+
+/** Header of a landmark file. */
+struct alt_header {
+    /** Always `ALT_MAGIC` */
+    char magic[8];
+    /** Format version */
+    uint32_t version;
+    /** Always `BINFILE_BYTE_ORDER` in byte order of the writer */
+    uint32_t byte_order;
+    /** Number of landmarks */
+    uint32_t count;
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Checksum of the graph, see binfile_graph_checksum() */
+    uint64_t graph_checksum;
+    /** File positions of the arrays */
+    uint64_t nodes_pos;
+    uint64_t from_pos;
+    uint64_t to_pos;
+    /** Total size of the file */
+    uint64_t file_size;
+    /** Checksum of everything after the header */
+    uint64_t data_checksum;
+    /** Checksum of the header with this member set to zero */
+    uint64_t header_checksum;
+};
+
+bool alt_parse_selection(const char *name, enum alt_selection *selection)
+{
+    if (strcmp(name, "farthest") == 0) {
+        *selection = ALT_FARTHEST;
+    } else if (strcmp(name, "degree") == 0) {
+        *selection = ALT_DEGREE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Allocate landmarks with uninitialized tables.
+ *
+ * @param count     number of landmarks
+ * @param nodes_num number of nodes of the graph
+ * @return          landmarks or NULL if memory ran out
+ */
+static Landmarks * alt_new(uint32_t count, uint32_t nodes_num)
+{
+    size_t cells = (size_t) count * nodes_num;
+    if (count > 0 && cells / count != nodes_num) return NULL;
+    Landmarks *lm = calloc(1, sizeof *lm);
+    if (!lm) return NULL;
+    lm->count = count;
+    lm->nodes_num = nodes_num;
+    lm->nodes = malloc(((size_t) count + 1) * sizeof *lm->nodes);
+    lm->from = malloc((cells + 1) * sizeof *lm->from);
+    lm->to = malloc((cells + 1) * sizeof *lm->to);
+    if (!lm->nodes || !lm->from || !lm->to) {
+        alt_free(lm);
+        return NULL;
+    }
+    return lm;
+}
+
+/**
+ * Get number of edges of a node in both directions.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param node  index of the node
+ * @return      number of outgoing and incoming edges
+ */
+static uint64_t degree(const Csr *csr, uint32_t node)
+{
+    return (uint64_t) csr->offsets[node + 1] - csr->offsets[node]
+        + csr->rev_offsets[node + 1] - csr->rev_offsets[node];
+}
+
+/** State of computation of distance tables shared by all threads. */
+struct fill {
+    /** Landmarks being built */
+    Landmarks *lm;
+    /** Search context of each thread */
+    Search **searches;
+    /** Whether memory ran out in each thread */
+    bool *failed;
+    /** Table computed by the first task; task `t` computes table
+     * `first + t`, tables `0` to `count - 1` are forward ones. */
+    uint32_t first;
+};
+
+/**
+ * Compute distances from or to one landmark.
+ *
+ * @param f         shared state
+ * @param worker    index of the thread
+ * @param k         index of the landmark
+ * @param backward  compute distances to the landmark
+ */
+static void fill_table(struct fill *f, size_t worker, uint32_t k,
+        bool backward)
+{
+    Landmarks *lm = f->lm;
+    Search *s = f->searches[worker];
+    if (!search_run_all(s, lm->nodes[k], backward)) {
+        f->failed[worker] = true;
+        return;
+    }
+    uint32_t *table = backward ? lm->to : lm->from;
+    for (uint32_t i = 0; i < lm->nodes_num; i++) {
+        table[(size_t) i * lm->count + k] = search_distance(s, i);
+    }
+}
+
+/**
+ * Compute one table, called from the thread pool.
+ *
+ * @param arg       shared struct fill
+ * @param worker    index of the thread
+ * @param task      index of the task
+ */
+static void fill_task(void *arg, size_t worker, size_t task)
+{
+    struct fill *f = arg;
+    uint32_t table = f->first + task;
+    fill_table(f, worker, table % f->lm->count, table >= f->lm->count);
+}
+
+/**
+ * Pick landmarks with the most edges.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param lm    landmarks to be filled in
+ * @return      true if successful, false if memory ran out
+ */
+static bool pick_by_degree(const Csr *csr, Landmarks *lm)
+{
+    /* Partial selection sort, the number of landmarks is small. */
+    bool *used = calloc((size_t) csr->nodes_num + 1, sizeof *used);
+    if (!used) return false;
+    for (uint32_t k = 0; k < lm->count; k++) {
+        uint32_t best = CSR_NONE;
+        for (uint32_t i = 0; i < csr->nodes_num; i++) {
+            if (!used[i] && (best == CSR_NONE
+                        || degree(csr, i) > degree(csr, best))) {
+                best = i;
+            }
+        }
+        used[best] = true;
+        lm->nodes[k] = best;
+    }
+    free(used);
+    return true;
+}
+
+/**
+ * Pick landmarks far from each other and compute their forward tables.
+ * The first landmark is the node farthest from the node with the most edges,
+ * each following one is the node farthest from all landmarks picked before.
+ * Nodes unreachable from all of them are preferred, so that every part of
+ * the graph gets a landmark. Nodes without edges are never picked unless
+ * there is nothing else left.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param f     shared state with landmarks to be filled in
+ * @return      true if successful, false if memory ran out
+ */
+static bool pick_farthest(const Csr *csr, struct fill *f)
+{
+    Landmarks *lm = f->lm;
+    Search *s = f->searches[0];
+    uint32_t *nearest = malloc(((size_t) csr->nodes_num + 1)
+            * sizeof *nearest);
+    bool *used = calloc((size_t) csr->nodes_num + 1, sizeof *used);
+    bool ok = nearest && used;
+
+    uint32_t seed = 0;
+    for (uint32_t i = 1; i < csr->nodes_num; i++) {
+        if (degree(csr, i) > degree(csr, seed)) seed = i;
+    }
+    ok = ok && search_run_all(s, seed, false);
+    for (uint32_t i = 0; ok && i < csr->nodes_num; i++) {
+        /* Unreachable nodes are infinitely far. */
+        nearest[i] = search_distance(s, i);
+    }
+    if (ok) nearest[seed] = 1;
+
+    for (uint32_t k = 0; ok && k < lm->count; k++) {
+        uint32_t best = CSR_NONE;
+        for (uint32_t i = 0; i < csr->nodes_num; i++) {
+            if (used[i] || nearest[i] == 0 || degree(csr, i) == 0) {
+                continue;       /* Landmark, a node next to one or a node
+                                   without edges. */
+            }
+            if (best == CSR_NONE || nearest[i] > nearest[best]
+                    || (nearest[i] == nearest[best]
+                        && degree(csr, i) > degree(csr, best))) {
+                best = i;
+            }
+        }
+        if (best == CSR_NONE) {
+            /* All other nodes are at zero distance or without edges, pick
+             * any unused one. There is always one, as there are no more
+             * landmarks than nodes. */
+            best = k > 0 ? lm->nodes[k - 1] : seed;
+            while (used[best]) best = (best + 1) % csr->nodes_num;
+        }
+        used[best] = true;
+        lm->nodes[k] = best;
+        fill_table(f, 0, k, false);
+        ok = !f->failed[0];
+        if (k == 0) {
+            memset(nearest, 0xff, (size_t) csr->nodes_num * sizeof *nearest);
+        }
+        for (uint32_t i = 0; ok && i < csr->nodes_num; i++) {
+            uint32_t dist = lm->from[(size_t) i * lm->count + k];
+            if (dist < nearest[i]) nearest[i] = dist;
+        }
+    }
+    free(nearest);
+    free(used);
+    return ok;
+}
+
+Landmarks * alt_build(Csr *csr, uint32_t count, enum alt_selection selection,
+        Pool *pool)
+{
+    if (!csr || csr->min_weight < 0 || !csr_build_reverse(csr)) return NULL;
+    if (count > csr->nodes_num) count = csr->nodes_num;
+    Landmarks *lm = alt_new(count, csr->nodes_num);
+    if (!lm) return NULL;
+    if (count == 0) return lm;
+
+    size_t workers = pool_size(pool);
+    struct fill f = { lm, NULL, NULL, 0 };
+    f.searches = calloc(workers, sizeof *f.searches);
+    f.failed = calloc(workers, sizeof *f.failed);
+    bool ok = f.searches && f.failed;
+    for (size_t i = 0; ok && i < workers; i++) {
+        f.searches[i] = search_new(csr, PQ_AUTO);
+        ok = f.searches[i] != NULL;
+    }
+    if (ok && selection == ALT_FARTHEST) {
+        /* Forward tables are computed while picking landmarks. */
+        ok = pick_farthest(csr, &f);
+        f.first = count;
+    } else if (ok) {
+        ok = pick_by_degree(csr, lm);
+    }
+    if (ok) {
+        pool_run(pool, 2 * (size_t) count - f.first, fill_task, &f);
+        for (size_t i = 0; i < workers; i++) {
+            ok = ok && !f.failed[i];
+        }
+    }
+    for (size_t i = 0; f.searches && i < workers; i++) {
+        search_free(f.searches[i]);
+    }
+    free(f.searches);
+    free(f.failed);
+    if (!ok) {
+        alt_free(lm);
+        return NULL;
+    }
+    return lm;
+}
+
+/**
+ * Compute checksum of the header.
+ *
+ * @param hdr   header to be hashed
+ * @return      checksum
+ */
+static uint64_t header_checksum(const struct alt_header *hdr)
+{
+    struct alt_header tmp = *hdr;
+    tmp.header_checksum = 0;
+    return binfile_checksum(BINFILE_CHECKSUM_INIT, &tmp, sizeof tmp);
+}
+
+bool alt_save(const Landmarks *lm, const Csr *csr, const char *path)
+{
+    if (!lm || !csr || !path || lm->nodes_num != csr->nodes_num) return false;
+    struct alt_header hdr;
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, ALT_MAGIC, sizeof hdr.magic);
+    hdr.version = ALT_VERSION;
+    hdr.byte_order = BINFILE_BYTE_ORDER;
+    hdr.count = lm->count;
+    hdr.nodes_num = lm->nodes_num;
+    hdr.graph_checksum = csr->checksum;
+
+    size_t cells = (size_t) lm->count * lm->nodes_num;
+    const void *data[3] = { lm->nodes, lm->from, lm->to };
+    size_t lens[3] = {
+        (size_t) lm->count * sizeof *lm->nodes,
+        cells * sizeof *lm->from,
+        cells * sizeof *lm->to,
+    };
+    uint64_t *pos[3] = { &hdr.nodes_pos, &hdr.from_pos, &hdr.to_pos };
+    uint64_t at = binfile_align(sizeof hdr);
+    for (int i = 0; i < 3; i++) {
+        *pos[i] = at;
+        at += binfile_align(lens[i]);
+    }
+    hdr.file_size = at;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    /* Header is written twice, the second time with checksums filled in. */
+    bool ok = binfile_write_section(f, &hdr, sizeof hdr, NULL);
+    hdr.data_checksum = BINFILE_CHECKSUM_INIT;
+    for (int i = 0; ok && i < 3; i++) {
+        ok = binfile_write_section(f, data[i], lens[i], &hdr.data_checksum);
+    }
+    hdr.header_checksum = header_checksum(&hdr);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0
+        && fwrite(&hdr, sizeof hdr, 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+/**
+ * Check header of a mapped landmark file.
+ *
+ * @param hdr   header of the file
+ * @param size  real size of the file
+ * @param csr   graph the landmarks should belong to
+ * @return      true if the header describes usable landmarks
+ */
+static bool header_valid(const struct alt_header *hdr, size_t size,
+        const Csr *csr)
+{
+    if (memcmp(hdr->magic, ALT_MAGIC, sizeof hdr->magic) != 0
+            || hdr->byte_order != BINFILE_BYTE_ORDER
+            || hdr->version != ALT_VERSION
+            || hdr->header_checksum != header_checksum(hdr)
+            || hdr->file_size != size
+            || !binfile_graph_matches(csr, hdr->nodes_num,
+                hdr->graph_checksum)
+            || hdr->count > csr->nodes_num) {
+        return false;
+    }
+    uint64_t cells = (uint64_t) hdr->count * hdr->nodes_num;
+    return binfile_section_valid(sizeof *hdr, size, hdr->nodes_pos,
+                (uint64_t) hdr->count * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->from_pos, cells * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->to_pos, cells * 4);
+}
+
+Landmarks * alt_open(const Csr *csr, const char *path, bool verify)
+{
+    if (!csr) return NULL;
+    size_t size;
+    void *map = binfile_map(path, sizeof(struct alt_header), &size);
+    if (!map) return NULL;
+    const struct alt_header *hdr = map;
+    const char *base = map;
+    size_t data_pos = binfile_align(sizeof *hdr);
+    if (!header_valid(hdr, size, csr) || (verify && hdr->data_checksum
+                != binfile_checksum(BINFILE_CHECKSUM_INIT, base + data_pos,
+                    size - data_pos))) {
+        munmap(map, size);
+        return NULL;
+    }
+    Landmarks *lm = calloc(1, sizeof *lm);
+    if (!lm) {
+        munmap(map, size);
+        return NULL;
+    }
+    lm->map = map;
+    lm->map_size = size;
+    lm->count = hdr->count;
+    lm->nodes_num = hdr->nodes_num;
+    /* The mapping is read-only, see snapshot_open(). */
+    lm->nodes = (uint32_t *) (base + hdr->nodes_pos);
+    lm->from = (uint32_t *) (base + hdr->from_pos);
+    lm->to = (uint32_t *) (base + hdr->to_pos);
+    for (uint32_t k = 0; k < lm->count; k++) {
+        if (lm->nodes[k] >= lm->nodes_num) {
+            alt_free(lm);
+            return NULL;
+        }
+    }
+    return lm;
+}
+
+uint32_t alt_bound(const void *data, uint32_t node, uint32_t destination)
+{
+    const Landmarks *lm = data;
+    const uint32_t *from_node = lm->from + (size_t) node * lm->count;
+    const uint32_t *from_dest = lm->from + (size_t) destination * lm->count;
+    const uint32_t *to_node = lm->to + (size_t) node * lm->count;
+    const uint32_t *to_dest = lm->to + (size_t) destination * lm->count;
+    uint32_t bound = 0;
+    for (uint32_t k = 0; k < lm->count; k++) {
+        /* d(L, dest) <= d(L, node) + d(node, dest) */
+        if (from_node[k] != UINT32_MAX) {
+            if (from_dest[k] == UINT32_MAX) {
+                return UINT32_MAX;  /* Otherwise L would reach dest. */
+            }
+            if (from_dest[k] > from_node[k]
+                    && from_dest[k] - from_node[k] > bound) {
+                bound = from_dest[k] - from_node[k];
+            }
+        }
+        /* d(node, L) <= d(node, dest) + d(dest, L) */
+        if (to_dest[k] != UINT32_MAX) {
+            if (to_node[k] == UINT32_MAX) {
+                return UINT32_MAX;  /* Otherwise node would reach L. */
+            }
+            if (to_node[k] > to_dest[k] && to_node[k] - to_dest[k] > bound) {
+                bound = to_node[k] - to_dest[k];
+            }
+        }
+    }
+    return bound;
+}
+
+bool alt_run(Search *s, const Landmarks *lm, uint32_t source,
+        uint32_t destination)
+{
+    if (!lm) return false;
+    return search_run_astar(s, source, destination, alt_bound, lm);
+}
+
+void alt_free(Landmarks *lm)
+{
+    if (lm) {
+        if (lm->map) {
+            munmap(lm->map, lm->map_size);
+        } else {
+            free(lm->nodes);
+            free(lm->from);
+            free(lm->to);
+        }
+    }
+    free(lm);
+}
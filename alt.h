@@ -0,0 +1,147 @@
+/**
+ * Interface for goal directed search with landmarks (ALT).
+ *
+ * A few nodes are picked as landmarks and distances from every landmark to
+ * all nodes and from all nodes to every landmark are precomputed. By the
+ * triangle inequality they give lower bounds of distance between any two
+ * nodes, which direct A* search (see search_run_astar()) towards the
+ * destination, so it finishes far fewer nodes than Dijkstra's algorithm.
+ *
+ * Lower bounds are only valid for graphs without negative edge weights.
+ *
+ * @file    alt.h
+ */
+#ifndef ALT_H
+#define ALT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pool.h"
+#include "search.h"
+
+/** Default number of landmarks */
+#define ALT_DEFAULT_LANDMARKS 16
+
+/** Version of the landmark file format written by this program. */
+#define ALT_VERSION 1
+
+/** Ways of picking landmarks. */
+enum alt_selection {
+    /** Each landmark is the node farthest from the landmarks picked before.
+     * This gives better bounds but searches from landmarks can not run in
+     * parallel while they are being picked. */
+    ALT_FARTHEST,
+    /** Landmarks are the nodes with the most edges. */
+    ALT_DEGREE
+};
+
+/** Landmarks with precomputed distances. */
+typedef struct landmarks Landmarks;
+
+/**
+ * Representation of landmarks.
+ *
+ * Tables are stored by node, distances of one node to all landmarks are next
+ * to each other. Unreachable nodes have distance `UINT32_MAX`.
+ */
+struct landmarks {
+    /** Number of landmarks */
+    uint32_t count;
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Index of each landmark */
+    uint32_t *nodes;
+    /** Distance from landmark `k` to node `i` at position `i * count + k` */
+    uint32_t *from;
+    /** Distance from node `i` to landmark `k` at position `i * count + k` */
+    uint32_t *to;
+    /** Memory mapping holding the arrays, NULL if they were allocated */
+    void *map;
+    /** Size of the memory mapping */
+    size_t map_size;
+};
+
+/**
+ * Parse name of a way of picking landmarks.
+ *
+ * @param name          name, `farthest` or `degree`
+ * @param selection[out] parsed value
+ * @return              true if the name is valid
+ */
+bool alt_parse_selection(const char *name, enum alt_selection *selection);
+
+/**
+ * Pick landmarks and compute their distance tables.
+ * Reverse edges of the graph are built if they do not exist yet.
+ *
+ * @param csr       frozen graph without negative edge weights
+ * @param count     number of landmarks, at most number of nodes is used
+ * @param selection way of picking landmarks
+ * @param pool      threads running searches from landmarks, may be NULL
+ * @return          landmarks or NULL if memory ran out or the graph has
+ *                  negative weights
+ */
+Landmarks * alt_build(Csr *csr, uint32_t count, enum alt_selection selection,
+        Pool *pool);
+
+/**
+ * Write landmarks into a file.
+ * The file records checksum of the graph and can only be opened with the
+ * same graph. Existing file is overwritten.
+ *
+ * @param lm    landmarks to be stored
+ * @param csr   graph the landmarks were built for
+ * @param path  name of the file
+ * @return      true if successful, false otherwise
+ */
+bool alt_save(const Landmarks *lm, const Csr *csr, const char *path);
+
+/**
+ * Open a landmark file.
+ * The file is mapped read-only into memory.
+ *
+ * @param csr       graph the landmarks were built for
+ * @param path      name of the file
+ * @param verify    whether to verify checksum of the data
+ * @return          landmarks or NULL if the file does not exist, is damaged
+ *                  or belongs to a different graph
+ */
+Landmarks * alt_open(const Csr *csr, const char *path, bool verify);
+
+/**
+ * Compute lower bound of distance between two nodes.
+ * This is a search_heuristic taking landmarks as its data.
+ *
+ * @param lm            landmarks
+ * @param node          index of a node
+ * @param destination   index of destination node
+ * @return              lower bound of the distance or `UINT32_MAX` if the
+ *                      destination is not reachable from the node
+ */
+uint32_t alt_bound(const void *lm, uint32_t node, uint32_t destination);
+
+/**
+ * Find shortest path between two nodes using A* search with landmarks.
+ * Results are reported as after search_run().
+ *
+ * @param s             context to search in
+ * @param lm            landmarks of the searched graph
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool alt_run(Search *s, const Landmarks *lm, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Free landmarks.
+ *
+ * @param lm    landmarks to be freed
+ */
+void alt_free(Landmarks *lm);
+
+#endif /* end of include guard: ALT_H */
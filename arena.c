@@ -0,0 +1,120 @@
+/**
+ * Functions for arena allocation.
+ *
+ * Chunks form a linked list with the one being filled at its head. Chunks
+ * for large blocks are linked behind the head, so the free space of the
+ * head is not abandoned.
+ *
+ * Chunks are mapped directly from the system rather than taken from the
+ * heap, so freeing an arena returns its memory to the system even if other
+ * allocations were made after it.
+ *
+ * @file    arena.c
+ */
+#define _POSIX_C_SOURCE 200809L
+/* Anonymous mappings are not part of POSIX. */
+#define _DEFAULT_SOURCE
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/** Header of a chunk, blocks follow it. */
+struct chunk {
+    /** Chunk allocated before this one */
+    struct chunk *next;
+    /** Size of the chunk including the header */
+    size_t size;
+};
+
+/** Size of chunk header rounded up to the alignment of blocks */
+#define HEADER_SIZE \
+    ((sizeof(struct chunk) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+struct arena {
+    /** Chunk being filled, NULL before the first allocation */
+    struct chunk *head;
+    /** Size of regular chunks */
+    size_t chunk_size;
+    /** Position of the first free byte of the head chunk */
+    size_t used;
+    /** Total size of all chunks */
+    size_t reserved;
+};
+
+Arena * arena_new(size_t chunk_size)
+{
+    Arena *a = calloc(1, sizeof *a);
+    if (!a) return NULL;
+    a->chunk_size = chunk_size > 0 ? chunk_size : ARENA_DEFAULT_CHUNK;
+    if (a->chunk_size < 4 * HEADER_SIZE) a->chunk_size = 4 * HEADER_SIZE;
+    return a;
+}
+
+/**
+ * Allocate a new chunk.
+ *
+ * @param a     arena the chunk belongs to
+ * @param size  size of the chunk including the header
+ * @return      new chunk or NULL if memory is exhausted
+ */
+static struct chunk * chunk_new(Arena *a, size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    struct chunk *c = p;
+    c->size = size;
+    a->reserved += size;
+    return c;
+}
+
+void * arena_alloc(Arena *a, size_t size)
+{
+    if (!a || size > SIZE_MAX - HEADER_SIZE - ARENA_ALIGN) return NULL;
+    size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if (size > (a->chunk_size - HEADER_SIZE) / 4) {
+        struct chunk *c = chunk_new(a, HEADER_SIZE + size);
+        if (!c) return NULL;
+        if (a->head) {
+            c->next = a->head->next;
+            a->head->next = c;
+        } else {
+            /* Nothing can be allocated behind the block. */
+            c->next = NULL;
+            a->head = c;
+            a->used = c->size;
+        }
+        return (char *) c + HEADER_SIZE;
+    }
+    if (!a->head || a->used + size > a->head->size) {
+        struct chunk *c = chunk_new(a, a->chunk_size);
+        if (!c) return NULL;
+        c->next = a->head;
+        a->head = c;
+        a->used = HEADER_SIZE;
+    }
+    void *block = (char *) a->head + a->used;
+    a->used += size;
+    return block;
+}
+
+size_t arena_reserved(const Arena *a)
+{
+    return a ? a->reserved : 0;
+}
+
+void arena_free(Arena *a)
+{
+    if (a) {
+        struct chunk *c = a->head;
+        while (c) {
+            struct chunk *next = c->next;
+            munmap(c, c->size);
+            c = next;
+        }
+    }
+    free(a);
+}
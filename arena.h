@@ -0,0 +1,61 @@
+/**
+ * Interface for arena allocation.
+ *
+ * An arena hands out memory from large chunks by moving a pointer forward.
+ * Single allocations can not be freed; all memory of an arena is released
+ * at once by arena_free(), which costs one system call per chunk.
+ *
+ * @file    arena.h
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/** Alignment of every block returned by arena_alloc() */
+#define ARENA_ALIGN 16
+
+/** Default size of chunks */
+#define ARENA_DEFAULT_CHUNK (1 << 20)
+
+/**
+ * Arena is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct arena Arena;
+
+/**
+ * Create a new arena.
+ * No memory is reserved for blocks until the first allocation.
+ *
+ * @param chunk_size    size of chunks, zero means `ARENA_DEFAULT_CHUNK`
+ * @return              new arena or NULL if memory is exhausted
+ */
+Arena * arena_new(size_t chunk_size);
+
+/**
+ * Allocate an uninitialized block.
+ * Blocks larger than a quarter of a chunk get a chunk of their own.
+ *
+ * @param a     arena to allocate from
+ * @param size  size of the block
+ * @return      aligned block or NULL if memory is exhausted
+ */
+void * arena_alloc(Arena *a, size_t size);
+
+/**
+ * Get amount of memory reserved by an arena.
+ *
+ * @param a     arena to query
+ * @return      total size of its chunks in bytes
+ */
+size_t arena_reserved(const Arena *a);
+
+/**
+ * Free an arena together with all blocks allocated from it.
+ *
+ * @param a     arena to be freed
+ */
+void arena_free(Arena *a);
+
+#endif /* end of include guard: ARENA_H */
@@ -0,0 +1,737 @@
+/**
+ * @file    bench.c
+ *
+ * Benchmark comparing priority queue implementations and search algorithms.
+ *
+ * The program loads CSV files with nodes and edges, for example made by
+ * `graph-gen`, or opens a snapshot created by `graph-traverse
+ * --save-snapshot`. It draws random pairs of nodes and answers the same
+ * queries with every
+ * priority queue and then with bidirectional search, with A* search guided
+ * by landmarks and with contraction hierarchies. It prints time spent and
+ * average number of finished nodes of each variant and checks that all of
+ * them found paths of the same length.
+ *
+ * Then it finds paths from a few of the starting nodes to all nodes with
+ * Dijkstra's algorithm and with parallel delta-stepping and compares the
+ * distances.
+ *
+ * Finally it answers the queries with Dijkstra's algorithm on copies of the
+ * graph with nodes in each order of reorder.h and counts cache misses where
+ * the system lets the program read hardware counters.
+ *
+ * Times of loading, of building indices and of all variants can be written
+ * to a CSV file and compared with such a file from an earlier run; variants
+ * that got slower by more than a tolerance are reported as regressions.
+ */
+#define _POSIX_C_SOURCE 200809L
+/* syscall() is needed for hardware counters. */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "alt.h"
+#include "ch.h"
+#include "delta.h"
+#include "csr.h"
+#include "graph.h"
+#include "loader.h"
+#include "pool.h"
+#include "pq.h"
+#include "reorder.h"
+#include "search.h"
+#include "snapshot.h"
+
+/** Default number of queries */
+static const size_t DEFAULT_QUERIES = 1000;
+/** Number of starting nodes of paths to all nodes */
+static const size_t ALL_SOURCES = 8;
+/** Default tolerated slowdown against the baseline in percent */
+static const double DEFAULT_TOLERANCE = 20;
+/** Variants faster than this many seconds in the baseline are too noisy to
+ * be reported as regressions */
+static const double MIN_COMPARED = 0.01;
+
+/** Measurement of one variant. */
+struct result {
+    /** Name of the variant */
+    char name[32];
+    /** Total time in seconds */
+    double seconds;
+    /** Time per query in microseconds, zero for builds */
+    double query_us;
+    /** Average number of finished nodes per query, zero for builds */
+    double settled;
+};
+
+/** Growing list of measurements. */
+struct results {
+    struct result *data;
+    size_t len;
+    size_t size;
+};
+
+/**
+ * Get next pseudo-random number.
+ * This is xorshift64*, it is used instead of rand() so that results do not
+ * depend on the C library.
+ *
+ * @param state     state of the generator, must not be zero
+ * @return          random number
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * Read monotonic clock.
+ *
+ * @return  current time in seconds
+ */
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Append a measurement.
+ *
+ * @param r         list to append to
+ * @param name      name of the variant, truncated if too long
+ * @param seconds   total time
+ * @param query_us  time per query
+ * @param settled   finished nodes per query
+ * @return          true if successful, false if memory ran out
+ */
+static bool results_add(struct results *r, const char *name, double seconds,
+        double query_us, double settled)
+{
+    if (r->len == r->size) {
+        size_t size = r->size ? 2 * r->size : 32;
+        struct result *tmp = realloc(r->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        r->data = tmp;
+        r->size = size;
+    }
+    struct result *x = &r->data[r->len++];
+    snprintf(x->name, sizeof x->name, "%s", name);
+    x->seconds = seconds;
+    x->query_us = query_us;
+    x->settled = settled;
+    return true;
+}
+
+/**
+ * Write measurements as CSV with a header line.
+ *
+ * @param r     measurements
+ * @param path  name of the file
+ * @return      true if successful
+ */
+static bool results_write(const struct results *r, const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "name,seconds,query_us,settled\n");
+    for (size_t i = 0; i < r->len; i++) {
+        fprintf(f, "%s,%.6f,%.3f,%.1f\n", r->data[i].name, r->data[i].seconds,
+                r->data[i].query_us, r->data[i].settled);
+    }
+    return fclose(f) == 0;
+}
+
+/**
+ * Read measurements written by results_write().
+ * Lines that do not hold a measurement, like the header, are skipped.
+ *
+ * @param r     list to append to
+ * @param path  name of the file
+ * @return      true if successful
+ */
+static bool results_read(struct results *r, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    bool ok = true;
+    while (ok && fgets(line, sizeof line, f)) {
+        char name[32];
+        double seconds, query_us, settled;
+        if (sscanf(line, "%31[^,],%lf,%lf,%lf", name, &seconds, &query_us,
+                    &settled) == 4) {
+            ok = results_add(r, name, seconds, query_us, settled);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Compare measurements with a baseline and print the differences.
+ *
+ * @param current   measurements of this run
+ * @param baseline  measurements of an earlier run
+ * @param tolerance tolerated slowdown in percent
+ * @return          number of regressions
+ */
+static size_t results_compare(const struct results *current,
+        const struct results *baseline, double tolerance)
+{
+    size_t regressions = 0;
+    printf("%-16s %12s %12s %12s\n", "baseline", "before [s]", "now [s]",
+            "change");
+    for (size_t i = 0; i < current->len; i++) {
+        const struct result *x = &current->data[i];
+        const struct result *b = NULL;
+        for (size_t j = 0; !b && j < baseline->len; j++) {
+            if (strcmp(baseline->data[j].name, x->name) == 0) {
+                b = &baseline->data[j];
+            }
+        }
+        if (!b) {
+            printf("%-16s %12s %12.3f\n", x->name, "-", x->seconds);
+            continue;
+        }
+        double change = b->seconds > 0 ? (x->seconds / b->seconds - 1) * 100
+            : 0;
+        bool slower = b->seconds >= MIN_COMPARED && change > tolerance;
+        regressions += slower;
+        printf("%-16s %12.3f %12.3f %+11.1f%%%s%s\n", x->name, b->seconds,
+                x->seconds, change, slower ? "  REGRESSION" : "",
+                x->settled - b->settled > 0.05 || b->settled - x->settled > 0.05
+                ? "  (settled changed)" : "");
+    }
+    return regressions;
+}
+
+/**
+ * Load a graph from CSV files and freeze it, the same way as
+ * `graph-traverse` does.
+ *
+ * @param nodes_path    file with nodes
+ * @param edges_path    file with edges
+ * @param results       where to record times of loading and freezing
+ * @return              frozen graph or NULL on failure
+ */
+static Csr * load_csv(const char *nodes_path, const char *edges_path,
+        struct results *results)
+{
+    double start = now();
+    Graph *g = graph_new();
+    uint32_t *ids = NULL;
+    size_t len = 0;
+    bool ok = g && loader_read_nodes(nodes_path, &ids, &len) == LOADER_OK;
+    for (size_t i = 0; ok && i < len; i++) {
+        ok = graph_insert_node(g, ids[i]);
+    }
+    free(ids);
+    struct edge_list edges;
+    memset(&edges, 0, sizeof edges);
+    size_t merged = 0;
+    ok = ok && loader_read_edges(edges_path, &edges) == LOADER_OK
+        && loader_merge_edges(&edges, LOADER_KEEP_MIN, &merged) == LOADER_OK;
+    for (size_t i = 0; ok && i < edges.len; i++) {
+        ok = graph_insert_edge(g, edges.sources[i], edges.destinations[i],
+                edges.mindelays[i]);
+    }
+    loader_free_edges(&edges);
+    double loaded = now();
+    Csr *csr = ok ? graph_freeze(g) : NULL;
+    double frozen = now();
+    graph_free(g);
+    if (csr) {
+        printf("loaded in %.3f s, %zu repeated edges merged, frozen in "
+                "%.3f s\n", loaded - start, merged, frozen - loaded);
+        ok = results_add(results, "load", loaded - start, 0, 0)
+            && results_add(results, "freeze", frozen - loaded, 0, 0);
+    }
+    if (!ok) {
+        csr_free(csr);
+        return NULL;
+    }
+    return csr;
+}
+
+/**
+ * Start counting cache misses of the calling thread.
+ *
+ * @return  file descriptor of the counter or -1 if it is not available
+ */
+static int cache_counter_start(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    /* Counting only the program itself needs no privileges. */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Stop counting cache misses.
+ *
+ * @param fd    counter returned by cache_counter_start()
+ * @return      number of cache misses or -1 if it is not known
+ */
+static double cache_counter_stop(int fd)
+{
+    if (fd < 0) return -1;
+    double misses = -1;
+#ifdef __linux__
+    uint64_t count;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof count) == sizeof count) {
+        misses = count;
+    }
+#endif
+    close(fd);
+    return misses;
+}
+
+/** Search algorithms compared by the benchmark. */
+enum algorithm {
+    DIJKSTRA,
+    BIDIRECTIONAL,
+    LANDMARKS,
+    CONTRACTION
+};
+
+/**
+ * Answer all queries with one priority queue.
+ *
+ * @param csr           graph to be searched
+ * @param kind          priority queue to use
+ * @param algorithm     search algorithm
+ * @param lm            landmarks for A* search
+ * @param h             contraction hierarchy
+ * @param pairs         indices of starting and destination nodes
+ * @param n             number of queries
+ * @param[out] dist     distance found by each query
+ * @param[out] settled  total number of finished nodes
+ * @return              time in seconds or negative value on failure
+ */
+static double run(const Csr *csr, enum pq_kind kind, enum algorithm algorithm,
+        const Landmarks *lm, const Hierarchy *h, const uint32_t *pairs,
+        size_t n, uint32_t *dist, uint64_t *settled)
+{
+    Search *s = search_new(algorithm == CONTRACTION ? &h->graph : csr, kind);
+    if (!s) return -1;
+    *settled = 0;
+    double start = now();
+    for (size_t i = 0; i < n; i++) {
+        uint32_t src = pairs[2 * i];
+        uint32_t dst = pairs[2 * i + 1];
+        bool found;
+        switch (algorithm) {
+        case BIDIRECTIONAL:
+            found = search_run_bidirectional(s, src, dst);
+            break;
+        case LANDMARKS:
+            found = alt_run(s, lm, src, dst);
+            break;
+        case CONTRACTION:
+            found = ch_run(s, h, src, dst);
+            break;
+        default:
+            found = search_run(s, src, dst);
+        }
+        dist[i] = found ? search_distance(s, dst) : UINT32_MAX;
+        *settled += search_settled(s);
+    }
+    double time = now() - start;
+    search_free(s);
+    return time;
+}
+
+/**
+ * Print and record one row of results and compare distances with expected
+ * ones.
+ *
+ * @param results   where to record the row
+ * @param name      name of the variant
+ * @param time      time in seconds
+ * @param settled   total number of finished nodes
+ * @param n         number of queries
+ * @param dist      distances found by the variant
+ * @param expected  distances found by the first variant, NULL for the first
+ *                  variant itself
+ * @return          true if the distances match and the row was recorded
+ */
+static bool report(struct results *results, const char *name, double time,
+        uint64_t settled, size_t n, const uint32_t *dist,
+        const uint32_t *expected)
+{
+    printf("%-16s %12.3f %12.1f %12.0f\n", name, time, time * 1e6 / n,
+            (double) settled / n);
+    if (!results_add(results, name, time, time * 1e6 / n,
+                (double) settled / n)) {
+        fputs("out of memory\n", stderr);
+        return false;
+    }
+    if (expected && memcmp(dist, expected, n * sizeof *dist) != 0) {
+        fprintf(stderr, "%s: distances differ\n", name);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Find paths to all nodes from several starting nodes with Dijkstra's
+ * algorithm and with delta-stepping and print results of both.
+ *
+ * @param csr       graph to be searched
+ * @param d         delta-stepping context
+ * @param sources   indices of starting nodes
+ * @param n         number of starting nodes
+ * @param results   where to record times
+ * @return          0 if successful, 4 if memory ran out, 8 if distances
+ *                  differ
+ */
+static int run_all(const Csr *csr, Delta *d, const uint32_t *sources,
+        size_t n, struct results *results)
+{
+    Search *s = search_new(csr, PQ_AUTO);
+    if (!s) return 4;
+    double time_seq = 0;
+    double time_delta = 0;
+    uint64_t reached = 0;
+    bool same = true;
+    for (size_t i = 0; i < n; i++) {
+        double start = now();
+        if (!search_run_all(s, sources[i], false)) {
+            search_free(s);
+            return 4;
+        }
+        time_seq += now() - start;
+        start = now();
+        if (!delta_run(d, sources[i])) {
+            search_free(s);
+            return 4;
+        }
+        time_delta += now() - start;
+        for (uint32_t v = 0; v < csr->nodes_num; v++) {
+            same = same && search_distance(s, v) == delta_distance(d, v);
+            reached += search_distance(s, v) != UINT32_MAX;
+        }
+    }
+    search_free(s);
+    if (!report(results, "all-dijkstra", time_seq, reached, n, NULL, NULL)
+            || !report(results, "all-delta", time_delta, reached, n, NULL,
+                NULL)) {
+        return 4;
+    }
+    if (!same) {
+        fputs("all-delta: distances differ\n", stderr);
+        return 8;
+    }
+    return 0;
+}
+
+/**
+ * Answer queries on copies of the graph with nodes in each order.
+ *
+ * @param csr       graph to be searched, reverse edges are built
+ * @param pairs     indices of starting and destination nodes
+ * @param n         number of queries
+ * @param expected  distances found on the original graph
+ * @param results   where to record times
+ * @return          0 if successful, 4 if memory ran out, 8 if distances
+ *                  differ
+ */
+static int run_orders(Csr *csr, const uint32_t *pairs, size_t n,
+        const uint32_t *expected, struct results *results)
+{
+    uint32_t *mapped = malloc(2 * n * sizeof *mapped);
+    uint32_t *dist = malloc(n * sizeof *dist);
+    uint32_t *rank = malloc(((size_t) csr->nodes_num + 1) * sizeof *rank);
+    int status = mapped && dist && rank ? 0 : 4;
+    printf("%-16s %12s %12s %12s %12s\n", "node order", "total [s]",
+            "query [us]", "settled", "misses");
+    for (int k = 0; status == 0 && k < REORDER_KINDS; k++) {
+        double start = now();
+        uint32_t *order = reorder_compute(csr, k);
+        Csr *r = order ? reorder_apply(csr, order) : NULL;
+        double build = now() - start;
+        if (!r) {
+            free(order);
+            status = 4;
+            break;
+        }
+        for (uint32_t i = 0; i < csr->nodes_num; i++) {
+            rank[order[i]] = i;
+        }
+        free(order);
+        for (size_t i = 0; i < 2 * n; i++) {
+            mapped[i] = rank[pairs[i]];
+        }
+        uint64_t settled;
+        int fd = cache_counter_start();
+        double time = run(r, search_auto_queue(r), DIJKSTRA, NULL, NULL,
+                mapped, n, dist, &settled);
+        double misses = cache_counter_stop(fd);
+        csr_free(r);
+        if (time < 0) {
+            status = 4;
+            break;
+        }
+        printf("%-16s %12.3f %12.1f %12.0f ", reorder_name(k), time,
+                time * 1e6 / n, (double) settled / n);
+        if (misses >= 0) {
+            printf("%12.0f", misses / n);
+        } else {
+            printf("%12s", "n/a");
+        }
+        printf("   (ordered in %.3f s)\n", build);
+        char name[32];
+        snprintf(name, sizeof name, "order-%s", reorder_name(k));
+        if (!results_add(results, name, time, time * 1e6 / n,
+                    (double) settled / n)) {
+            status = 4;
+        }
+        if (memcmp(dist, expected, n * sizeof *dist) != 0) {
+            fprintf(stderr, "%s: distances differ\n", reorder_name(k));
+            status = 8;
+        }
+    }
+    free(mapped);
+    free(dist);
+    free(rank);
+    return status;
+}
+
+/**
+ * Print usage of the program.
+ *
+ * @param name  name of the program
+ */
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--queries N] [--seed S] [--threads N] "
+            "[--delta W] [--results FILE] [--baseline FILE] "
+            "[--tolerance P] [--no-hierarchy] SNAPSHOT | NODES EDGES\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = DEFAULT_QUERIES;
+    uint64_t seed = 1;
+    size_t threads = 0;
+    uint32_t width = 0;
+    const char *results_path = NULL;
+    const char *baseline_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    bool hierarchy = true;
+    const char *paths[2] = { NULL, NULL };
+    int paths_num = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            n = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--delta") == 0 && i + 1 < argc) {
+            width = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--results") == 0 && i + 1 < argc) {
+            results_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--no-hierarchy") == 0) {
+            hierarchy = false;
+        } else if (paths_num < 2 && argv[i][0] != '-') {
+            paths[paths_num++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (paths_num == 0 || n == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    struct results results = { NULL, 0, 0 };
+    struct results baseline = { NULL, 0, 0 };
+    if (baseline_path && !results_read(&baseline, baseline_path)) {
+        fprintf(stderr, "%s: can not read baseline\n", baseline_path);
+        free(baseline.data);
+        return 3;
+    }
+    Csr *csr = NULL;
+    if (paths_num == 1) {
+        double start = now();
+        csr = snapshot_open(paths[0], false);
+        if (csr && !results_add(&results, "load", now() - start, 0, 0)) {
+            csr_free(csr);
+            csr = NULL;
+        }
+    } else {
+        csr = load_csv(paths[0], paths[1], &results);
+    }
+    if (!csr || csr->nodes_num == 0) {
+        fprintf(stderr, "%s: can not load graph\n", paths[0]);
+        csr_free(csr);
+        free(results.data);
+        free(baseline.data);
+        return 3;
+    }
+    if (csr->min_weight < 0) {
+        fprintf(stderr, "%s: negative edge weights are not supported\n",
+                paths[0]);
+        csr_free(csr);
+        free(results.data);
+        free(baseline.data);
+        return 3;
+    }
+
+    uint32_t *pairs = malloc(2 * n * sizeof *pairs);
+    uint32_t *expected = malloc(n * sizeof *expected);
+    uint32_t *dist = malloc(n * sizeof *dist);
+    if (!pairs || !expected || !dist) {
+        fputs("out of memory\n", stderr);
+        free(pairs);
+        free(expected);
+        free(dist);
+        csr_free(csr);
+        return 4;
+    }
+    uint64_t state = seed ? seed : 1;
+    for (size_t i = 0; i < 2 * n; i++) {
+        pairs[i] = next_random(&state) % csr->nodes_num;
+    }
+
+    int status = 0;
+    printf("automatically picked heap: %s\n", pq_name(search_auto_queue(csr)));
+    printf("%-16s %12s %12s %12s\n", "search", "total [s]", "query [us]",
+            "settled");
+    uint64_t settled;
+    for (int k = 0; status == 0 && k < PQ_KINDS; k++) {
+        double time = run(csr, k, DIJKSTRA, NULL, NULL, pairs, n,
+                k == 0 ? expected : dist, &settled);
+        if (time < 0) {
+            status = 4;
+        } else if (!report(&results, pq_name(k), time, settled, n,
+                    k == 0 ? expected : dist, k == 0 ? NULL : expected)) {
+            status = 8;
+        }
+    }
+    if (status == 0) {
+        double start = now();
+        if (!csr_build_reverse(csr)
+                || !results_add(&results, "reverse", now() - start, 0, 0)) {
+            status = 4;
+        }
+    }
+    Landmarks *lm = NULL;
+    if (status == 0) {
+        double start = now();
+        lm = alt_build(csr, ALT_DEFAULT_LANDMARKS, ALT_FARTHEST, NULL);
+        double time = now() - start;
+        if (!lm || !results_add(&results, "landmarks", time, 0, 0)) {
+            status = 4;
+        } else {
+            printf("%u landmarks built in %.3f s\n", lm->count, time);
+        }
+    }
+    Hierarchy *h = NULL;
+    if (status == 0 && lm && hierarchy) {
+        double start = now();
+        h = ch_build(csr, NULL);
+        double time = now() - start;
+        if (!h || !results_add(&results, "hierarchy", time, 0, 0)) {
+            status = 4;
+        } else {
+            printf("hierarchy built in %.3f s, %u nodes in core\n", time,
+                    h->core);
+        }
+    }
+    static const char *names[] = { "dijkstra", "bidir", "alt", "ch" };
+    for (int a = BIDIRECTIONAL; status == 0 && a <= CONTRACTION; a++) {
+        if ((a >= LANDMARKS && !lm) || (a == CONTRACTION && !h)) {
+            break;
+        }
+        char name[32];
+        enum pq_kind kind = search_auto_queue(csr);
+        snprintf(name, sizeof name, "%s-%s", names[a], pq_name(kind));
+        double time = run(csr, kind, a, lm, h, pairs, n, dist, &settled);
+        if (time < 0) {
+            status = 4;
+        } else if (!report(&results, name, time, settled, n, dist,
+                    expected)) {
+            status = 8;
+        }
+    }
+    ch_free(h);
+    alt_free(lm);
+    if (status == 0) {
+        Pool *pool = pool_new(threads);
+        Delta *d = pool ? delta_new(csr, width, pool) : NULL;
+        if (!d) {
+            status = 4;
+        } else {
+            printf("paths to all nodes, %zu threads, delta %u\n",
+                    pool_size(pool), delta_width(d));
+            status = run_all(csr, d, pairs, n < ALL_SOURCES ? n : ALL_SOURCES,
+                    &results);
+        }
+        delta_free(d);
+        pool_free(pool);
+    }
+    if (status == 0) {
+        status = run_orders(csr, pairs, n, expected, &results);
+    }
+    if (status == 4) {
+        fputs("out of memory\n", stderr);
+    }
+    if (status == 0 && results_path && !results_write(&results, results_path)) {
+        fprintf(stderr, "%s: can not write results\n", results_path);
+        status = 7;
+    }
+    if (status == 0 && baseline_path) {
+        size_t regressions = results_compare(&results, &baseline, tolerance);
+        if (regressions > 0) {
+            fprintf(stderr, "%zu variants slower than baseline by more than "
+                    "%g %%\n", regressions, tolerance);
+            status = 9;
+        }
+    }
+
+    free(pairs);
+    free(expected);
+    free(dist);
+    free(results.data);
+    free(baseline.data);
+    csr_free(csr);
+    return status;
+}
@@ -0,0 +1,104 @@
+/**
+ * Functions shared by binary files written by this program.
+ *
+ * @file    binfile.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "binfile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t binfile_checksum(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/** Padding of sections */
+static const char zeros[BINFILE_ALIGN];
+
+/**
+ * Continue computing checksum with a section padded to the alignment.
+ *
+ * @param hash  checksum of preceding sections
+ * @param data  content of the section
+ * @param len   size of the content
+ * @return      updated checksum
+ */
+static uint64_t checksum_section(uint64_t hash, const void *data, size_t len)
+{
+    hash = binfile_checksum(hash, data, len);
+    return binfile_checksum(hash, zeros, binfile_align(len) - len);
+}
+
+uint64_t binfile_graph_checksum(const Csr *csr)
+{
+    uint64_t hash = BINFILE_CHECKSUM_INIT;
+    if (!csr) return hash;
+    /* Sections are hashed the way snapshot_save() writes them. */
+    hash = checksum_section(hash, csr->offsets,
+            ((size_t) csr->nodes_num + 1) * sizeof *csr->offsets);
+    hash = checksum_section(hash, csr->ids,
+            (size_t) csr->nodes_num * sizeof *csr->ids);
+    hash = checksum_section(hash, csr->targets,
+            (size_t) csr->edges_num * sizeof *csr->targets);
+    return checksum_section(hash, csr->weights,
+            (size_t) csr->edges_num * sizeof *csr->weights);
+}
+
+bool binfile_graph_matches(const Csr *csr, uint64_t nodes_num,
+        uint64_t graph_checksum)
+{
+    return csr && nodes_num == csr->nodes_num
+        && graph_checksum == csr->checksum;
+}
+
+uint64_t binfile_align(uint64_t pos)
+{
+    return (pos + BINFILE_ALIGN - 1) / BINFILE_ALIGN * BINFILE_ALIGN;
+}
+
+bool binfile_write_section(FILE *f, const void *data, size_t len,
+        uint64_t *hash)
+{
+    size_t pad = binfile_align(len) - len;
+    if (fwrite(data, 1, len, f) != len || fwrite(zeros, 1, pad, f) != pad) {
+        return false;
+    }
+    if (hash) {
+        *hash = checksum_section(*hash, data, len);
+    }
+    return true;
+}
+
+bool binfile_section_valid(size_t header_size, uint64_t file_size,
+        uint64_t pos, uint64_t len)
+{
+    return pos % BINFILE_ALIGN == 0 && pos >= header_size
+        && pos <= file_size && len <= file_size - pos;
+}
+
+void * binfile_map(const char *path, size_t min_size, size_t *size)
+{
+    if (!path) return NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < min_size
+            || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    *size = st.st_size;
+    void *map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
@@ -0,0 +1,107 @@
+/**
+ * Interface for binary files written by this program.
+ *
+ * Snapshots and precomputed indices share the same conventions: a fixed size
+ * header followed by arrays starting at positions aligned to
+ * `BINFILE_ALIGN` bytes, native byte order recorded in the header and 64-bit
+ * FNV-1a checksums. Files are read by mapping them into memory.
+ *
+ * @file    binfile.h
+ */
+#ifndef BINFILE_H
+#define BINFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "csr.h"
+
+/** Value used to detect byte order of a file */
+#define BINFILE_BYTE_ORDER 0x01020304
+/** Alignment of arrays in a file */
+#define BINFILE_ALIGN 64
+/** Initial value of a checksum */
+#define BINFILE_CHECKSUM_INIT 0xcbf29ce484222325ULL
+
+/**
+ * Continue computing checksum of a memory block.
+ * The checksum is not cryptographic, it only detects damaged files.
+ *
+ * @param hash  checksum of preceding data, `BINFILE_CHECKSUM_INIT` at first
+ * @param data  block to be hashed
+ * @param len   size of the block
+ * @return      updated checksum
+ */
+uint64_t binfile_checksum(uint64_t hash, const void *data, size_t len);
+
+/**
+ * Compute checksum of nodes and edges of a frozen graph.
+ * It is equal to the data checksum of a snapshot of the graph, so a graph
+ * mapped from a snapshot takes it from the file instead of reading all its
+ * pages. Graphs keep it in member `checksum` from the moment they are frozen.
+ *
+ * @param csr   frozen graph
+ * @return      checksum of the graph
+ */
+uint64_t binfile_graph_checksum(const Csr *csr);
+
+/**
+ * Check that an index file was computed for a graph.
+ * Indices record number of nodes and checksum of their graph to detect that
+ * they are used with a different one.
+ *
+ * @param csr               graph the index is opened with
+ * @param nodes_num         number of nodes recorded in the file
+ * @param graph_checksum    checksum of the graph recorded in the file
+ * @return                  true if the index belongs to the graph
+ */
+bool binfile_graph_matches(const Csr *csr, uint64_t nodes_num,
+        uint64_t graph_checksum);
+
+/**
+ * Round position up to the alignment of arrays.
+ *
+ * @param pos   position in a file
+ * @return      aligned position
+ */
+uint64_t binfile_align(uint64_t pos);
+
+/**
+ * Write a section of a file padded to the alignment.
+ *
+ * @param f         file to write to
+ * @param data      content of the section
+ * @param len       size of the content
+ * @param hash[out] checksum to be updated with written bytes, may be NULL
+ * @return          true if successful, false otherwise
+ */
+bool binfile_write_section(FILE *f, const void *data, size_t len,
+        uint64_t *hash);
+
+/**
+ * Check that a section fits into a file.
+ *
+ * @param header_size   size of the header of the file
+ * @param file_size     size of the file
+ * @param pos           position of the section
+ * @param len           size of the section
+ * @return              true if the section is valid
+ */
+bool binfile_section_valid(size_t header_size, uint64_t file_size,
+        uint64_t pos, uint64_t len);
+
+/**
+ * Map a whole file read-only into memory.
+ * Release the mapping with munmap().
+ *
+ * @param path          name of the file
+ * @param min_size      smallest acceptable size of the file
+ * @param size[out]     size of the file
+ * @return              address of the mapping or NULL if the file can not
+ *                      be mapped or is too small
+ */
+void * binfile_map(const char *path, size_t min_size, size_t *size);
+
+#endif /* end of include guard: BINFILE_H */
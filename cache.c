@@ -0,0 +1,232 @@
+/**
+ * Functions for caching shortest-path trees of popular starting nodes.
+ *
+ * Saved trees are kept in a list ordered by their last use and found through
+ * an array indexed by starting node. A tree is replaced by a new one whenever
+ * a search from its starting node continues it. Searches run outside of the
+ * lock; a tree dropped while another thread continues it is freed by that
+ * thread.
+ *
+ * @file    cache.c
+ */
+#include "cache.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+/** Saved tree of one starting node. */
+struct entry {
+    /** Index of the starting node */
+    uint32_t source;
+    /** State of the last search from the node */
+    struct search_tree tree;
+    /** Memory taken by the entry in bytes */
+    size_t memory;
+    /** Neighbours in the list, more recently used first */
+    struct entry *prev;
+    struct entry *next;
+    /** Number of threads continuing the search */
+    uint32_t users;
+    /** Whether the entry was removed from the cache */
+    bool dropped;
+};
+
+struct cache {
+    /** Guards everything below */
+    pthread_mutex_t lock;
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Entry of each starting node, NULL if it has none */
+    struct entry **entries;
+    /** Most and least recently used entry */
+    struct entry *first;
+    struct entry *last;
+    /** Highest memory taken by entries */
+    size_t budget;
+    /** Statistics, including current memory */
+    struct cache_stats stats;
+};
+
+Cache * cache_new(const Csr *csr, size_t budget)
+{
+    if (!csr || csr->min_weight < 0) return NULL;
+    Cache *c = calloc(1, sizeof *c);
+    if (!c) return NULL;
+    c->nodes_num = csr->nodes_num;
+    c->budget = budget;
+    c->entries = calloc((size_t) csr->nodes_num + 1, sizeof *c->entries);
+    if (!c->entries || pthread_mutex_init(&c->lock, NULL) != 0) {
+        free(c->entries);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+/**
+ * Free an entry.
+ *
+ * @param e     entry to be freed
+ */
+static void entry_free(struct entry *e)
+{
+    search_tree_free(&e->tree);
+    free(e);
+}
+
+/**
+ * Remove an entry from the list of a locked cache.
+ *
+ * @param c     cache
+ * @param e     entry in the list
+ */
+static void unlink_entry(Cache *c, struct entry *e)
+{
+    if (e->prev) {
+        e->prev->next = e->next;
+    } else {
+        c->first = e->next;
+    }
+    if (e->next) {
+        e->next->prev = e->prev;
+    } else {
+        c->last = e->prev;
+    }
+    e->prev = NULL;
+    e->next = NULL;
+}
+
+/**
+ * Insert an entry at the front of the list of a locked cache.
+ *
+ * @param c     cache
+ * @param e     entry not in the list
+ */
+static void push_entry(Cache *c, struct entry *e)
+{
+    e->next = c->first;
+    if (c->first) {
+        c->first->prev = e;
+    } else {
+        c->last = e;
+    }
+    c->first = e;
+}
+
+/**
+ * Remove an entry from a locked cache and free it unless it is in use.
+ *
+ * @param c     cache
+ * @param e     entry in the cache
+ */
+static void drop_entry(Cache *c, struct entry *e)
+{
+    unlink_entry(c, e);
+    c->entries[e->source] = NULL;
+    c->stats.memory -= e->memory;
+    c->stats.trees--;
+    e->dropped = true;
+    if (e->users == 0) {
+        entry_free(e);
+    }
+}
+
+/**
+ * Save state of the last search of a context into a cache, replacing the
+ * entry of its starting node.
+ * Failures are ignored, the state is just not saved.
+ *
+ * @param c         cache
+ * @param s         search context after search_run() or search_resume()
+ * @param source    index of the starting node
+ */
+static void store(Cache *c, Search *s, uint32_t source)
+{
+    struct entry *e = calloc(1, sizeof *e);
+    if (!e) return;
+    if (!search_save(s, &e->tree)) {
+        free(e);
+        return;
+    }
+    e->source = source;
+    e->memory = sizeof *e + 3 * ((size_t) e->tree.len + 1) * sizeof(uint32_t);
+    if (e->memory > c->budget) {
+        entry_free(e);
+        return;
+    }
+    pthread_mutex_lock(&c->lock);
+    if (c->entries[source]) {
+        drop_entry(c, c->entries[source]);
+    }
+    push_entry(c, e);
+    c->entries[source] = e;
+    c->stats.memory += e->memory;
+    c->stats.trees++;
+    /* The new entry fits, so it is never dropped here. */
+    while (c->stats.memory > c->budget) {
+        drop_entry(c, c->last);
+        c->stats.evicted++;
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+bool cache_run(Cache *c, Search *s, uint32_t source, uint32_t destination)
+{
+    if (!c || !search_trace(s)) return false;
+    assert(source < c->nodes_num);
+    pthread_mutex_lock(&c->lock);
+    struct entry *e = c->entries[source];
+    if (e) {
+        e->users++;
+        unlink_entry(c, e);
+        push_entry(c, e);
+    } else {
+        c->stats.misses++;
+    }
+    pthread_mutex_unlock(&c->lock);
+
+    if (!e) {
+        bool found = search_run(s, source, destination);
+        store(c, s, source);
+        return found;
+    }
+    bool found = search_resume(s, &e->tree, destination);
+    bool searched = search_settled(s) > 0;
+    pthread_mutex_lock(&c->lock);
+    if (searched) {
+        c->stats.resumed++;
+    } else {
+        c->stats.hits++;
+    }
+    if (--e->users == 0 && e->dropped) {
+        entry_free(e);
+    }
+    pthread_mutex_unlock(&c->lock);
+    /* A tree finishing the destination stays as it is. */
+    if (searched) {
+        store(c, s, source);
+    }
+    return found;
+}
+
+void cache_get_stats(Cache *c, struct cache_stats *stats)
+{
+    pthread_mutex_lock(&c->lock);
+    *stats = c->stats;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void cache_free(Cache *c)
+{
+    if (c) {
+        while (c->first) {
+            struct entry *e = c->first;
+            c->first = e->next;
+            entry_free(e);
+        }
+        pthread_mutex_destroy(&c->lock);
+        free(c->entries);
+        free(c);
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * Interface for caching shortest-path trees of popular starting nodes.
+ *
+ * Queries from the same starting node search the same part of the graph
+ * again. A cache keeps the state of the last search from each starting node
+ * (see search_save()), so a later query is answered from the saved tree if
+ * its destination was already finished, or continues the saved search
+ * otherwise. Trees that were not used for the longest time are dropped when
+ * they take more memory than allowed.
+ *
+ * One cache can be shared by threads searching the same graph, each with its
+ * own search context. Only graphs without negative edge weights can be
+ * searched.
+ *
+ * @file    cache.h
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "search.h"
+
+/**
+ * Cache is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct cache Cache;
+
+/** Statistics of a cache. */
+struct cache_stats {
+    /** Queries answered from a saved tree without searching */
+    uint64_t hits;
+    /** Queries answered by continuing a saved search */
+    uint64_t resumed;
+    /** Queries from starting nodes without a saved tree */
+    uint64_t misses;
+    /** Trees dropped to make room for others */
+    uint64_t evicted;
+    /** Number of saved trees */
+    size_t trees;
+    /** Memory taken by saved trees in bytes */
+    size_t memory;
+};
+
+/**
+ * Create an empty cache.
+ *
+ * @param csr       frozen graph without negative edge weights
+ * @param budget    highest memory taken by saved trees in bytes
+ * @return          new cache or NULL if memory ran out or the graph has
+ *                  negative weights
+ */
+Cache * cache_new(const Csr *csr, size_t budget);
+
+/**
+ * Find shortest path between two nodes, using and updating saved trees.
+ * The path is then reported by the search context as if it was found by
+ * search_run().
+ *
+ * @param c             cache
+ * @param s             search context for the graph of the cache
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool cache_run(Cache *c, Search *s, uint32_t source, uint32_t destination);
+
+/**
+ * Get statistics of a cache.
+ *
+ * @param c         cache to query
+ * @param[out] stats where to store the statistics
+ */
+void cache_get_stats(Cache *c, struct cache_stats *stats);
+
+/**
+ * Free a cache with all saved trees.
+ *
+ * @param c     cache to be freed
+ */
+void cache_free(Cache *c);
+
+#endif /* end of include guard: CACHE_H */
@@ -0,0 +1,1143 @@
+/**
+ * Functions for contraction hierarchies.
+ *
+ * Contraction runs in rounds. In each round priorities of nodes whose
+ * neighbourhood changed are recomputed, then all nodes with lower priority
+ * than all their neighbours are contracted at once. Such nodes are never
+ * adjacent, so both steps run in parallel; witness searches of a round avoid
+ * all nodes contracted in it, which makes the result independent of the
+ * order inside the round. Only inserting shortcuts into the graph is done by
+ * a single thread. Nodes with too many edges are never contracted, they are
+ * left for the core together with the nodes remaining when contraction
+ * stops.
+ *
+ * Hierarchy files start with a fixed size header followed by the arrays of
+ * the hierarchy, laid out as described in binfile.h.
+ *
+ * @file    ch.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "ch.h"
+#include "binfile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Witness searches finish at most this many nodes and relax at most
+ * this many edges. Unfinished searches only cause unnecessary shortcuts. */
+#define WITNESS_LIMIT 256
+#define WITNESS_RELAXED 1024
+/** Witness searches estimating priority of a node finish at most this many
+ * nodes and relax at most this many edges. */
+#define ESTIMATE_LIMIT 32
+#define ESTIMATE_RELAXED 128
+/** Nodes with more edges than this are not contracted and stay in the core,
+ * the number of their witness searches and shortcuts would grow with the
+ * square of the degree. */
+#define CONTRACT_DEGREE 64
+/** Contraction stops when nodes of the remaining graph have this many edges
+ * on average. */
+#define CORE_DEGREE 16
+/** Number of nodes processed by one task */
+#define BLOCK 256
+
+/** Edge of the graph being contracted. */
+struct arc {
+    /** Index of the node at the other end */
+    uint32_t node;
+    /** Weight of the edge */
+    uint32_t weight;
+    /** Node bypassed by the edge, `CSR_NONE` for original edges */
+    uint32_t middle;
+};
+
+/** Growing list of edges of a node. */
+struct arcs {
+    struct arc *data;
+    uint32_t len;
+    uint32_t size;
+};
+
+/** Shortcut waiting to be inserted into the graph. */
+struct shortcut {
+    uint32_t from;
+    uint32_t to;
+    uint32_t weight;
+    uint32_t middle;
+};
+
+/** State of witness searches owned by one thread. */
+struct witness {
+    /** Epoch of current search, see search.c */
+    uint32_t epoch;
+    /** Epoch in which distance of each node was last written */
+    uint32_t *stamp;
+    /** Distance of each node from the starting node */
+    uint32_t *dist;
+    /** Epoch in which each node was last a target of the search */
+    uint32_t *target;
+    /** Queue of reached but unfinished nodes */
+    Pq *queue;
+    /** Shortcuts found in current round */
+    struct shortcut *shortcuts;
+    size_t len;
+    size_t size;
+    /** Whether memory ran out */
+    bool failed;
+};
+
+/** Graph being contracted and state shared by all threads. */
+struct builder {
+    /** Number of nodes */
+    uint32_t nodes_num;
+    /** Outgoing and incoming edges of each node. Edges of uncontracted nodes
+     * lead to uncontracted nodes only; edges of a contracted node are kept as
+     * they were when it was contracted and become its upward and downward
+     * edges. */
+    struct arcs *out;
+    struct arcs *in;
+    /** Rank of each node, `CSR_NONE` until it is contracted */
+    uint32_t *rank;
+    /** Priority of each uncontracted node, lower is contracted earlier */
+    int32_t *priority;
+    /** Number of contracted neighbours of each node */
+    uint32_t *deleted;
+    /** Whether priority of each node needs to be recomputed */
+    bool *dirty;
+    /** Whether each node is contracted in current round */
+    bool *selected;
+    /** Uncontracted nodes */
+    uint32_t *remaining;
+    uint32_t remaining_num;
+    /** Number of edges between uncontracted nodes */
+    uint64_t edges;
+    /** State of each thread */
+    struct witness *workers;
+    size_t workers_num;
+};
+
+/**
+ * Set weight of an edge to the minimum of its weight and a new one,
+ * inserting the edge if it does not exist.
+ *
+ * @param a         edges of a node
+ * @param node      other end of the edge
+ * @param weight    new weight
+ * @param middle    node bypassed by the new edge
+ * @param added[out] set to true if the edge was inserted
+ * @return          true if successful, false if memory ran out
+ */
+static bool arcs_set_min(struct arcs *a, uint32_t node, uint32_t weight,
+        uint32_t middle, bool *added)
+{
+    *added = false;
+    for (uint32_t i = 0; i < a->len; i++) {
+        if (a->data[i].node == node) {
+            if (weight < a->data[i].weight) {
+                a->data[i].weight = weight;
+                a->data[i].middle = middle;
+            }
+            return true;
+        }
+    }
+    if (a->len == a->size) {
+        uint32_t size = a->size ? 2 * a->size : 4;
+        struct arc *tmp = realloc(a->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        a->data = tmp;
+        a->size = size;
+    }
+    a->data[a->len].node = node;
+    a->data[a->len].weight = weight;
+    a->data[a->len].middle = middle;
+    a->len++;
+    *added = true;
+    return true;
+}
+
+/**
+ * Remove an edge.
+ *
+ * @param a     edges of a node
+ * @param node  other end of the edge
+ */
+static void arcs_remove(struct arcs *a, uint32_t node)
+{
+    for (uint32_t i = 0; i < a->len; i++) {
+        if (a->data[i].node == node) {
+            a->data[i] = a->data[--a->len];
+            return;
+        }
+    }
+}
+
+/**
+ * Fill edges of all nodes from a frozen graph.
+ * Parallel edges are merged into one with the lowest weight, loops are left
+ * out.
+ *
+ * @param b         builder with allocated lists
+ * @param lists     lists to be filled
+ * @param offsets   first edge of each node
+ * @param ends      node at the other end of each edge
+ * @param weights   weight of each edge
+ * @return          true if successful, false if memory ran out
+ */
+static bool fill_arcs(struct builder *b, struct arcs *lists,
+        const uint32_t *offsets, const uint32_t *ends, const int32_t *weights)
+{
+    /* Position of the edge to each node in the list being filled. */
+    uint32_t *pos = calloc((size_t) b->nodes_num + 1, sizeof *pos);
+    if (!pos) return false;
+    for (uint32_t i = 0; i < b->nodes_num; i++) {
+        struct arcs *a = &lists[i];
+        uint32_t len = offsets[i + 1] - offsets[i];
+        a->data = malloc(((size_t) len + 1) * sizeof *a->data);
+        if (!a->data) {
+            free(pos);
+            return false;
+        }
+        a->size = len + 1;
+        for (uint32_t e = offsets[i]; e < offsets[i + 1]; e++) {
+            uint32_t node = ends[e];
+            if (node == i) {
+                continue;
+            }
+            uint32_t p = pos[node];
+            if (p < a->len && a->data[p].node == node) {
+                if ((uint32_t) weights[e] < a->data[p].weight) {
+                    a->data[p].weight = weights[e];
+                }
+                continue;
+            }
+            pos[node] = a->len;
+            a->data[a->len].node = node;
+            a->data[a->len].weight = weights[e];
+            a->data[a->len].middle = CSR_NONE;
+            a->len++;
+        }
+    }
+    free(pos);
+    return true;
+}
+
+/**
+ * Run a witness search from an incoming neighbour of a node to its outgoing
+ * neighbours.
+ * Distances of reached nodes are left in the state of the thread.
+ *
+ * @param b             builder
+ * @param w             state of the thread
+ * @param source        index of starting node
+ * @param avoid         node that the paths must not pass through
+ * @param limit         paths longer than this are not needed
+ * @param max_settled   maximum number of nodes to be finished
+ * @param max_relaxed   maximum number of edges to be relaxed
+ * @param contracting   also avoid all nodes selected in current round
+ */
+static void witness_search(const struct builder *b, struct witness *w,
+        uint32_t source, uint32_t avoid, uint32_t limit, uint32_t max_settled,
+        uint32_t max_relaxed, bool contracting)
+{
+    if (++w->epoch == 0) {
+        memset(w->stamp, 0, (size_t) b->nodes_num * sizeof *w->stamp);
+        memset(w->target, 0, (size_t) b->nodes_num * sizeof *w->target);
+        w->epoch = 1;
+    }
+    /* The search ends early once all targets are finished. */
+    uint32_t targets = 0;
+    for (uint32_t i = 0; i < b->out[avoid].len; i++) {
+        uint32_t x = b->out[avoid].data[i].node;
+        if (x != source && w->target[x] != w->epoch) {
+            w->target[x] = w->epoch;
+            targets++;
+        }
+    }
+    pq_clear(w->queue);
+    w->stamp[source] = w->epoch;
+    w->dist[source] = 0;
+    if (!pq_push(w->queue, source, 0)) {
+        w->failed = true;
+        return;
+    }
+    uint32_t settled = 0;
+    uint32_t relaxed = 0;
+    uint32_t current, dist;
+    while (pq_pop(w->queue, &current, &dist)) {
+        if (dist > limit || ++settled > max_settled
+                || (w->target[current] == w->epoch && --targets == 0)) {
+            break;
+        }
+        const struct arcs *a = &b->out[current];
+        for (uint32_t i = 0; i < a->len; i++) {
+            /* Distances found so far are still lengths of real paths. */
+            if (++relaxed > max_relaxed) {
+                return;
+            }
+            uint32_t next = a->data[i].node;
+            uint32_t alt = dist + a->data[i].weight;
+            /* Nodes beyond the limit would never be finished. */
+            if (alt > limit || next == avoid
+                    || (contracting && b->selected[next])) {
+                continue;
+            }
+            bool ok = true;
+            if (w->stamp[next] != w->epoch) {
+                w->stamp[next] = w->epoch;
+                w->dist[next] = alt;
+                ok = pq_push(w->queue, next, alt);
+            } else if (alt < w->dist[next]) {
+                w->dist[next] = alt;
+                ok = pq_decrease(w->queue, next, alt);
+            }
+            if (!ok) {
+                w->failed = true;
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * Find shortcuts needed to contract a node.
+ *
+ * @param b             builder
+ * @param w             state of the thread
+ * @param v             index of the node
+ * @param contracting   store the shortcuts in the state of the thread,
+ *                      otherwise they are only counted
+ * @return              number of shortcuts
+ */
+static uint32_t find_shortcuts(const struct builder *b, struct witness *w,
+        uint32_t v, bool contracting)
+{
+    const struct arcs *in = &b->in[v];
+    const struct arcs *out = &b->out[v];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < in->len; i++) {
+        uint32_t u = in->data[i].node;
+        uint32_t to_v = in->data[i].weight;
+        uint32_t limit = 0;
+        bool needed = false;
+        for (uint32_t j = 0; j < out->len; j++) {
+            if (out->data[j].node != u) {
+                needed = true;
+                if (to_v + out->data[j].weight > limit) {
+                    limit = to_v + out->data[j].weight;
+                }
+            }
+        }
+        if (!needed) {
+            continue;
+        }
+        witness_search(b, w, u, v, limit,
+                contracting ? WITNESS_LIMIT : ESTIMATE_LIMIT,
+                contracting ? WITNESS_RELAXED : ESTIMATE_RELAXED, contracting);
+        for (uint32_t j = 0; j < out->len; j++) {
+            uint32_t x = out->data[j].node;
+            uint32_t via = to_v + out->data[j].weight;
+            if (x == u || (w->stamp[x] == w->epoch && w->dist[x] <= via)) {
+                continue;
+            }
+            count++;
+            if (!contracting) {
+                continue;
+            }
+            if (w->len == w->size) {
+                size_t size = w->size ? 2 * w->size : 64;
+                struct shortcut *tmp = realloc(w->shortcuts,
+                        size * sizeof *tmp);
+                if (!tmp) {
+                    w->failed = true;
+                    return count;
+                }
+                w->shortcuts = tmp;
+                w->size = size;
+            }
+            struct shortcut s = { u, x, via, v };
+            w->shortcuts[w->len++] = s;
+        }
+    }
+    return count;
+}
+
+/**
+ * Decide whether a node has few enough edges to be contracted.
+ *
+ * @param b     builder
+ * @param v     index of the node
+ * @return      true if the node may be contracted
+ */
+static bool contractible(const struct builder *b, uint32_t v)
+{
+    return b->in[v].len + b->out[v].len <= CONTRACT_DEGREE;
+}
+
+/**
+ * Recompute priorities of changed nodes in a block, called from the thread
+ * pool.
+ * Priority is the number of shortcuts needed minus the number of edges
+ * removed by contraction, plus the number of already contracted neighbours,
+ * which spreads contraction evenly over the graph.
+ *
+ * @param arg       builder
+ * @param worker    index of the thread
+ * @param task      index of the block
+ */
+static void priority_task(void *arg, size_t worker, size_t task)
+{
+    struct builder *b = arg;
+    uint32_t end = (task + 1) * BLOCK;
+    if (end > b->remaining_num) end = b->remaining_num;
+    for (uint32_t i = task * BLOCK; i < end; i++) {
+        uint32_t v = b->remaining[i];
+        if (b->dirty[v] && !contractible(b, v)) {
+            b->priority[v] = INT32_MAX;
+            b->dirty[v] = false;
+        } else if (b->dirty[v]) {
+            int64_t shortcuts = find_shortcuts(b, &b->workers[worker], v,
+                    false);
+            b->priority[v] = shortcuts - b->in[v].len - b->out[v].len
+                + b->deleted[v];
+            b->dirty[v] = false;
+        }
+    }
+}
+
+/**
+ * Decide whether a node is contracted before another one.
+ * Ties are broken by a hash of the index, which keeps nodes picked in one
+ * round spread over the graph.
+ *
+ * @param b     builder
+ * @param v     index of a node
+ * @param x     index of another node
+ * @return      true if `v` goes first
+ */
+static bool precedes(const struct builder *b, uint32_t v, uint32_t x)
+{
+    if (b->priority[v] != b->priority[x]) {
+        return b->priority[v] < b->priority[x];
+    }
+    return v * 2654435761u < x * 2654435761u;
+}
+
+/**
+ * Select nodes of a block preceding all their neighbours, called from the
+ * thread pool.
+ *
+ * @param arg       builder
+ * @param worker    index of the thread
+ * @param task      index of the block
+ */
+static void select_task(void *arg, size_t worker, size_t task)
+{
+    struct builder *b = arg;
+    (void) worker;
+    uint32_t end = (task + 1) * BLOCK;
+    if (end > b->remaining_num) end = b->remaining_num;
+    for (uint32_t i = task * BLOCK; i < end; i++) {
+        uint32_t v = b->remaining[i];
+        bool first = contractible(b, v);
+        for (uint32_t j = 0; first && j < b->out[v].len; j++) {
+            first = precedes(b, v, b->out[v].data[j].node);
+        }
+        for (uint32_t j = 0; first && j < b->in[v].len; j++) {
+            first = precedes(b, v, b->in[v].data[j].node);
+        }
+        b->selected[v] = first;
+    }
+}
+
+/**
+ * Find shortcuts of selected nodes of a block, called from the thread pool.
+ *
+ * @param arg       builder
+ * @param worker    index of the thread
+ * @param task      index of the block
+ */
+static void contract_task(void *arg, size_t worker, size_t task)
+{
+    struct builder *b = arg;
+    uint32_t end = (task + 1) * BLOCK;
+    if (end > b->remaining_num) end = b->remaining_num;
+    for (uint32_t i = task * BLOCK; i < end; i++) {
+        uint32_t v = b->remaining[i];
+        if (b->selected[v]) {
+            find_shortcuts(b, &b->workers[worker], v, true);
+        }
+    }
+}
+
+/**
+ * Remove a contracted node from lists of its neighbours.
+ *
+ * @param b     builder
+ * @param v     index of the node
+ */
+static void detach(struct builder *b, uint32_t v)
+{
+    for (uint32_t j = 0; j < b->out[v].len; j++) {
+        uint32_t x = b->out[v].data[j].node;
+        arcs_remove(&b->in[x], v);
+        b->deleted[x]++;
+        b->dirty[x] = true;
+    }
+    for (uint32_t j = 0; j < b->in[v].len; j++) {
+        uint32_t x = b->in[v].data[j].node;
+        arcs_remove(&b->out[x], v);
+        b->deleted[x]++;
+        b->dirty[x] = true;
+    }
+    b->edges -= b->out[v].len + b->in[v].len;
+}
+
+/**
+ * Contract all nodes selected in current round.
+ *
+ * @param b         builder
+ * @param next_rank rank of the next contracted node, updated
+ * @return          true if successful, false if memory ran out
+ */
+static bool apply_round(struct builder *b, uint32_t *next_rank)
+{
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < b->remaining_num; i++) {
+        uint32_t v = b->remaining[i];
+        if (b->selected[v]) {
+            b->rank[v] = (*next_rank)++;
+            b->selected[v] = false;
+            detach(b, v);
+        } else {
+            b->remaining[kept++] = v;
+        }
+    }
+    for (size_t t = 0; t < b->workers_num; t++) {
+        struct witness *w = &b->workers[t];
+        for (size_t i = 0; i < w->len; i++) {
+            const struct shortcut *s = &w->shortcuts[i];
+            bool added_out, added_in;
+            if (!arcs_set_min(&b->out[s->from], s->to, s->weight, s->middle,
+                        &added_out)
+                    || !arcs_set_min(&b->in[s->to], s->from, s->weight,
+                        s->middle, &added_in)) {
+                return false;
+            }
+            b->edges += added_out;
+            b->dirty[s->from] = true;
+            b->dirty[s->to] = true;
+        }
+        w->len = 0;
+    }
+    b->remaining_num = kept;
+    return true;
+}
+
+/**
+ * Free a builder.
+ *
+ * @param b     builder to be freed
+ */
+static void builder_free(struct builder *b)
+{
+    for (uint32_t i = 0; b->out && i < b->nodes_num; i++) {
+        free(b->out[i].data);
+    }
+    for (uint32_t i = 0; b->in && i < b->nodes_num; i++) {
+        free(b->in[i].data);
+    }
+    for (size_t t = 0; b->workers && t < b->workers_num; t++) {
+        free(b->workers[t].stamp);
+        free(b->workers[t].dist);
+        free(b->workers[t].target);
+        pq_free(b->workers[t].queue);
+        free(b->workers[t].shortcuts);
+    }
+    free(b->out);
+    free(b->in);
+    free(b->rank);
+    free(b->priority);
+    free(b->deleted);
+    free(b->dirty);
+    free(b->selected);
+    free(b->remaining);
+    free(b->workers);
+}
+
+/**
+ * Prepare a builder for a graph.
+ *
+ * @param b         builder to be initialized
+ * @param csr       frozen graph with reverse edges
+ * @param workers   number of threads
+ * @return          true if successful, false if memory ran out
+ */
+static bool builder_init(struct builder *b, const Csr *csr, size_t workers)
+{
+    memset(b, 0, sizeof *b);
+    size_t n = (size_t) csr->nodes_num + 1;
+    b->nodes_num = csr->nodes_num;
+    b->out = calloc(n, sizeof *b->out);
+    b->in = calloc(n, sizeof *b->in);
+    b->rank = malloc(n * sizeof *b->rank);
+    b->priority = calloc(n, sizeof *b->priority);
+    b->deleted = calloc(n, sizeof *b->deleted);
+    b->dirty = malloc(n * sizeof *b->dirty);
+    b->selected = calloc(n, sizeof *b->selected);
+    b->remaining = malloc(n * sizeof *b->remaining);
+    b->workers = calloc(workers, sizeof *b->workers);
+    b->workers_num = workers;
+    if (!b->out || !b->in || !b->rank || !b->priority || !b->deleted
+            || !b->dirty || !b->selected || !b->remaining || !b->workers) {
+        return false;
+    }
+    for (size_t t = 0; t < workers; t++) {
+        struct witness *w = &b->workers[t];
+        w->stamp = calloc(n, sizeof *w->stamp);
+        w->dist = malloc(n * sizeof *w->dist);
+        w->target = calloc(n, sizeof *w->target);
+        w->queue = pq_new(PQ_BINARY, csr->nodes_num, 0);
+        if (!w->stamp || !w->dist || !w->target || !w->queue) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        b->rank[i] = CSR_NONE;
+        b->dirty[i] = true;
+        b->remaining[i] = i;
+    }
+    b->remaining_num = csr->nodes_num;
+    if (!fill_arcs(b, b->out, csr->offsets, csr->targets, csr->weights)
+            || !fill_arcs(b, b->in, csr->rev_offsets, csr->rev_sources,
+                csr->rev_weights)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        b->edges += b->out[i].len;
+    }
+    return true;
+}
+
+/**
+ * Check whether any thread ran out of memory.
+ *
+ * @param b     builder
+ * @return      true if memory ran out
+ */
+static bool builder_failed(const struct builder *b)
+{
+    for (size_t t = 0; t < b->workers_num; t++) {
+        if (b->workers[t].failed) return true;
+    }
+    return false;
+}
+
+/**
+ * Allocate a hierarchy with uninitialized arrays.
+ *
+ * @param nodes_num     number of nodes
+ * @param edges_num     number of upward edges
+ * @param rev_edges_num number of downward edges
+ * @return              hierarchy or NULL if memory ran out
+ */
+static Hierarchy * ch_new(uint32_t nodes_num, uint32_t edges_num,
+        uint32_t rev_edges_num)
+{
+    Hierarchy *h = calloc(1, sizeof *h);
+    if (!h) return NULL;
+    size_t n = (size_t) nodes_num + 1;
+    Csr *g = &h->graph;
+    g->nodes_num = nodes_num;
+    g->edges_num = edges_num;
+    g->offsets = malloc(n * sizeof *g->offsets);
+    g->targets = malloc(((size_t) edges_num + 1) * sizeof *g->targets);
+    g->weights = malloc(((size_t) edges_num + 1) * sizeof *g->weights);
+    g->rev_offsets = malloc(n * sizeof *g->rev_offsets);
+    g->rev_sources = malloc(((size_t) rev_edges_num + 1)
+            * sizeof *g->rev_sources);
+    g->rev_weights = malloc(((size_t) rev_edges_num + 1)
+            * sizeof *g->rev_weights);
+    h->middle = malloc(((size_t) edges_num + 1) * sizeof *h->middle);
+    h->rev_middle = malloc(((size_t) rev_edges_num + 1)
+            * sizeof *h->rev_middle);
+    h->rank = malloc(n * sizeof *h->rank);
+    if (!g->offsets || !g->targets || !g->weights || !g->rev_offsets
+            || !g->rev_sources || !g->rev_weights || !h->middle
+            || !h->rev_middle || !h->rank) {
+        ch_free(h);
+        return NULL;
+    }
+    return h;
+}
+
+/**
+ * Copy edge lists into arrays of a hierarchy.
+ *
+ * @param lists         edge list of each node
+ * @param nodes_num     number of nodes
+ * @param offsets[out]  first edge of each node
+ * @param ends[out]     node at the other end of each edge
+ * @param weights[out]  weight of each edge
+ * @param middle[out]   node bypassed by each edge
+ */
+static void copy_arcs(const struct arcs *lists, uint32_t nodes_num,
+        uint32_t *offsets, uint32_t *ends, int32_t *weights, uint32_t *middle)
+{
+    uint32_t e = 0;
+    for (uint32_t i = 0; i < nodes_num; i++) {
+        offsets[i] = e;
+        for (uint32_t j = 0; j < lists[i].len; j++, e++) {
+            ends[e] = lists[i].data[j].node;
+            weights[e] = lists[i].data[j].weight;
+            middle[e] = lists[i].data[j].middle;
+        }
+    }
+    offsets[nodes_num] = e;
+}
+
+Hierarchy * ch_build(Csr *csr, Pool *pool)
+{
+    if (!csr || csr->min_weight < 0 || !csr_build_reverse(csr)) return NULL;
+    struct builder b;
+    if (!builder_init(&b, csr, pool_size(pool))) {
+        builder_free(&b);
+        return NULL;
+    }
+    uint32_t next_rank = 0;
+    bool ok = true;
+    bool progress = true;
+    while (ok && progress && b.remaining_num > 0
+            && b.edges < (uint64_t) CORE_DEGREE * b.remaining_num) {
+        size_t blocks = (b.remaining_num + BLOCK - 1) / BLOCK;
+        uint32_t first_rank = next_rank;
+        pool_run(pool, blocks, priority_task, &b);
+        pool_run(pool, blocks, select_task, &b);
+        pool_run(pool, blocks, contract_task, &b);
+        ok = !builder_failed(&b) && apply_round(&b, &next_rank);
+        /* Only nodes with too many edges may be left. */
+        progress = next_rank > first_rank;
+    }
+    /* Nodes of the core keep their edges in both directions. */
+    uint32_t core = b.remaining_num;
+    for (uint32_t i = 0; i < core; i++) {
+        b.rank[b.remaining[i]] = next_rank++;
+    }
+
+    Hierarchy *h = NULL;
+    if (ok) {
+        uint64_t edges = 0;
+        uint64_t rev_edges = 0;
+        for (uint32_t i = 0; i < b.nodes_num; i++) {
+            edges += b.out[i].len;
+            rev_edges += b.in[i].len;
+        }
+        if (edges < UINT32_MAX && rev_edges < UINT32_MAX) {
+            h = ch_new(b.nodes_num, edges, rev_edges);
+        }
+    }
+    if (h) {
+        Csr *g = &h->graph;
+        copy_arcs(b.out, b.nodes_num, g->offsets, g->targets, g->weights,
+                h->middle);
+        copy_arcs(b.in, b.nodes_num, g->rev_offsets, g->rev_sources,
+                g->rev_weights, h->rev_middle);
+        memcpy(h->rank, b.rank, (size_t) b.nodes_num * sizeof *h->rank);
+        g->ids = csr->ids;
+        h->core = core;
+        if (!csr_compute_weight_stats(g)) {
+            ch_free(h);
+            h = NULL;
+        }
+    }
+    builder_free(&b);
+    return h;
+}
+
+/** Magic bytes identifying a hierarchy file */
+static const char CH_MAGIC[8] = "DIMEHIER";
+
+/** Number of arrays stored in a hierarchy file */
+#define CH_SECTIONS 9
+
+/** Header of a hierarchy file. */
+struct ch_header {
+    /** Always `CH_MAGIC` */
+    char magic[8];
+    /** Format version */
+    uint32_t version;
+    /** Always `BINFILE_BYTE_ORDER` in byte order of the writer */
+    uint32_t byte_order;
+    /** Number of nodes */
+    uint32_t nodes_num;
+    /** Number of upward edges */
+    uint32_t edges_num;
+    /** Number of downward edges */
+    uint32_t rev_edges_num;
+    /** Number of uncontracted nodes */
+    uint32_t core;
+    /** Statistics of weights of upward edges, see struct csr */
+    int32_t min_weight;
+    int32_t max_weight;
+    int32_t typical_weight;
+    /** Always zero */
+    int32_t reserved;
+    /** Checksum of the graph, see binfile_graph_checksum() */
+    uint64_t graph_checksum;
+    /** File positions of arrays `offsets`, `targets`, `weights`, `middle`,
+     * `rev_offsets`, `rev_sources`, `rev_weights`, `rev_middle` and
+     * `rank` */
+    uint64_t pos[CH_SECTIONS];
+    /** Total size of the file */
+    uint64_t file_size;
+    /** Checksum of everything after the header */
+    uint64_t data_checksum;
+    /** Checksum of the header with this member set to zero */
+    uint64_t header_checksum;
+};
+
+/**
+ * Get sizes of arrays stored in a hierarchy file.
+ *
+ * @param hdr       header with numbers of nodes and edges filled in
+ * @param lens[out] size of each array in bytes
+ */
+static void section_sizes(const struct ch_header *hdr,
+        uint64_t lens[CH_SECTIONS])
+{
+    uint64_t nodes = hdr->nodes_num;
+    uint64_t edges = hdr->edges_num;
+    uint64_t rev_edges = hdr->rev_edges_num;
+    uint64_t sizes[CH_SECTIONS] = {
+        (nodes + 1) * 4, edges * 4, edges * 4, edges * 4,
+        (nodes + 1) * 4, rev_edges * 4, rev_edges * 4, rev_edges * 4,
+        nodes * 4,
+    };
+    memcpy(lens, sizes, sizeof sizes);
+}
+
+/**
+ * Compute checksum of the header.
+ *
+ * @param hdr   header to be hashed
+ * @return      checksum
+ */
+static uint64_t header_checksum(const struct ch_header *hdr)
+{
+    struct ch_header tmp = *hdr;
+    tmp.header_checksum = 0;
+    return binfile_checksum(BINFILE_CHECKSUM_INIT, &tmp, sizeof tmp);
+}
+
+bool ch_save(const Hierarchy *h, const Csr *csr, const char *path)
+{
+    if (!h || !csr || !path || h->graph.nodes_num != csr->nodes_num) {
+        return false;
+    }
+    const Csr *g = &h->graph;
+    struct ch_header hdr;
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, CH_MAGIC, sizeof hdr.magic);
+    hdr.version = CH_VERSION;
+    hdr.byte_order = BINFILE_BYTE_ORDER;
+    hdr.nodes_num = g->nodes_num;
+    hdr.edges_num = g->edges_num;
+    hdr.rev_edges_num = g->rev_offsets[g->nodes_num];
+    hdr.core = h->core;
+    hdr.min_weight = g->min_weight;
+    hdr.max_weight = g->max_weight;
+    hdr.typical_weight = g->typical_weight;
+    hdr.graph_checksum = csr->checksum;
+
+    const void *data[CH_SECTIONS] = { g->offsets, g->targets, g->weights,
+        h->middle, g->rev_offsets, g->rev_sources, g->rev_weights,
+        h->rev_middle, h->rank };
+    uint64_t lens[CH_SECTIONS];
+    section_sizes(&hdr, lens);
+    uint64_t at = binfile_align(sizeof hdr);
+    for (int i = 0; i < CH_SECTIONS; i++) {
+        hdr.pos[i] = at;
+        at += binfile_align(lens[i]);
+    }
+    hdr.file_size = at;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    /* Header is written twice, the second time with checksums filled in. */
+    bool ok = binfile_write_section(f, &hdr, sizeof hdr, NULL);
+    hdr.data_checksum = BINFILE_CHECKSUM_INIT;
+    for (int i = 0; ok && i < CH_SECTIONS; i++) {
+        ok = binfile_write_section(f, data[i], lens[i], &hdr.data_checksum);
+    }
+    hdr.header_checksum = header_checksum(&hdr);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0
+        && fwrite(&hdr, sizeof hdr, 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+/**
+ * Check header of a mapped hierarchy file.
+ *
+ * @param hdr   header of the file
+ * @param size  real size of the file
+ * @param csr   graph the hierarchy should belong to
+ * @return      true if the header describes a usable hierarchy
+ */
+static bool header_valid(const struct ch_header *hdr, size_t size,
+        const Csr *csr)
+{
+    if (memcmp(hdr->magic, CH_MAGIC, sizeof hdr->magic) != 0
+            || hdr->byte_order != BINFILE_BYTE_ORDER
+            || hdr->version != CH_VERSION
+            || hdr->header_checksum != header_checksum(hdr)
+            || hdr->file_size != size
+            || !binfile_graph_matches(csr, hdr->nodes_num,
+                hdr->graph_checksum)
+            || hdr->edges_num == UINT32_MAX
+            || hdr->rev_edges_num == UINT32_MAX) {
+        return false;
+    }
+    uint64_t lens[CH_SECTIONS];
+    section_sizes(hdr, lens);
+    for (int i = 0; i < CH_SECTIONS; i++) {
+        if (!binfile_section_valid(sizeof *hdr, size, hdr->pos[i], lens[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Hierarchy * ch_open(const Csr *csr, const char *path, bool verify)
+{
+    if (!csr) return NULL;
+    size_t size;
+    void *map = binfile_map(path, sizeof(struct ch_header), &size);
+    if (!map) return NULL;
+    const struct ch_header *hdr = map;
+    const char *base = map;
+    size_t data_pos = binfile_align(sizeof *hdr);
+    if (!header_valid(hdr, size, csr) || (verify && hdr->data_checksum
+                != binfile_checksum(BINFILE_CHECKSUM_INIT, base + data_pos,
+                    size - data_pos))) {
+        munmap(map, size);
+        return NULL;
+    }
+    Hierarchy *h = calloc(1, sizeof *h);
+    if (!h) {
+        munmap(map, size);
+        return NULL;
+    }
+    h->map = map;
+    h->map_size = size;
+    h->core = hdr->core;
+    Csr *g = &h->graph;
+    g->nodes_num = hdr->nodes_num;
+    g->edges_num = hdr->edges_num;
+    g->min_weight = hdr->min_weight;
+    g->max_weight = hdr->max_weight;
+    g->typical_weight = hdr->typical_weight;
+    g->ids = csr->ids;
+    /* The mapping is read-only, see snapshot_open(). */
+    g->offsets = (uint32_t *) (base + hdr->pos[0]);
+    g->targets = (uint32_t *) (base + hdr->pos[1]);
+    g->weights = (int32_t *) (base + hdr->pos[2]);
+    h->middle = (uint32_t *) (base + hdr->pos[3]);
+    g->rev_offsets = (uint32_t *) (base + hdr->pos[4]);
+    g->rev_sources = (uint32_t *) (base + hdr->pos[5]);
+    g->rev_weights = (int32_t *) (base + hdr->pos[6]);
+    h->rev_middle = (uint32_t *) (base + hdr->pos[7]);
+    h->rank = (uint32_t *) (base + hdr->pos[8]);
+    if (g->offsets[g->nodes_num] != hdr->edges_num
+            || g->rev_offsets[g->nodes_num] != hdr->rev_edges_num) {
+        ch_free(h);
+        return NULL;
+    }
+    return h;
+}
+
+/**
+ * Find an edge of the hierarchy.
+ * Each edge is stored at its endpoint of lower rank, edges between core
+ * nodes at both endpoints.
+ *
+ * @param h             hierarchy
+ * @param from          index of source node
+ * @param to            index of destination node
+ * @param weight[out]   weight of the edge
+ * @param middle[out]   node bypassed by the edge
+ * @return              true if the edge exists
+ */
+static bool find_edge(const Hierarchy *h, uint32_t from, uint32_t to,
+        uint32_t *weight, uint32_t *middle)
+{
+    const Csr *g = &h->graph;
+    if (h->rank[from] < h->rank[to]) {
+        for (uint32_t e = g->offsets[from]; e < g->offsets[from + 1]; e++) {
+            if (g->targets[e] == to) {
+                *weight = g->weights[e];
+                *middle = h->middle[e];
+                return true;
+            }
+        }
+    } else {
+        for (uint32_t e = g->rev_offsets[to]; e < g->rev_offsets[to + 1];
+                e++) {
+            if (g->rev_sources[e] == from) {
+                *weight = g->rev_weights[e];
+                *middle = h->rev_middle[e];
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/** Growing arrays used while unpacking a path. */
+struct unpacked {
+    /** Nodes of the path and their distances from its first node */
+    uint32_t *nodes;
+    uint32_t *dists;
+    size_t len;
+    size_t size;
+    /** Edges waiting to be unpacked, pairs of nodes */
+    uint32_t *stack;
+    size_t depth;
+    size_t stack_size;
+};
+
+/**
+ * Append a node to an unpacked path.
+ *
+ * @param u         state of unpacking
+ * @param node      index of the node
+ * @param weight    weight of the edge leading to the node
+ * @return          true if successful, false if memory ran out
+ */
+static bool append_node(struct unpacked *u, uint32_t node, uint32_t weight)
+{
+    if (u->len == u->size) {
+        size_t size = u->size ? 2 * u->size : 64;
+        uint32_t *nodes = realloc(u->nodes, size * sizeof *nodes);
+        if (!nodes) return false;
+        u->nodes = nodes;
+        uint32_t *dists = realloc(u->dists, size * sizeof *dists);
+        if (!dists) return false;
+        u->dists = dists;
+        u->size = size;
+    }
+    u->nodes[u->len] = node;
+    u->dists[u->len] = u->len > 0 ? u->dists[u->len - 1] + weight : 0;
+    u->len++;
+    return true;
+}
+
+/**
+ * Push an edge waiting to be unpacked.
+ *
+ * @param u     state of unpacking
+ * @param from  index of source node
+ * @param to    index of destination node
+ * @return      true if successful, false if memory ran out
+ */
+static bool push_edge(struct unpacked *u, uint32_t from, uint32_t to)
+{
+    if (u->depth + 2 > u->stack_size) {
+        size_t size = u->stack_size ? 2 * u->stack_size : 64;
+        uint32_t *tmp = realloc(u->stack, size * sizeof *tmp);
+        if (!tmp) return false;
+        u->stack = tmp;
+        u->stack_size = size;
+    }
+    u->stack[u->depth++] = from;
+    u->stack[u->depth++] = to;
+    return true;
+}
+
+/**
+ * Unpack an edge of the hierarchy and append its original edges to a path.
+ *
+ * @param h     hierarchy
+ * @param u     state of unpacking
+ * @param from  index of source node
+ * @param to    index of destination node
+ * @return      true if successful, false if memory ran out
+ */
+static bool unpack_edge(const Hierarchy *h, struct unpacked *u, uint32_t from,
+        uint32_t to)
+{
+    if (!push_edge(u, from, to)) return false;
+    while (u->depth > 0) {
+        uint32_t b = u->stack[--u->depth];
+        uint32_t a = u->stack[--u->depth];
+        uint32_t weight, middle;
+        if (!find_edge(h, a, b, &weight, &middle)) {
+            return false;
+        }
+        /* The second half of a shortcut is pushed first to be unpacked
+         * last. */
+        if (middle == CSR_NONE) {
+            if (!append_node(u, b, weight)) return false;
+        } else if (!push_edge(u, middle, b) || !push_edge(u, a, middle)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ch_run(Search *s, const Hierarchy *h, uint32_t source,
+        uint32_t destination)
+{
+    if (!s || !h || !search_run_upward(s, source, destination, h->rank,
+                h->graph.nodes_num - h->core)) {
+        return false;
+    }
+    /* Nodes of the path in the hierarchy, collected from the destination. */
+    size_t hops = 0;
+    for (uint32_t n = destination; n != source; n = search_previous(s, n)) {
+        hops++;
+    }
+    uint32_t *path = malloc((hops + 1) * sizeof *path);
+    if (!path) return false;
+    size_t i = hops;
+    for (uint32_t n = destination; n != source; n = search_previous(s, n)) {
+        path[i--] = n;
+    }
+    path[0] = source;
+
+    struct unpacked u;
+    memset(&u, 0, sizeof u);
+    bool ok = append_node(&u, source, 0);
+    for (i = 0; ok && i < hops; i++) {
+        ok = unpack_edge(h, &u, path[i], path[i + 1]);
+    }
+    ok = ok && search_set_path(s, u.nodes, u.dists, u.len);
+    free(path);
+    free(u.nodes);
+    free(u.dists);
+    free(u.stack);
+    return ok;
+}
+
+void ch_free(Hierarchy *h)
+{
+    if (h) {
+        if (h->map) {
+            munmap(h->map, h->map_size);
+        } else {
+            free(h->graph.offsets);
+            free(h->graph.targets);
+            free(h->graph.weights);
+            free(h->graph.rev_offsets);
+            free(h->graph.rev_sources);
+            free(h->graph.rev_weights);
+            free(h->middle);
+            free(h->rev_middle);
+            free(h->rank);
+        }
+    }
+    free(h);
+}
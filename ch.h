@@ -0,0 +1,123 @@
+/**
+ * Interface for contraction hierarchies.
+ *
+ * Nodes are contracted one by one in order of their importance. Contracting
+ * a node removes it from the graph and inserts a shortcut between each pair
+ * of its neighbours whose shortest path led through it, unless a witness
+ * search finds another path that is not longer. The order in which nodes
+ * were contracted is their rank.
+ *
+ * Every shortest path then consists of edges leading to nodes of higher rank
+ * (upward edges) followed by edges leading to nodes of lower rank (downward
+ * edges). Queries search upward from both ends of the path and finish a tiny
+ * part of the graph. Shortcuts on the found path are unpacked back into
+ * original edges.
+ *
+ * Contraction may stop before all nodes are contracted, if the remaining
+ * graph (the core) becomes too dense for witness searches to be useful. Edges
+ * between core nodes are both upward and downward ones.
+ *
+ * Hierarchies are only built for graphs without negative edge weights.
+ *
+ * @file    ch.h
+ */
+#ifndef CH_H
+#define CH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pool.h"
+#include "search.h"
+
+/** Version of the hierarchy file format written by this program. */
+#define CH_VERSION 1
+
+/** Contraction hierarchy of a graph. */
+typedef struct hierarchy Hierarchy;
+
+/**
+ * Representation of a contraction hierarchy.
+ *
+ * Member `graph` holds upward edges of each node as its edges and downward
+ * edges leading to each node as its reverse edges. Each edge is stored only
+ * at its endpoint of lower rank. Identifiers of nodes are shared with the
+ * original graph, which must outlive the hierarchy.
+ */
+struct hierarchy {
+    /** Upward and downward edges, searched by search_run_upward() */
+    Csr graph;
+    /** Node bypassed by each upward edge, `CSR_NONE` for original edges */
+    uint32_t *middle;
+    /** Node bypassed by each downward edge, `CSR_NONE` for original edges */
+    uint32_t *rev_middle;
+    /** Rank of each node */
+    uint32_t *rank;
+    /** Number of nodes left uncontracted */
+    uint32_t core;
+    /** Memory mapping holding the arrays, NULL if they were allocated */
+    void *map;
+    /** Size of the memory mapping */
+    size_t map_size;
+};
+
+/**
+ * Build a contraction hierarchy.
+ * Reverse edges of the graph are built if they do not exist yet.
+ *
+ * @param csr   frozen graph without negative edge weights
+ * @param pool  threads running witness searches, may be NULL
+ * @return      hierarchy or NULL if memory ran out or the graph has
+ *              negative weights
+ */
+Hierarchy * ch_build(Csr *csr, Pool *pool);
+
+/**
+ * Write a hierarchy into a file.
+ * The file records checksum of the graph and can only be opened with the
+ * same graph. Existing file is overwritten.
+ *
+ * @param h     hierarchy to be stored
+ * @param csr   graph the hierarchy was built for
+ * @param path  name of the file
+ * @return      true if successful, false otherwise
+ */
+bool ch_save(const Hierarchy *h, const Csr *csr, const char *path);
+
+/**
+ * Open a hierarchy file.
+ * The file is mapped read-only into memory.
+ *
+ * @param csr       graph the hierarchy was built for
+ * @param path      name of the file
+ * @param verify    whether to verify checksum of the data
+ * @return          hierarchy or NULL if the file does not exist, is damaged
+ *                  or belongs to a different graph
+ */
+Hierarchy * ch_open(const Csr *csr, const char *path, bool verify);
+
+/**
+ * Find shortest path between two nodes using a hierarchy.
+ * The path is unpacked into original edges and reported as after
+ * search_run().
+ *
+ * @param s             context created for `graph` of the hierarchy
+ * @param h             hierarchy
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool ch_run(Search *s, const Hierarchy *h, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Free a hierarchy.
+ *
+ * @param h     hierarchy to be freed
+ */
+void ch_free(Hierarchy *h);
+
+#endif /* end of include guard: CH_H */
@@ -0,0 +1,183 @@
+/**
+ * Functions for working with frozen graphs.
+ *
+ * @file    csr.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "csr.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+
+Csr * csr_new(uint32_t nodes_num, uint32_t edges_num)
+{
+    Csr *csr = calloc(1, sizeof *csr);
+    if (!csr) return NULL;
+    csr->nodes_num = nodes_num;
+    csr->edges_num = edges_num;
+    csr->offsets = malloc(((size_t) nodes_num + 1) * sizeof *csr->offsets);
+    csr->targets = malloc(((size_t) edges_num + 1) * sizeof *csr->targets);
+    csr->weights = malloc(((size_t) edges_num + 1) * sizeof *csr->weights);
+    csr->ids = malloc(((size_t) nodes_num + 1) * sizeof *csr->ids);
+    if (!csr->offsets || !csr->targets || !csr->weights || !csr->ids) {
+        csr_free(csr);
+        return NULL;
+    }
+    return csr;
+}
+
+/** Weights up to this value are counted exactly when looking for the typical
+ * weight; larger ones are only counted as large. */
+#define WEIGHT_HISTOGRAM_SIZE 65536
+
+bool csr_compute_weight_stats(Csr *csr)
+{
+    if (!csr) return false;
+    csr->min_weight = 0;
+    csr->max_weight = 0;
+    csr->typical_weight = 0;
+    if (csr->edges_num == 0) return true;
+
+    uint32_t *histogram = calloc(WEIGHT_HISTOGRAM_SIZE, sizeof *histogram);
+    if (!histogram) return false;
+    int32_t min = csr->weights[0];
+    int32_t max = csr->weights[0];
+    uint64_t seen = 0;          /* Number of weights up to current one. */
+    for (uint32_t e = 0; e < csr->edges_num; e++) {
+        int32_t w = csr->weights[e];
+        if (w < min) min = w;
+        if (w > max) max = w;
+        if (w < 0) {
+            seen++;
+        } else if (w < WEIGHT_HISTOGRAM_SIZE) {
+            histogram[w]++;
+        }
+    }
+    csr->min_weight = min;
+    csr->max_weight = max;
+
+    uint64_t needed = ((uint64_t) csr->edges_num * 999 + 999) / 1000;
+    csr->typical_weight = max;
+    for (int32_t w = 0; w < WEIGHT_HISTOGRAM_SIZE && w <= max; w++) {
+        seen += histogram[w];
+        if (seen >= needed) {
+            csr->typical_weight = w;
+            break;
+        }
+    }
+    free(histogram);
+    return true;
+}
+
+bool csr_build_reverse(Csr *csr)
+{
+    if (!csr) return false;
+    if (csr->rev_offsets) return true;
+    uint32_t *offsets = calloc((size_t) csr->nodes_num + 1, sizeof *offsets);
+    uint32_t *sources = malloc(((size_t) csr->edges_num + 1) * sizeof *sources);
+    int32_t *weights = malloc(((size_t) csr->edges_num + 1) * sizeof *weights);
+    if (!offsets || !sources || !weights) {
+        free(offsets);
+        free(sources);
+        free(weights);
+        return false;
+    }
+    /* Counting sort of edges by their destination. Each node's count is
+     * first kept at the position of the following node, prefix sums then
+     * turn counts into the first free position of each node. */
+    for (uint32_t e = 0; e < csr->edges_num; e++) {
+        offsets[csr->targets[e] + 1]++;
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        for (uint32_t e = csr->offsets[i]; e < csr->offsets[i + 1]; e++) {
+            uint32_t pos = offsets[csr->targets[e]]++;
+            sources[pos] = i;
+            weights[pos] = csr->weights[e];
+        }
+    }
+    /* Every position now points to the start of the next node. */
+    for (uint32_t i = csr->nodes_num; i > 0; i--) {
+        offsets[i] = offsets[i - 1];
+    }
+    offsets[0] = 0;
+    csr->rev_offsets = offsets;
+    csr->rev_sources = sources;
+    csr->rev_weights = weights;
+    return true;
+}
+
+bool csr_build_idmap(Csr *csr)
+{
+    if (!csr) return false;
+    if (!csr->idmap) {
+        csr->idmap = idmap_new(csr->ids, csr->nodes_num);
+    }
+    return csr->idmap != NULL;
+}
+
+uint32_t csr_find(const Csr *csr, unsigned int id)
+{
+    if (!csr) return CSR_NONE;
+    if (csr->idmap) return idmap_find(csr->idmap, id);
+    if (csr->reordered) {
+        for (uint32_t i = 0; i < csr->nodes_num; i++) {
+            if (csr->ids[i] == id) return i;
+        }
+        return CSR_NONE;
+    }
+    size_t low = 0;
+    size_t high = csr->nodes_num;
+    while (high > low) {
+        size_t mid = (low + high) / 2;
+        if (id == csr->ids[mid]) {
+            return mid;
+        } else if (id < csr->ids[mid]) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return CSR_NONE;
+}
+
+size_t csr_edge_memory(const Csr *csr)
+{
+    if (!csr) return 0;
+    return ((size_t) csr->nodes_num + 1) * sizeof *csr->offsets
+        + (size_t) csr->edges_num * (sizeof *csr->targets
+                + sizeof *csr->weights);
+}
+
+void csr_release_edges(Csr *csr)
+{
+    if (!csr) return;
+    if (!csr->map) {
+        free(csr->targets);
+        free(csr->weights);
+    }
+    csr->targets = NULL;
+    csr->weights = NULL;
+}
+
+void csr_free(Csr *csr)
+{
+    if (csr) {
+        if (csr->map) {
+            munmap(csr->map, csr->map_size);
+        } else {
+            free(csr->offsets);
+            free(csr->targets);
+            free(csr->weights);
+            free(csr->ids);
+        }
+        free(csr->rev_offsets);
+        free(csr->rev_sources);
+        free(csr->rev_weights);
+        idmap_free(csr->idmap);
+    }
+    free(csr);
+}
@@ -0,0 +1,151 @@
+/**
+ * Interface for working with frozen graphs.
+ *
+ * A frozen graph stores all nodes and edges in a few contiguous arrays
+ * (compressed sparse row layout). Nodes are identified by a dense index in
+ * range `[0, nodes_num)`, outgoing edges of node `i` occupy positions
+ * `offsets[i]` to `offsets[i + 1] - 1` of the `targets` and `weights` arrays.
+ *
+ * Incoming edges can be stored the same way in the optional reverse arrays,
+ * which are needed by searches running backward from the destination.
+ *
+ * @file    csr.h
+ */
+#ifndef CSR_H
+#define CSR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "graph.h"
+#include "idmap.h"
+
+/** Value returned by csr_find() for nonexistent nodes. */
+#define CSR_NONE UINT32_MAX
+
+/**
+ * Representation of a frozen graph.
+ *
+ * Members can be read directly, which is what search code is expected to
+ * do. Do not modify them. The structure holds no search state, so any number
+ * of searches (see search.h) may run over it at the same time.
+ */
+struct csr {
+    /** Number of nodes */
+    uint32_t nodes_num;
+    /** Number of edges */
+    uint32_t edges_num;
+    /** Index of the first outgoing edge of each node. This array has
+     * `nodes_num + 1` elements, the last one is equal to `edges_num`. */
+    uint32_t *offsets;
+    /** Dense index of destination node of each edge */
+    uint32_t *targets;
+    /** Minimum delay of each edge */
+    int32_t *weights;
+    /** Identifier of each node, sorted in ascending order unless the graph
+     * is reordered */
+    uint32_t *ids;
+    /** Minimum edge weight, zero for graphs without edges */
+    int32_t min_weight;
+    /** Maximum edge weight, zero for graphs without edges */
+    int32_t max_weight;
+    /** Weight not exceeded by 99.9 % of edges. Edges above it are considered
+     * outliers by bucket based priority queues. */
+    int32_t typical_weight;
+    /** Index of the first incoming edge of each node, NULL if reverse edges
+     * were not built. This array has `nodes_num + 1` elements. */
+    uint32_t *rev_offsets;
+    /** Dense index of source node of each incoming edge */
+    uint32_t *rev_sources;
+    /** Minimum delay of each incoming edge */
+    int32_t *rev_weights;
+    /** Map from identifiers to indices of nodes, NULL if it was not built */
+    Idmap *idmap;
+    /** Whether nodes were renumbered by reorder_apply(), such graphs always
+     * have the map of identifiers */
+    bool reordered;
+    /** Checksum of nodes and edges identifying the graph for precomputed
+     * indices, see binfile_graph_checksum() */
+    uint64_t checksum;
+    /** Memory mapping holding the arrays, NULL if they were allocated */
+    void *map;
+    /** Size of the memory mapping */
+    size_t map_size;
+};
+
+/**
+ * Create a new frozen graph with uninitialized arrays of given size.
+ *
+ * @param nodes_num number of nodes
+ * @param edges_num number of edges
+ * @return          new frozen graph or NULL if memory is exhausted
+ */
+Csr * csr_new(uint32_t nodes_num, uint32_t edges_num);
+
+/**
+ * Compute statistics of edge weights.
+ * This fills in members `min_weight`, `max_weight` and `typical_weight` and
+ * needs to be called whenever weights are set.
+ *
+ * @param csr   frozen graph with weights filled in
+ * @return      true if successful, false if memory ran out
+ */
+bool csr_compute_weight_stats(Csr *csr);
+
+/**
+ * Build arrays of incoming edges.
+ * Nothing is done if they already exist. The arrays are always allocated, even
+ * if the rest of the graph is mapped from a snapshot.
+ *
+ * @param csr   frozen graph
+ * @return      true if successful, false if memory ran out
+ */
+bool csr_build_reverse(Csr *csr);
+
+/**
+ * Build map from identifiers to indices of nodes, which makes csr_find()
+ * take constant time.
+ * Nothing is done if the map already exists.
+ *
+ * @param csr   frozen graph
+ * @return      true if successful, false if memory ran out
+ */
+bool csr_build_idmap(Csr *csr);
+
+/**
+ * Find dense index of a node with given id.
+ * Without the map built by csr_build_idmap() this is a binary search, or a
+ * linear one in a reordered graph.
+ *
+ * @param csr   frozen graph to search
+ * @param id    identifier of the node
+ * @return      index of the node or `CSR_NONE` if there is no such node
+ */
+uint32_t csr_find(const Csr *csr, unsigned int id);
+
+/**
+ * Get memory taken by outgoing edges of a frozen graph.
+ *
+ * @param csr   frozen graph
+ * @return      size of arrays `offsets`, `targets` and `weights` in bytes
+ */
+size_t csr_edge_memory(const Csr *csr);
+
+/**
+ * Free arrays of outgoing edges when they are searched in another form,
+ * see packed.h. Arrays mapped from a snapshot are only forgotten. Functions
+ * reading `targets` or `weights` must not be used with the graph afterwards.
+ *
+ * @param csr   frozen graph
+ */
+void csr_release_edges(Csr *csr);
+
+/**
+ * Free memory used by a frozen graph.
+ *
+ * @param csr   frozen graph to be freed
+ */
+void csr_free(Csr *csr);
+
+#endif /* end of include guard: CSR_H */
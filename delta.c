@@ -0,0 +1,515 @@
+/**
+ * Functions for parallel delta-stepping.
+ *
+ * Tentative distance and previous node of each node are packed into a
+ * single 64-bit label with the distance in the upper half, so that both are
+ * replaced at once by a compare-and-swap, which only succeeds for strictly
+ * shorter distances. Other threads thus always see a consistent pair.
+ *
+ * Every worker inserts reached nodes into its own buckets, so insertion
+ * needs no locking. Buckets of a worker form a ring covering the current
+ * bucket and a fixed number of following ones; nodes farther ahead wait in a
+ * separate list until the ring reaches them. A node may be inserted several
+ * times, entries whose distance no longer falls into their bucket are
+ * skipped.
+ *
+ * @file    delta.c
+ */
+#include "delta.h"
+#include "stats.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Upper limit of number of buckets in the ring of each worker */
+#define MAX_RING 4096
+/** Number of nodes processed by one task */
+#define BLOCK 256
+/** Number of nodes reset by one task */
+#define RESET_BLOCK 65536
+/** Steps with fewer nodes are run by the calling thread alone, waking up
+ * other workers would take longer. */
+#define PARALLEL_MIN 1024
+
+/** Label of unreached nodes, infinite distance and no previous node */
+#define UNREACHED UINT64_MAX
+
+/** Growing list of nodes. */
+struct list {
+    uint32_t *data;
+    size_t len;
+    size_t size;
+};
+
+/** Buckets of one worker. */
+struct bins {
+    /** Bucket `i` is kept at position `i % ring_size` */
+    struct list *ring;
+    /** Number of entries in all buckets of the ring */
+    size_t ring_len;
+    /** Nodes in buckets beyond the ring */
+    struct list far;
+    /** Lowest bucket of a node in `far` */
+    uint32_t far_min;
+    /** Nodes taken from the current bucket, whose heavy edges are relaxed
+     * once the bucket stays empty */
+    struct list removed;
+    /** Set when memory ran out */
+    bool failed;
+#ifdef GRAPH_STATS
+    /** Work of the worker not yet added to the totals */
+    uint64_t counts[STATS_COUNTERS];
+#endif
+};
+
+struct delta {
+    /** Searched graph */
+    const Csr *csr;
+    /** Threads running the search */
+    Pool *pool;
+    /** Width of buckets */
+    uint32_t width;
+    /** Copy of targets of edges with light edges of each node first */
+    uint32_t *targets;
+    /** Copy of weights of edges in the same order */
+    int32_t *weights;
+    /** End of light edges of each node */
+    uint32_t *light_end;
+    /** Distance (upper half) and previous node (lower half) of each node */
+    uint64_t *label;
+    /** Round in which each node was last expanded */
+    uint32_t *expanded;
+    /** Nodes processed by current step */
+    struct list frontier;
+    /** Number of buckets in the ring of each worker, a power of two */
+    uint32_t ring_size;
+    /** Number of workers */
+    size_t workers;
+    /** Buckets of each worker */
+    struct bins *bins;
+    /** Current bucket */
+    uint32_t current;
+    /** Current round of relaxing light edges */
+    uint32_t round;
+    /** First round of current bucket */
+    uint32_t bucket_round;
+};
+
+/**
+ * Append a node to a list.
+ *
+ * @param l     list to append to
+ * @param node  index of the node
+ * @return      true if successful, false if memory ran out
+ */
+static bool list_push(struct list *l, uint32_t node)
+{
+    if (l->len == l->size) {
+        size_t size = l->size ? 2 * l->size : 64;
+        uint32_t *tmp = realloc(l->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        l->data = tmp;
+        l->size = size;
+    }
+    l->data[l->len++] = node;
+    return true;
+}
+
+/**
+ * Move all nodes of a list to the end of another one.
+ *
+ * @param to    list to append to
+ * @param from  list to be emptied
+ * @return      true if successful, false if memory ran out
+ */
+static bool list_move(struct list *to, struct list *from)
+{
+    if (to->len + from->len > to->size) {
+        size_t size = to->size ? to->size : 64;
+        while (size < to->len + from->len) {
+            size *= 2;
+        }
+        uint32_t *tmp = realloc(to->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        to->data = tmp;
+        to->size = size;
+    }
+    if (from->len > 0) {
+        memcpy(to->data + to->len, from->data, from->len * sizeof *from->data);
+    }
+    to->len += from->len;
+    from->len = 0;
+    return true;
+}
+
+uint32_t delta_auto_width(const Csr *csr)
+{
+    if (!csr || csr->edges_num == 0 || csr->typical_weight <= 0) return 1;
+    /* Typical weight divided by average degree. */
+    uint64_t width = (uint64_t) csr->typical_weight * csr->nodes_num
+        / csr->edges_num;
+    return width > 0 ? width : 1;
+}
+
+/**
+ * Put a node into the bucket of a worker.
+ *
+ * @param d         context
+ * @param b         buckets of the worker
+ * @param node      index of the node
+ * @param bucket    bucket of the node, not lower than the current one
+ */
+static void insert(struct delta *d, struct bins *b, uint32_t node,
+        uint32_t bucket)
+{
+    if (bucket - d->current < d->ring_size) {
+        if (list_push(&b->ring[bucket & (d->ring_size - 1)], node)) {
+            b->ring_len++;
+        } else {
+            b->failed = true;
+        }
+    } else {
+        b->failed |= !list_push(&b->far, node);
+        if (bucket < b->far_min) {
+            b->far_min = bucket;
+        }
+    }
+}
+
+/**
+ * Offer a new distance to a node.
+ *
+ * @param d     context
+ * @param b     buckets of the worker
+ * @param node  index of the node
+ * @param dist  offered distance
+ * @param from  node through which the node is reached
+ */
+static inline void offer(struct delta *d, struct bins *b, uint32_t node,
+        uint64_t dist, uint32_t from)
+{
+    STATS_ADD(b->counts, STATS_RELAXATIONS, 1);
+    if (dist >= UINT32_MAX) return;
+    uint64_t wanted = dist << 32 | from;
+    uint64_t label = __atomic_load_n(&d->label[node], __ATOMIC_RELAXED);
+    while (dist < label >> 32) {
+        if (__atomic_compare_exchange_n(&d->label[node], &label, wanted, true,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            insert(d, b, node, dist / d->width);
+            return;
+        }
+    }
+}
+
+/**
+ * Reset labels of a block of nodes.
+ * This is a pool_task taking the context as its argument.
+ */
+static void reset_task(void *arg, size_t worker, size_t task)
+{
+    (void) worker;
+    struct delta *d = arg;
+    size_t first = task * RESET_BLOCK;
+    size_t end = first + RESET_BLOCK;
+    if (end > d->csr->nodes_num) end = d->csr->nodes_num;
+    for (size_t i = first; i < end; i++) {
+        d->label[i] = UNREACHED;
+        d->expanded[i] = 0;
+    }
+}
+
+/**
+ * Relax light edges of a block of frontier nodes.
+ * This is a pool_task taking the context as its argument.
+ */
+static void light_task(void *arg, size_t worker, size_t task)
+{
+    struct delta *d = arg;
+    struct bins *b = &d->bins[worker];
+    const uint32_t *offsets = d->csr->offsets;
+    size_t end = (task + 1) * BLOCK;
+    if (end > d->frontier.len) end = d->frontier.len;
+    for (size_t i = task * BLOCK; i < end; i++) {
+        uint32_t u = d->frontier.data[i];
+        uint64_t dist = __atomic_load_n(&d->label[u], __ATOMIC_RELAXED) >> 32;
+        if (dist / d->width != d->current) {
+            continue;           /* Stale entry, the node moved elsewhere. */
+        }
+        uint32_t last = __atomic_exchange_n(&d->expanded[u], d->round,
+                __ATOMIC_RELAXED);
+        if (last == d->round) {
+            continue;           /* Duplicate entry in this round. */
+        }
+        if (last < d->bucket_round) {
+            STATS_ADD(b->counts, STATS_SETTLED, 1);
+            b->failed |= !list_push(&b->removed, u);
+        }
+        for (uint32_t e = offsets[u]; e < d->light_end[u]; e++) {
+            offer(d, b, d->targets[e], dist + d->weights[e], u);
+        }
+    }
+}
+
+/**
+ * Relax heavy edges of a block of nodes removed from the current bucket.
+ * This is a pool_task taking the context as its argument.
+ */
+static void heavy_task(void *arg, size_t worker, size_t task)
+{
+    struct delta *d = arg;
+    struct bins *b = &d->bins[worker];
+    const uint32_t *offsets = d->csr->offsets;
+    size_t end = (task + 1) * BLOCK;
+    if (end > d->frontier.len) end = d->frontier.len;
+    for (size_t i = task * BLOCK; i < end; i++) {
+        uint32_t u = d->frontier.data[i];
+        uint64_t dist = __atomic_load_n(&d->label[u], __ATOMIC_RELAXED) >> 32;
+        for (uint32_t e = d->light_end[u]; e < offsets[u + 1]; e++) {
+            offer(d, b, d->targets[e], dist + d->weights[e], u);
+        }
+    }
+}
+
+/**
+ * Split edges of a block of nodes into light and heavy ones.
+ * This is a pool_task taking the context as its argument.
+ */
+static void split_task(void *arg, size_t worker, size_t task)
+{
+    (void) worker;
+    struct delta *d = arg;
+    const Csr *csr = d->csr;
+    size_t first = task * BLOCK;
+    size_t end = first + BLOCK;
+    if (end > csr->nodes_num) end = csr->nodes_num;
+    for (size_t u = first; u < end; u++) {
+        uint32_t e = csr->offsets[u];
+        for (int heavy = 0; heavy < 2; heavy++) {
+            if (heavy) {
+                d->light_end[u] = e;
+            }
+            for (uint32_t i = csr->offsets[u]; i < csr->offsets[u + 1]; i++) {
+                if (((uint32_t) csr->weights[i] > d->width) == heavy) {
+                    d->targets[e] = csr->targets[i];
+                    d->weights[e] = csr->weights[i];
+                    e++;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Run tasks over all nodes of the frontier.
+ *
+ * @param d     context
+ * @param fn    function processing a block of nodes
+ * @return      true if successful, false if memory ran out
+ */
+static bool step(struct delta *d, pool_task fn)
+{
+    size_t tasks = (d->frontier.len + BLOCK - 1) / BLOCK;
+    pool_run(d->frontier.len < PARALLEL_MIN ? NULL : d->pool, tasks, fn, d);
+    bool ok = true;
+    for (size_t w = 0; w < d->workers; w++) {
+        ok = ok && !d->bins[w].failed;
+    }
+    return ok;
+}
+
+/**
+ * Collect nodes of all workers into the frontier.
+ *
+ * @param d         context
+ * @param removed   collect nodes removed from the current bucket, the
+ *                  current bucket itself otherwise
+ * @return          true if successful, false if memory ran out
+ */
+static bool gather(struct delta *d, bool removed)
+{
+    d->frontier.len = 0;
+    for (size_t w = 0; w < d->workers; w++) {
+        struct bins *b = &d->bins[w];
+        struct list *l = removed ? &b->removed
+            : &b->ring[d->current & (d->ring_size - 1)];
+        if (!removed) {
+            b->ring_len -= l->len;
+        }
+        if (!list_move(&d->frontier, l)) return false;
+    }
+    return true;
+}
+
+/**
+ * Advance to the lowest nonempty bucket.
+ * Nodes of the far lists that fall into the ring afterwards are moved into
+ * it.
+ *
+ * @param d     context with the current bucket empty
+ * @return      true if a nonempty bucket was found, false if all are empty
+ *              or memory ran out
+ */
+static bool next_bucket(struct delta *d)
+{
+    uint64_t next = UINT64_MAX;
+    for (size_t w = 0; w < d->workers; w++) {
+        const struct bins *b = &d->bins[w];
+        for (uint64_t k = 1; b->ring_len > 0 && k < d->ring_size
+                && d->current + k < next; k++) {
+            uint64_t bucket = d->current + k;
+            if (b->ring[bucket & (d->ring_size - 1)].len > 0) {
+                next = bucket;
+            }
+        }
+        if (b->far.len > 0 && b->far_min < next) {
+            next = b->far_min;
+        }
+    }
+    if (next == UINT64_MAX) return false;
+    d->current = next;
+
+    for (size_t w = 0; w < d->workers; w++) {
+        struct bins *b = &d->bins[w];
+        if (b->far.len == 0 || b->far_min - d->current >= d->ring_size) {
+            continue;
+        }
+        size_t kept = 0;
+        b->far_min = UINT32_MAX;
+        for (size_t i = 0; i < b->far.len; i++) {
+            uint32_t u = b->far.data[i];
+            uint32_t bucket = (d->label[u] >> 32) / d->width;
+            if (bucket < d->current) {
+                continue;       /* Stale entry, the node was finished. */
+            }
+            if (bucket - d->current < d->ring_size) {
+                insert(d, b, u, bucket);
+            } else {
+                b->far.data[kept++] = u;
+                if (bucket < b->far_min) {
+                    b->far_min = bucket;
+                }
+            }
+        }
+        b->far.len = kept;
+        if (b->failed) return false;
+    }
+    return true;
+}
+
+Delta * delta_new(const Csr *csr, uint32_t width, Pool *pool)
+{
+    if (!csr || csr->min_weight < 0) return NULL;
+    Delta *d = calloc(1, sizeof *d);
+    if (!d) return NULL;
+    d->csr = csr;
+    d->pool = pool;
+    d->width = width ? width : delta_auto_width(csr);
+    /* Edges of typical weight stay within the ring. */
+    d->ring_size = 2;
+    while (d->ring_size < MAX_RING
+            && d->ring_size < (uint64_t) csr->typical_weight / d->width + 2) {
+        d->ring_size *= 2;
+    }
+    d->workers = pool_size(pool);
+    size_t n = (size_t) csr->nodes_num + 1;
+    size_t m = (size_t) csr->edges_num + 1;
+    d->targets = malloc(m * sizeof *d->targets);
+    d->weights = malloc(m * sizeof *d->weights);
+    d->light_end = malloc(n * sizeof *d->light_end);
+    d->label = malloc(n * sizeof *d->label);
+    d->expanded = malloc(n * sizeof *d->expanded);
+    d->bins = calloc(d->workers, sizeof *d->bins);
+    if (!d->targets || !d->weights || !d->light_end || !d->label
+            || !d->expanded || !d->bins) {
+        delta_free(d);
+        return NULL;
+    }
+    for (size_t w = 0; w < d->workers; w++) {
+        d->bins[w].ring = calloc(d->ring_size, sizeof *d->bins[w].ring);
+        if (!d->bins[w].ring) {
+            delta_free(d);
+            return NULL;
+        }
+    }
+    pool_run(pool, (csr->nodes_num + BLOCK - 1) / BLOCK, split_task, d);
+    return d;
+}
+
+uint32_t delta_width(const Delta *d)
+{
+    return d ? d->width : 0;
+}
+
+bool delta_run(Delta *d, uint32_t source)
+{
+    if (!d) return false;
+    assert(source < d->csr->nodes_num);
+    pool_run(d->pool, (d->csr->nodes_num + RESET_BLOCK - 1) / RESET_BLOCK,
+            reset_task, d);
+    for (size_t w = 0; w < d->workers; w++) {
+        struct bins *b = &d->bins[w];
+        for (uint32_t i = 0; i < d->ring_size; i++) {
+            b->ring[i].len = 0;
+        }
+        b->ring_len = 0;
+        b->far.len = 0;
+        b->far_min = UINT32_MAX;
+        b->removed.len = 0;
+        b->failed = false;
+    }
+    d->current = 0;
+    d->round = 0;
+    d->label[source] = CSR_NONE;        /* Zero distance, no previous node. */
+    insert(d, &d->bins[0], source, 0);
+    bool ok = !d->bins[0].failed;
+    while (ok) {
+        d->bucket_round = d->round + 1;
+        /* Light edges may put nodes back into the current bucket. */
+        while ((ok = gather(d, false)) && d->frontier.len > 0) {
+            d->round++;
+            if (!(ok = step(d, light_task))) break;
+        }
+        ok = ok && gather(d, true) && step(d, heavy_task);
+        if (!ok || !next_bucket(d)) break;
+    }
+    for (size_t w = 0; w < d->workers; w++) {
+        ok = ok && !d->bins[w].failed;
+    }
+    return ok;
+}
+
+uint32_t delta_distance(const Delta *d, uint32_t node)
+{
+    assert(d && node < d->csr->nodes_num);
+    return d->label[node] >> 32;
+}
+
+uint32_t delta_previous(const Delta *d, uint32_t node)
+{
+    assert(d && node < d->csr->nodes_num);
+    return (uint32_t) d->label[node];
+}
+
+void delta_free(Delta *d)
+{
+    if (d) {
+        for (size_t w = 0; d->bins && w < d->workers; w++) {
+            STATS_FLUSH(d->bins[w].counts);
+            for (uint32_t i = 0; d->bins[w].ring && i < d->ring_size; i++) {
+                free(d->bins[w].ring[i].data);
+            }
+            free(d->bins[w].ring);
+            free(d->bins[w].far.data);
+            free(d->bins[w].removed.data);
+        }
+        free(d->bins);
+        free(d->targets);
+        free(d->weights);
+        free(d->light_end);
+        free(d->label);
+        free(d->expanded);
+        free(d->frontier.data);
+    }
+    free(d);
+}
@@ -0,0 +1,101 @@
+/**
+ * Interface for parallel delta-stepping.
+ *
+ * Delta-stepping computes shortest paths from one node to all nodes of a
+ * graph. Tentative distances are grouped into buckets of fixed width (delta)
+ * and all nodes of the lowest nonempty bucket are processed at once by all
+ * threads. Edges not longer than delta (light edges) may put nodes back into
+ * the current bucket, so they are relaxed repeatedly until the bucket stays
+ * empty. Longer (heavy) edges are relaxed once per node afterwards.
+ *
+ * Small delta does little useless work but needs many synchronized steps,
+ * large delta the other way round; delta_auto_width() picks one that keeps
+ * about one light edge per node in each bucket.
+ *
+ * Only graphs without negative edge weights can be searched.
+ *
+ * @file    delta.h
+ */
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pool.h"
+
+/**
+ * Context is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct delta Delta;
+
+/**
+ * Pick width of buckets suitable for a graph.
+ *
+ * @param csr   frozen graph
+ * @return      width of buckets, at least one
+ */
+uint32_t delta_auto_width(const Csr *csr);
+
+/**
+ * Create a context for delta-stepping on a graph.
+ * Edges of the graph are copied with light edges of each node first. The
+ * graph must outlive the context.
+ *
+ * @param csr   frozen graph without negative edge weights
+ * @param width width of buckets, zero means delta_auto_width()
+ * @param pool  threads running the searches, may be NULL
+ * @return      new context or NULL if memory ran out or the graph has
+ *              negative weights
+ */
+Delta * delta_new(const Csr *csr, uint32_t width, Pool *pool);
+
+/**
+ * Get width of buckets of a context.
+ *
+ * @param d     context to query
+ * @return      width of buckets
+ */
+uint32_t delta_width(const Delta *d);
+
+/**
+ * Find shortest paths from a node to all nodes.
+ * Distances are the same as found by search_run_all(); if a node has several
+ * shortest paths, the previous node may differ.
+ *
+ * @param d         context to search in
+ * @param source    index of starting node
+ * @return          true if successful, false if memory ran out
+ */
+bool delta_run(Delta *d, uint32_t source);
+
+/**
+ * Get distance of a node from the starting node of last search.
+ * Infinity is signalled by `UINT32_MAX`.
+ *
+ * @param d     context to query
+ * @param node  index of the node
+ * @return      total distance
+ */
+uint32_t delta_distance(const Delta *d, uint32_t node);
+
+/**
+ * Get node from which queried node was reached in last search.
+ * For starting and unreachable nodes this function returns `CSR_NONE`.
+ *
+ * @param d     context to query
+ * @param node  index of the node
+ * @return      index of previous node or `CSR_NONE`
+ */
+uint32_t delta_previous(const Delta *d, uint32_t node);
+
+/**
+ * Free a context.
+ *
+ * @param d     context to be freed
+ */
+void delta_free(Delta *d);
+
+#endif /* end of include guard: DELTA_H */
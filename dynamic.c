@@ -0,0 +1,496 @@
+/**
+ * Functions for shortest paths from one node in a changing graph.
+ *
+ * Each node keeps growing lists of its outgoing and incoming edges, so that
+ * an edge is found, changed or removed in time proportional to the degree of
+ * its ends. Changes are applied to the lists at once and only remembered for
+ * the repair: the ending node of a changed edge of the tree becomes a root of
+ * a subtree to be recomputed, the starting node of an improved edge needs to
+ * be finished again.
+ *
+ * A repair keeps the distances of unaffected nodes. They stay upper bounds of
+ * the new distances and every edge leaving an unaffected node that is not
+ * queued is still consistent with them, so Dijkstra's algorithm started from
+ * the queued nodes makes all of them exact.
+ *
+ * @file    dynamic.c
+ */
+#include "dynamic.h"
+#include "search.h"
+#include "stats.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Upper limit of number of buckets of a bucket queue, see search.c */
+#define DIAL_MAX_WIDTH 65536
+
+/** Edge of the graph. */
+struct arc {
+    /** Index of the node at the other end */
+    uint32_t node;
+    /** Weight of the edge */
+    uint32_t weight;
+};
+
+/** Growing list of edges of a node. */
+struct arcs {
+    struct arc *data;
+    uint32_t len;
+    uint32_t size;
+};
+
+/** Growing list of nodes. */
+struct nodes {
+    uint32_t *data;
+    size_t len;
+    size_t size;
+};
+
+struct dynamic {
+    /** Number of nodes */
+    uint32_t nodes_num;
+    /** Outgoing and incoming edges of each node */
+    struct arcs *out;
+    struct arcs *in;
+    /** Starting node of the tree, `CSR_NONE` before the first run */
+    uint32_t source;
+    /** Distance of each node from the starting node */
+    uint32_t *dist;
+    /** Previous node of each node in the tree */
+    uint32_t *previous;
+    /** Whether each node is in the queue */
+    bool *queued;
+    /** Whether each node lost its distance in current repair */
+    bool *affected;
+    /** Queue of nodes whose distance changed and edges were not relaxed */
+    Pq *queue;
+    /** Nodes whose edge in the tree got longer or was removed */
+    struct nodes roots;
+    /** Starting nodes of edges that got shorter or were inserted */
+    struct nodes tails;
+    /** Nodes losing their distance in current repair */
+    struct nodes subtree;
+    /** Number of nodes finished by last run or repair */
+    uint32_t settled;
+#ifdef GRAPH_STATS
+    /** Work of finished searches not yet added to the totals */
+    uint64_t counts[STATS_COUNTERS];
+#endif
+};
+
+/**
+ * Append a node to a list.
+ *
+ * @param l     list of nodes
+ * @param node  index of the node
+ * @return      true if successful, false if memory ran out
+ */
+static bool nodes_push(struct nodes *l, uint32_t node)
+{
+    if (l->len == l->size) {
+        size_t size = l->size ? 2 * l->size : 64;
+        uint32_t *tmp = realloc(l->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        l->data = tmp;
+        l->size = size;
+    }
+    l->data[l->len++] = node;
+    return true;
+}
+
+/**
+ * Find an edge in a list.
+ *
+ * @param a     edges of a node
+ * @param node  other end of the edge
+ * @return      the edge or NULL if there is no such edge
+ */
+static struct arc * arcs_find(const struct arcs *a, uint32_t node)
+{
+    for (uint32_t i = 0; i < a->len; i++) {
+        if (a->data[i].node == node) {
+            return &a->data[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Append an edge to a list.
+ *
+ * @param a         edges of a node
+ * @param node      other end of the edge
+ * @param weight    weight of the edge
+ * @return          true if successful, false if memory ran out
+ */
+static bool arcs_push(struct arcs *a, uint32_t node, uint32_t weight)
+{
+    if (a->len == a->size) {
+        uint32_t size = a->size ? 2 * a->size : 4;
+        struct arc *tmp = realloc(a->data, size * sizeof *tmp);
+        if (!tmp) return false;
+        a->data = tmp;
+        a->size = size;
+    }
+    a->data[a->len].node = node;
+    a->data[a->len].weight = weight;
+    a->len++;
+    return true;
+}
+
+/**
+ * Remove an edge from a list.
+ *
+ * @param a     edges of a node
+ * @param node  other end of the edge
+ */
+static void arcs_remove(struct arcs *a, uint32_t node)
+{
+    for (uint32_t i = 0; i < a->len; i++) {
+        if (a->data[i].node == node) {
+            a->data[i] = a->data[--a->len];
+            return;
+        }
+    }
+}
+
+/**
+ * Copy outgoing edges of all nodes from a frozen graph.
+ * Parallel edges are merged into one with the lowest weight.
+ *
+ * @param d     context with allocated lists
+ * @param csr   frozen graph
+ * @return      true if successful, false if memory ran out
+ */
+static bool fill_out(Dynamic *d, const Csr *csr)
+{
+    /* Position of the edge to each node in the list being filled. */
+    uint32_t *pos = calloc((size_t) d->nodes_num + 1, sizeof *pos);
+    if (!pos) return false;
+    for (uint32_t i = 0; i < d->nodes_num; i++) {
+        struct arcs *a = &d->out[i];
+        uint32_t len = csr->offsets[i + 1] - csr->offsets[i];
+        a->data = malloc(((size_t) len + 1) * sizeof *a->data);
+        if (!a->data) {
+            free(pos);
+            return false;
+        }
+        a->size = len + 1;
+        for (uint32_t e = csr->offsets[i]; e < csr->offsets[i + 1]; e++) {
+            uint32_t node = csr->targets[e];
+            uint32_t p = pos[node];
+            if (p < a->len && a->data[p].node == node) {
+                if ((uint32_t) csr->weights[e] < a->data[p].weight) {
+                    a->data[p].weight = csr->weights[e];
+                }
+                continue;
+            }
+            pos[node] = a->len;
+            a->data[a->len].node = node;
+            a->data[a->len].weight = csr->weights[e];
+            a->len++;
+        }
+    }
+    free(pos);
+    return true;
+}
+
+/**
+ * Fill incoming edges of all nodes from their outgoing edges.
+ *
+ * @param d     context with outgoing edges filled in
+ * @return      true if successful, false if memory ran out
+ */
+static bool fill_in(Dynamic *d)
+{
+    for (uint32_t i = 0; i < d->nodes_num; i++) {
+        for (uint32_t j = 0; j < d->out[i].len; j++) {
+            d->in[d->out[i].data[j].node].size++;
+        }
+    }
+    for (uint32_t i = 0; i < d->nodes_num; i++) {
+        struct arcs *a = &d->in[i];
+        a->data = malloc(((size_t) a->size + 1) * sizeof *a->data);
+        if (!a->data) return false;
+        a->size++;
+    }
+    for (uint32_t i = 0; i < d->nodes_num; i++) {
+        for (uint32_t j = 0; j < d->out[i].len; j++) {
+            const struct arc *e = &d->out[i].data[j];
+            struct arcs *a = &d->in[e->node];
+            a->data[a->len].node = i;
+            a->data[a->len].weight = e->weight;
+            a->len++;
+        }
+    }
+    return true;
+}
+
+Dynamic * dynamic_new(const Csr *csr, enum pq_kind queue)
+{
+    if (!csr || csr->min_weight < 0) return NULL;
+    Dynamic *d = calloc(1, sizeof *d);
+    if (!d) return NULL;
+    size_t n = (size_t) csr->nodes_num + 1;
+    d->nodes_num = csr->nodes_num;
+    d->source = CSR_NONE;
+    d->out = calloc(n, sizeof *d->out);
+    d->in = calloc(n, sizeof *d->in);
+    d->dist = malloc(n * sizeof *d->dist);
+    d->previous = malloc(n * sizeof *d->previous);
+    d->queued = calloc(n, sizeof *d->queued);
+    d->affected = calloc(n, sizeof *d->affected);
+    /* Bucket queue has one bucket for every distance within typical edge
+     * weight from the closest unfinished node. */
+    uint32_t width = csr->typical_weight > 0 ? csr->typical_weight + 1 : 1;
+    if (width > DIAL_MAX_WIDTH) width = DIAL_MAX_WIDTH;
+    d->queue = pq_new(queue == PQ_AUTO ? search_auto_queue(csr) : queue,
+            csr->nodes_num, width);
+    if (!d->out || !d->in || !d->dist || !d->previous || !d->queued
+            || !d->affected || !d->queue || !fill_out(d, csr) || !fill_in(d)) {
+        dynamic_free(d);
+        return NULL;
+    }
+    return d;
+}
+
+/**
+ * Offer a new distance to a node.
+ *
+ * @param d     context
+ * @param node  index of the node
+ * @param dist  offered distance
+ * @param from  neighbour through which the node is reached
+ * @return      true if successful, false if memory ran out
+ */
+static bool offer(Dynamic *d, uint32_t node, uint64_t dist, uint32_t from)
+{
+    if (dist >= d->dist[node]) {
+        return true;
+    }
+    d->dist[node] = dist;
+    d->previous[node] = from;
+    if (d->queued[node]) {
+        return pq_decrease(d->queue, node, dist);
+    }
+    d->queued[node] = true;
+    return pq_push(d->queue, node, dist);
+}
+
+/**
+ * Finish all queued nodes and nodes whose distance they improve.
+ *
+ * @param d     context with queued nodes
+ * @return      true if successful, false if memory ran out
+ */
+static bool settle(Dynamic *d)
+{
+    bool ok = true;
+    uint32_t current, dist;
+    while (ok && pq_pop(d->queue, &current, &dist)) {
+        if (dist != d->dist[current]) {
+            continue;           /* Stale entry, the node was finished. */
+        }
+        d->queued[current] = false;
+        d->settled++;
+        const struct arcs *a = &d->out[current];
+        STATS_ADD(d->counts, STATS_RELAXATIONS, a->len);
+        for (uint32_t j = 0; ok && j < a->len; j++) {
+            ok = offer(d, a->data[j].node, (uint64_t) dist + a->data[j].weight,
+                    current);
+        }
+    }
+    return ok && pq_is_empty(d->queue);
+}
+
+/**
+ * Start a new run or repair.
+ *
+ * @param d     context
+ */
+static void restart(Dynamic *d)
+{
+    pq_clear(d->queue);
+    STATS_ADD(d->counts, STATS_SETTLED, d->settled);
+    d->settled = 0;
+}
+
+bool dynamic_run(Dynamic *d, uint32_t source)
+{
+    if (!d) return false;
+    assert(source < d->nodes_num);
+    restart(d);
+    for (uint32_t i = 0; i < d->nodes_num; i++) {
+        d->dist[i] = UINT32_MAX;
+        d->previous[i] = CSR_NONE;
+        d->queued[i] = false;
+    }
+    d->roots.len = 0;
+    d->tails.len = 0;
+    d->source = source;
+    d->dist[source] = 0;
+    d->queued[source] = true;
+    return pq_push(d->queue, source, 0) && settle(d);
+}
+
+bool dynamic_set_edge(Dynamic *d, uint32_t from, uint32_t to, uint32_t weight)
+{
+    if (!d) return false;
+    assert(from < d->nodes_num && to < d->nodes_num);
+    struct arc *out = arcs_find(&d->out[from], to);
+    if (!out) {
+        if (!arcs_push(&d->out[from], to, weight)) return false;
+        if (!arcs_push(&d->in[to], from, weight)) {
+            d->out[from].len--;
+            return false;
+        }
+    } else if (out->weight != weight) {
+        uint32_t old = out->weight;
+        out->weight = weight;
+        arcs_find(&d->in[to], from)->weight = weight;
+        if (weight > old) {
+            /* Only an edge of the tree makes paths longer. */
+            return d->source == CSR_NONE || d->previous[to] != from
+                || nodes_push(&d->roots, to);
+        }
+    } else {
+        return true;
+    }
+    return d->source == CSR_NONE || nodes_push(&d->tails, from);
+}
+
+bool dynamic_remove_edge(Dynamic *d, uint32_t from, uint32_t to,
+        bool *removed)
+{
+    if (!d) return false;
+    assert(from < d->nodes_num && to < d->nodes_num);
+    bool found = arcs_find(&d->out[from], to) != NULL;
+    if (removed) *removed = found;
+    if (!found) return true;
+    arcs_remove(&d->out[from], to);
+    arcs_remove(&d->in[to], from);
+    return d->source == CSR_NONE || d->previous[to] != from
+        || nodes_push(&d->roots, to);
+}
+
+/**
+ * Mark all nodes whose path in the tree passes through a root.
+ * Marked nodes are collected in `subtree`.
+ *
+ * @param d     context with collected roots
+ * @return      true if successful, false if memory ran out
+ */
+static bool mark_subtrees(Dynamic *d)
+{
+    d->subtree.len = 0;
+    for (size_t i = 0; i < d->roots.len; i++) {
+        uint32_t v = d->roots.data[i];
+        if (!d->affected[v]) {
+            d->affected[v] = true;
+            if (!nodes_push(&d->subtree, v)) return false;
+        }
+    }
+    /* Edges of the tree that were removed or changed have their ending node
+     * among the roots, all other edges of the tree are still in the lists. */
+    for (size_t i = 0; i < d->subtree.len; i++) {
+        uint32_t v = d->subtree.data[i];
+        const struct arcs *a = &d->out[v];
+        for (uint32_t j = 0; j < a->len; j++) {
+            uint32_t x = a->data[j].node;
+            if (!d->affected[x] && d->previous[x] == v) {
+                d->affected[x] = true;
+                if (!nodes_push(&d->subtree, x)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool dynamic_repair(Dynamic *d)
+{
+    if (!d) return false;
+    if (d->source == CSR_NONE) {
+        d->roots.len = 0;
+        d->tails.len = 0;
+        return true;
+    }
+    restart(d);
+    bool ok = mark_subtrees(d);
+    for (size_t i = 0; ok && i < d->subtree.len; i++) {
+        uint32_t v = d->subtree.data[i];
+        d->dist[v] = UINT32_MAX;
+        d->previous[v] = CSR_NONE;
+    }
+    /* Affected nodes get the best distance over edges from the rest of the
+     * tree, which is kept. */
+    for (size_t i = 0; ok && i < d->subtree.len; i++) {
+        uint32_t v = d->subtree.data[i];
+        const struct arcs *a = &d->in[v];
+        STATS_ADD(d->counts, STATS_RELAXATIONS, a->len);
+        for (uint32_t j = 0; ok && j < a->len; j++) {
+            uint32_t u = a->data[j].node;
+            if (!d->affected[u] && d->dist[u] != UINT32_MAX) {
+                ok = offer(d, v, (uint64_t) d->dist[u] + a->data[j].weight, u);
+            }
+        }
+    }
+    for (size_t i = 0; ok && i < d->tails.len; i++) {
+        uint32_t u = d->tails.data[i];
+        if (!d->affected[u] && !d->queued[u] && d->dist[u] != UINT32_MAX) {
+            d->queued[u] = true;
+            ok = pq_push(d->queue, u, d->dist[u]);
+        }
+    }
+    ok = ok && settle(d);
+    for (size_t i = 0; i < d->subtree.len; i++) {
+        d->affected[d->subtree.data[i]] = false;
+    }
+    d->roots.len = 0;
+    d->tails.len = 0;
+    return ok;
+}
+
+uint32_t dynamic_distance(const Dynamic *d, uint32_t node)
+{
+    assert(d && node < d->nodes_num);
+    return d->dist[node];
+}
+
+uint32_t dynamic_previous(const Dynamic *d, uint32_t node)
+{
+    assert(d && node < d->nodes_num);
+    return d->previous[node];
+}
+
+uint32_t dynamic_settled(const Dynamic *d)
+{
+    assert(d);
+    return d->settled;
+}
+
+void dynamic_free(Dynamic *d)
+{
+    if (d) {
+        STATS_ADD(d->counts, STATS_SETTLED, d->settled);
+        STATS_FLUSH(d->counts);
+        for (uint32_t i = 0; d->out && i < d->nodes_num; i++) {
+            free(d->out[i].data);
+        }
+        for (uint32_t i = 0; d->in && i < d->nodes_num; i++) {
+            free(d->in[i].data);
+        }
+        free(d->out);
+        free(d->in);
+        free(d->dist);
+        free(d->previous);
+        free(d->queued);
+        free(d->affected);
+        pq_free(d->queue);
+        free(d->roots.data);
+        free(d->tails.data);
+        free(d->subtree.data);
+        free(d);
+    }
+}
@@ -0,0 +1,132 @@
+/**
+ * Interface for shortest paths from one node in a changing graph.
+ *
+ * A context holds its own copy of the edges of a frozen graph, which can be
+ * changed, inserted and removed, and a tree of shortest paths from one node.
+ * After a batch of changes dynamic_repair() fixes the tree in the manner of
+ * Ramalingam and Reps instead of searching the whole graph again:
+ *
+ * - nodes whose path used an edge that got longer or was removed, together
+ *   with their whole subtree, lose their distance and get the best one
+ *   offered by the rest of the tree over their incoming edges;
+ * - starting nodes of edges that got shorter or were inserted offer their
+ *   distance over their outgoing edges again;
+ *
+ * and Dijkstra's algorithm runs from the nodes reached this way until no
+ * distance improves. Only nodes whose distance or previous node may change
+ * are finished, see dynamic_settled().
+ *
+ * There is at most one edge from a node to another one. Only graphs without
+ * negative edge weights can be searched.
+ *
+ * @file    dynamic.h
+ */
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pq.h"
+
+/**
+ * Context is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct dynamic Dynamic;
+
+/**
+ * Create a context with a copy of the edges of a frozen graph.
+ * Parallel edges are merged into one with the lowest weight. The graph is not
+ * needed afterwards.
+ *
+ * @param csr   frozen graph without negative edge weights
+ * @param queue implementation of the priority queue, `PQ_AUTO` picks one
+ *              suitable for the weights of the graph
+ * @return      new context or NULL if memory ran out or the graph has
+ *              negative weights
+ */
+Dynamic * dynamic_new(const Csr *csr, enum pq_kind queue);
+
+/**
+ * Find shortest paths from a node to all nodes from scratch.
+ * Changes made before are taken into account and need no repair.
+ *
+ * @param d         context to search in
+ * @param source    index of starting node
+ * @return          true if successful, false if memory ran out
+ */
+bool dynamic_run(Dynamic *d, uint32_t source);
+
+/**
+ * Set weight of an edge, inserting the edge if it does not exist.
+ * Distances are not updated until dynamic_repair().
+ *
+ * @param d         context to modify
+ * @param from      index of starting node
+ * @param to        index of ending node
+ * @param weight    new weight of the edge
+ * @return          true if successful, false if memory ran out
+ */
+bool dynamic_set_edge(Dynamic *d, uint32_t from, uint32_t to, uint32_t weight);
+
+/**
+ * Remove an edge.
+ * Distances are not updated until dynamic_repair().
+ *
+ * @param d         context to modify
+ * @param from      index of starting node
+ * @param to        index of ending node
+ * @param[out] removed  set to false if there was no such edge, may be NULL
+ * @return          true if successful, false if memory ran out
+ */
+bool dynamic_remove_edge(Dynamic *d, uint32_t from, uint32_t to,
+        bool *removed);
+
+/**
+ * Update shortest paths after the edges were changed.
+ * Nothing is done before the first dynamic_run(). If memory runs out, the
+ * paths are invalid until the next dynamic_run().
+ *
+ * @param d     context to repair
+ * @return      true if successful, false if memory ran out
+ */
+bool dynamic_repair(Dynamic *d);
+
+/**
+ * Get distance of a node from the starting node.
+ * Infinity is signalled by `UINT32_MAX`.
+ *
+ * @param d     context to query
+ * @param node  index of the node
+ * @return      total distance
+ */
+uint32_t dynamic_distance(const Dynamic *d, uint32_t node);
+
+/**
+ * Get node from which queried node is reached.
+ * For starting and unreachable nodes this function returns `CSR_NONE`.
+ *
+ * @param d     context to query
+ * @param node  index of the node
+ * @return      index of previous node or `CSR_NONE`
+ */
+uint32_t dynamic_previous(const Dynamic *d, uint32_t node);
+
+/**
+ * Get number of nodes finished by last run or repair.
+ *
+ * @param d     context to query
+ * @return      number of finished nodes
+ */
+uint32_t dynamic_settled(const Dynamic *d);
+
+/**
+ * Free a context.
+ *
+ * @param d     context to be freed
+ */
+void dynamic_free(Dynamic *d);
+
+#endif /* end of include guard: DYNAMIC_H */
@@ -0,0 +1,289 @@
+/**
+ * @file    gen.c
+ *
+ * Generator of synthetic graphs resembling DIMES measurements of the
+ * autonomous systems of the Internet.
+ *
+ * Node degrees follow a power law like those of autonomous systems. Node `i`
+ * has weight `(i + 1)^(-1 / (exponent - 1))` and both ends of edges are
+ * drawn with probability proportional to the weights (Chung-Lu model). The
+ * inverse of the cumulative weight has a closed form, so an end is drawn in
+ * constant time and only a few numbers are kept in memory regardless of
+ * the size of the graph.
+ *
+ * Every node except the first also gets a link to a node with lower index,
+ * drawn the same way, in both directions, which makes the graph strongly
+ * connected like the provider hierarchy of the Internet.
+ *
+ * Nodes are placed at random points of a unit square and the delay of an
+ * edge grows with the distance of its ends plus random jitter. Edges can be
+ * written several times with different delays, like repeated measurements.
+ *
+ * Identifiers are distinct and scattered like AS numbers: node `i` gets
+ * `1 + i * step % prime` for a prime larger than the number of nodes.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Default number of edges */
+static const uint64_t DEFAULT_EDGES = 1000000;
+/** Default exponent of the degree distribution, as measured for ASes */
+static const double DEFAULT_EXPONENT = 2.1;
+/** Default number of edges per node when the number of nodes is not given */
+static const uint64_t EDGES_PER_NODE = 8;
+/** Delay in milliseconds between opposite corners of the square */
+static const double MAX_DELAY = 150;
+/** Highest random jitter added to each delay in milliseconds */
+static const uint32_t JITTER = 10;
+/** Size of output buffers */
+static const size_t BUFFER_SIZE = 1 << 20;
+
+/** Parameters of the generated graph. */
+struct model {
+    /** Number of nodes */
+    uint64_t nodes;
+    /** `1 - 1 / (exponent - 1)` */
+    double power;
+    /** Prime larger than the number of nodes */
+    uint64_t prime;
+    /** Multiplier scattering identifiers */
+    uint64_t step;
+    /** Seed of positions of nodes */
+    uint64_t seed;
+};
+
+/**
+ * Get next pseudo-random number.
+ * This is xorshift64*, the same generator as in the benchmark.
+ *
+ * @param state     state of the generator, must not be zero
+ * @return          random number
+ */
+static uint64_t next_random(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * Get a random number from the unit interval.
+ *
+ * @param state     state of the generator
+ * @return          number at least 0 and less than 1
+ */
+static double uniform(uint64_t *state)
+{
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Get the total weight of nodes with index lower than `x`.
+ * This is the integral of `(t + 1)^(power - 1)` from 0 to `x`, omitting the
+ * constant factor `1 / power`.
+ *
+ * @param m     model
+ * @param x     upper bound
+ * @return      cumulative weight
+ */
+static double cumulative(const struct model *m, double x)
+{
+    return pow(x + 1, m->power) - 1;
+}
+
+/**
+ * Draw a node with probability proportional to its weight.
+ *
+ * @param m         model
+ * @param limit     draw only nodes with index lower than this
+ * @param state     state of the generator
+ * @return          index of the node
+ */
+static uint64_t draw(const struct model *m, uint64_t limit, uint64_t *state)
+{
+    double w = uniform(state) * cumulative(m, limit);
+    uint64_t node = (uint64_t) (pow(w + 1, 1 / m->power) - 1);
+    return node < limit ? node : limit - 1;
+}
+
+/**
+ * Get identifier of a node.
+ *
+ * @param m     model
+ * @param node  index of the node
+ * @return      identifier
+ */
+static uint32_t identifier(const struct model *m, uint64_t node)
+{
+    return 1 + node * m->step % m->prime;
+}
+
+/**
+ * Get coordinate of a node.
+ *
+ * @param m     model
+ * @param node  index of the node
+ * @param axis  0 or 1
+ * @return      coordinate from the unit interval
+ */
+static double coordinate(const struct model *m, uint64_t node, int axis)
+{
+    uint64_t state = (m->seed ^ (2 * node + axis + 1)) * 0x9e3779b97f4a7c15ULL;
+    next_random(&state);
+    return uniform(&state);
+}
+
+/**
+ * Write one edge, possibly several times.
+ *
+ * @param f         file with edges
+ * @param m         model
+ * @param from      index of starting node
+ * @param to        index of ending node
+ * @param repeats   highest number of measurements of the edge
+ * @param state     state of the generator
+ * @return          number of written lines
+ */
+static uint64_t write_edge(FILE *f, const struct model *m, uint64_t from,
+        uint64_t to, uint32_t repeats, uint64_t *state)
+{
+    double dx = coordinate(m, from, 0) - coordinate(m, to, 0);
+    double dy = coordinate(m, from, 1) - coordinate(m, to, 1);
+    uint32_t base = MAX_DELAY / sqrt(2) * sqrt(dx * dx + dy * dy);
+    uint32_t times = 1 + next_random(state) % repeats;
+    for (uint32_t i = 0; i < times; i++) {
+        fprintf(f, "%u,%u,%u,%u\n", identifier(m, from), identifier(m, to),
+                times, base + (uint32_t) (next_random(state) % (JITTER + 1)));
+    }
+    return times;
+}
+
+/**
+ * Find the smallest prime larger than a number.
+ *
+ * @param n     the number
+ * @return      prime
+ */
+static uint64_t prime_above(uint64_t n)
+{
+    for (uint64_t p = n + 1;; p++) {
+        bool prime = p > 1;
+        for (uint64_t d = 2; prime && d * d <= p; d++) {
+            prime = p % d != 0;
+        }
+        if (prime) return p;
+    }
+}
+
+/**
+ * Print usage of the program.
+ *
+ * @param name  name of the program
+ */
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--edges M] [--nodes N] [--exponent G] "
+            "[--repeats R] [--seed S] NODES EDGES\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t edges = DEFAULT_EDGES;
+    uint64_t nodes = 0;
+    double exponent = DEFAULT_EXPONENT;
+    uint32_t repeats = 1;
+    uint64_t seed = 1;
+    const char *paths[2] = { NULL, NULL };
+    int paths_num = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--edges") == 0 && i + 1 < argc) {
+            edges = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--exponent") == 0 && i + 1 < argc) {
+            exponent = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (paths_num < 2 && argv[i][0] != '-') {
+            paths[paths_num++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nodes == 0) {
+        nodes = edges / EDGES_PER_NODE > 2 ? edges / EDGES_PER_NODE : 2;
+    }
+    /* Identifiers must fit into 32 bits and the links to lower nodes take
+     * two edges per node. */
+    if (paths_num != 2 || repeats == 0 || !(exponent > 2 && exponent <= 10)
+            || nodes < 2 || nodes >= UINT32_MAX / 2
+            || edges < 2 * (nodes - 1)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct model m;
+    m.nodes = nodes;
+    m.power = 1 - 1 / (exponent - 1);
+    m.prime = prime_above(nodes + nodes / 2);
+    m.step = 1 + (seed * 0x9e3779b97f4a7c15ULL) % (m.prime - 1);
+    m.seed = seed;
+
+    FILE *f = fopen(paths[0], "w");
+    if (!f) {
+        fprintf(stderr, "%s: can not open file\n", paths[0]);
+        return 3;
+    }
+    setvbuf(f, NULL, _IOFBF, BUFFER_SIZE);
+    for (uint64_t v = 0; v < nodes; v++) {
+        uint32_t id = identifier(&m, v);
+        fprintf(f, "%u,AS%u\n", id, id);
+    }
+    if (fclose(f) != 0) {
+        fprintf(stderr, "%s: write failed\n", paths[0]);
+        return 7;
+    }
+
+    f = fopen(paths[1], "w");
+    if (!f) {
+        fprintf(stderr, "%s: can not open file\n", paths[1]);
+        return 3;
+    }
+    setvbuf(f, NULL, _IOFBF, BUFFER_SIZE);
+    uint64_t state = seed ? seed : 1;
+    uint64_t lines = 0;
+    for (uint64_t v = 1; v < nodes; v++) {
+        uint64_t parent = draw(&m, v, &state);
+        lines += write_edge(f, &m, v, parent, repeats, &state);
+        lines += write_edge(f, &m, parent, v, repeats, &state);
+    }
+    for (uint64_t e = 2 * (nodes - 1); e < edges; e++) {
+        uint64_t from = draw(&m, nodes, &state);
+        uint64_t to = draw(&m, nodes, &state);
+        if (from == to) {
+            e--;                /* Loops are not measured. */
+            continue;
+        }
+        lines += write_edge(f, &m, from, to, repeats, &state);
+    }
+    if (fclose(f) != 0) {
+        fprintf(stderr, "%s: write failed\n", paths[1]);
+        return 7;
+    }
+    fprintf(stderr, "%llu nodes, %llu edges, %llu lines\n",
+            (unsigned long long) nodes, (unsigned long long) edges,
+            (unsigned long long) lines);
+    return 0;
+}
@@ -4,22 +4,46 @@
  * This file contains definitions of graph and node types and functions
  * designed to work with these types.
  *
+ * Nodes and their arrays of edges are allocated from an arena owned by the
+ * graph. Arrays have power of two sizes; when one grows, the old array is
+ * kept in a list of spare arrays of its size and reused by another node.
+ *
  * @file    graph.c
  * @author  Lubomir Sedlar
  */
 #include "graph.h"
 #include "graph-private.h"
+#include "arena.h"
+#include "binfile.h"
+#include "csr.h"
+#include "idmap.h"
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+/** Number of sizes of edge arrays, each twice as large as the previous */
+#define EDGE_CLASSES 32
+
+/** Spare array of edges, stored in the array itself. */
+struct spare {
+    /** Next spare array of the same size */
+    struct spare *next;
+};
+
 /** Structure representing graph. */
 struct graph {
     size_t  size;
     size_t  used;
     Node  **nodes;
     bool    sorted;
+    /** Map from identifiers to positions in `nodes`, NULL until the first
+     * lookup after inserting nodes */
+    Idmap  *map;
+    /** Memory of nodes and edges */
+    Arena  *arena;
+    /** Spare edge arrays of `EDGES_DEFAULT_SIZE << i` edges at index `i` */
+    struct spare *spares[EDGE_CLASSES];
 };
 
 unsigned int node_get_id(Node *n)
@@ -28,28 +52,22 @@ unsigned int node_get_id(Node *n)
     return n->id;
 }
 
-unsigned short node_get_n_outgoing(Node *n)
+unsigned int node_get_n_outgoing(Node *n)
 {
     assert(n);
     return n->edges_num;
 }
 
-struct edge * node_get_edges(Node *n)
+unsigned int node_get_index(Node *n)
 {
     assert(n);
-    return n->edges;
+    return n->index;
 }
 
-unsigned int node_get_distance(Node *n)
-{
-    assert(n);
-    return n->dist;
-}
-
-Node * node_get_previous(Node *n)
+struct edge * node_get_edges(Node *n)
 {
     assert(n);
-    return n->previous;
+    return n->edges;
 }
 
 /** Default size of nodes array */
@@ -59,19 +77,72 @@ static const int EDGES_DEFAULT_SIZE = 8;
 
 Graph * graph_new(void)
 {
-    Graph *g = malloc(sizeof *g);
+    Graph *g = calloc(1, sizeof *g);
     if (!g) return NULL;
     g->size = NODES_DEFAULT_SIZE;
     g->used = 0;
+    g->sorted = true;
+    g->map = NULL;
     g->nodes = calloc(g->size, sizeof *g->nodes);
-    if (!g->nodes) {
-        g->size = 0;
-        free(g);
+    g->arena = arena_new(0);
+    if (!g->nodes || !g->arena) {
+        graph_free(g);
         return NULL;
     }
     return g;
 }
 
+/**
+ * Get class of an edge array size.
+ *
+ * @param size  number of edges, `EDGES_DEFAULT_SIZE` times a power of two
+ * @return      index into spare arrays
+ */
+static unsigned int edge_class(unsigned int size)
+{
+    unsigned int c = 0;
+    while ((unsigned int) EDGES_DEFAULT_SIZE << c < size) {
+        c++;
+    }
+    return c;
+}
+
+/**
+ * Get an array of edges, reusing a spare one if possible.
+ * Its content is undefined.
+ *
+ * @param g     graph owning the array
+ * @param size  number of edges, `EDGES_DEFAULT_SIZE` times a power of two
+ * @return      array or NULL if memory ran out
+ */
+static struct edge * edges_alloc(Graph *g, unsigned int size)
+{
+    unsigned int c = edge_class(size);
+    if (c < EDGE_CLASSES && g->spares[c]) {
+        struct spare *spare = g->spares[c];
+        g->spares[c] = spare->next;
+        return (struct edge *) spare;
+    }
+    return arena_alloc(g->arena, (size_t) size * sizeof(struct edge));
+}
+
+/**
+ * Keep an array of edges that is no longer used for later.
+ *
+ * @param g     graph owning the array
+ * @param edges array to be kept
+ * @param size  number of edges it holds
+ */
+static void edges_release(Graph *g, struct edge *edges, unsigned int size)
+{
+    unsigned int c = edge_class(size);
+    if (c < EDGE_CLASSES) {
+        struct spare *spare = (struct spare *) edges;
+        spare->next = g->spares[c];
+        g->spares[c] = spare;
+    }
+}
+
 bool graph_insert_node(Graph *g, unsigned int id)
 {
     if (!g) return false;
@@ -82,21 +153,17 @@ bool graph_insert_node(Graph *g, unsigned int id)
         g->nodes = tmp;
     }
 
-    g->nodes[g->used] = malloc(sizeof **g->nodes);
-    if (!g->nodes[g->used]) return false;
-
-    Node *n = g->nodes[g->used];
+    Node *n = arena_alloc(g->arena, sizeof *n);
+    if (!n) return false;
+    /* Edges are allocated with the first one. */
     n->id = id;
     n->edges_num = 0;
-    n->edges_size = EDGES_DEFAULT_SIZE;
-    n->edges = calloc(n->edges_size, sizeof(struct edge));
-
-    if (!n->edges) {
-        free(n);
-        return false;
-    }
-    g->used++;
+    n->edges_size = 0;
+    n->edges = NULL;
+    g->nodes[g->used++] = n;
     g->sorted = false;
+    idmap_free(g->map);
+    g->map = NULL;
     return true;
 }
 
@@ -109,15 +176,20 @@ bool graph_insert_edge(Graph *g, unsigned int source, unsigned int dest,
     if (!from || !to) return false;
 
     if (from->edges_num >= from->edges_size) {
-        struct edge *tmp = realloc(from->edges,
-                from->edges_size * 2 * sizeof *tmp);
+        unsigned int size = from->edges_size > 0 ? from->edges_size * 2
+            : (unsigned int) EDGES_DEFAULT_SIZE;
+        struct edge *tmp = edges_alloc(g, size);
         if (!tmp) return false;
+        if (from->edges) {
+            memcpy(tmp, from->edges, from->edges_num * sizeof *tmp);
+            edges_release(g, from->edges, from->edges_size);
+        }
         from->edges = tmp;
-        from->edges_size *= 2;
+        from->edges_size = size;
     }
 
     struct edge *edge = &from->edges[from->edges_num++];
-    edge->destination = to;
+    edge->destination = to->id;
     edge->mindelay = mindelay;
     return true;
 }
@@ -126,68 +198,111 @@ static int node_compare(const void *a, const void *b)
 {
     const Node *n1 = *(Node **) a;
     const Node *n2 = *(Node **) b;
-    return n1->id - n2->id;
+    /* Difference of unsigned ids could overflow int. */
+    return (n1->id > n2->id) - (n1->id < n2->id);
 }
 
-Node * graph_get_node(Graph *g, unsigned int id)
+/**
+ * Sort nodes of the graph by their id unless they are already sorted.
+ * Nodes are usually inserted in order, which is checked first. Sorting
+ * invalidates the map of identifiers.
+ *
+ * @param g     graph to sort
+ */
+static void graph_sort(Graph *g)
 {
-    if (!g) return false;
-    /* Sort the array if necessary. */
-    if (!g->sorted) {
-        qsort(g->nodes, g->used, sizeof *g->nodes, node_compare);
-        g->sorted = true;
-    }
-    size_t low = 0;             /* Lowest index that can hold the value. */
-    size_t high = g->used;      /* Lowest index that is known to have too high
-                                   value. These indices specify a halfopen
-                                   interval of form [low,high). */
-    while (high > low) {        /* Stop when there are no indices that can
-                                   have wanted value. */
-        size_t mid = (low + high) / 2; /* Pick middle value. */
-        /* Hit! return found node. */
-        if (id == g->nodes[mid]->id) {
-            return g->nodes[mid];
-        /* Middle is still to big, therefore it is new high limit. */
-        } else if (id < g->nodes[mid]->id) {
-            high = mid;
-        /* Middle is too small, so low limit is mid + 1. */
-        } else {
-            low = mid + 1;
+    if (g->sorted) return;
+    g->sorted = true;
+    for (size_t i = 1; i < g->used; i++) {
+        if (g->nodes[i - 1]->id > g->nodes[i]->id) {
+            qsort(g->nodes, g->used, sizeof *g->nodes, node_compare);
+            idmap_free(g->map);
+            g->map = NULL;
+            return;
         }
     }
-    return NULL;                /* Not found. */
 }
 
 /**
- * Free a single node.
- * This is a private function that should not be called from outside this
- * module.
+ * Build map of identifiers of nodes unless it exists.
  *
- * @param node  node to be freed
+ * @param g     graph to index
+ * @return      true if successful, false if memory ran out
  */
-static void node_free(Node *node)
+static bool graph_build_map(Graph *g)
 {
-    if (node) {
-        free(node->edges);
+    if (g->map) return true;
+    uint32_t *ids = malloc((g->used + 1) * sizeof *ids);
+    if (!ids) return false;
+    for (size_t i = 0; i < g->used; i++) {
+        ids[i] = g->nodes[i]->id;
     }
-    free(node);
+    g->map = idmap_new(ids, g->used);
+    free(ids);
+    return g->map != NULL;
 }
 
-void graph_free(Graph *g)
+Node * graph_get_node(Graph *g, unsigned int id)
 {
-    if (g) {
-        for (size_t i = 0; i < g->used; ++i) {
-            node_free(g->nodes[i]);
+    if (!g || !graph_build_map(g)) return NULL;
+    uint32_t i = idmap_find(g->map, id);
+    return i != IDMAP_NONE ? g->nodes[i] : NULL;
+}
+
+Csr * graph_freeze(Graph *g)
+{
+    if (!g || g->used > UINT32_MAX) return NULL;
+    graph_sort(g);
+    /* Edges refer to identifiers, which the map turns into indices. */
+    if (!graph_build_map(g)) return NULL;
+
+    size_t edges_num = 0;
+    for (size_t i = 0; i < g->used; i++) {
+        g->nodes[i]->index = i;
+        edges_num += g->nodes[i]->edges_num;
+    }
+    if (edges_num > UINT32_MAX) return NULL;
+
+    Csr *csr = csr_new(g->used, edges_num);
+    if (!csr) return NULL;
+
+    uint32_t e = 0;
+    for (size_t i = 0; i < g->used; i++) {
+        const Node *n = g->nodes[i];
+        csr->ids[i] = n->id;
+        csr->offsets[i] = e;
+        for (unsigned int j = 0; j < n->edges_num; j++, e++) {
+            csr->targets[e] = idmap_find(g->map, n->edges[j].destination);
+            csr->weights[e] = n->edges[j].mindelay;
         }
-        free(g->nodes);
-        free(g);
     }
+    csr->offsets[g->used] = e;
+    /* Positions in the sorted array are the indices, so the map of the
+     * graph can be handed over. */
+    csr->idmap = g->map;
+    g->map = NULL;
+    csr->checksum = binfile_graph_checksum(csr);
+    if (!csr_compute_weight_stats(csr) || !csr_build_idmap(csr)) {
+        csr_free(csr);
+        return NULL;
+    }
+    return csr;
 }
 
-Node **graph_dup_data(Graph *g, size_t *len)
+size_t graph_memory(const Graph *g)
 {
-    if (!g || !len) return NULL;
-    *len = g->used;
-    Node **arr = malloc(*len * sizeof *arr);
-    return arr ? memcpy(arr, g->nodes, *len * sizeof *arr) : NULL;
+    if (!g) return 0;
+    return sizeof *g + g->size * sizeof *g->nodes
+        + arena_reserved(g->arena);
+}
+
+void graph_free(Graph *g)
+{
+    if (g) {
+        /* Nodes and edges live in the arena. */
+        arena_free(g->arena);
+        free(g->nodes);
+        idmap_free(g->map);
+        free(g);
+    }
 }
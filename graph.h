@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /**
  * Node is an opaque type. You can have a pointer to it, but the only thing
@@ -24,6 +25,12 @@ typedef struct node Node;
  */
 typedef struct graph Graph;
 
+/**
+ * Frozen, read-only copy of a graph in compressed sparse row layout.
+ * See csr.h for its definition and functions working with it.
+ */
+typedef struct csr Csr;
+
 /**
  * Representation of an edge.
  *
@@ -31,8 +38,10 @@ typedef struct graph Graph;
  * members is possible. However, make sure not to change the values.
  */
 struct edge {
-    /** Pointer to destination node of this edge. */
-    Node *destination;
+    /** Identifier of destination node of this edge. The node is retrieved
+     * by graph_get_node(); storing the identifier instead of a pointer
+     * halves the size of the structure. */
+    unsigned int destination;
     /** Minimum delay of this edge. */
     int mindelay;
 };
@@ -51,34 +60,27 @@ unsigned int    node_get_id(Node *n);
  * @param n     node to query
  * @return      number of outgoing edges
  */
-unsigned short  node_get_n_outgoing(Node *n);
+unsigned int    node_get_n_outgoing(Node *n);
 
 /**
- * Get array of outgoing edges.
- * The number of elements in this array is returned by node_get_n_outgoing().
+ * Get dense index of a node.
+ * The index is the position of the node in the graph ordered by id and is
+ * assigned by graph_freeze(). Before the graph is frozen the value is
+ * meaningless.
  *
  * @param n     node to query
- * @return      array of outgoing edges
+ * @return      dense node index
  */
-struct edge *   node_get_edges(Node *n);
+unsigned int    node_get_index(Node *n);
 
 /**
- * Get distance of this node from starting node.
- * Infinity is signalled by `UINT_MAX`.
- *
- * @param n     node to query
- * @return      total distance
- */
-unsigned int    node_get_distance(Node *n);
-
-/**
- * Get node on (already found) shortest path from which queried node was
- * visited. For starting and unreachable nodes this function returns NULL.
+ * Get array of outgoing edges.
+ * The number of elements in this array is returned by node_get_n_outgoing().
  *
  * @param n     node to query
- * @return      previous node or NULL
+ * @return      array of outgoing edges
  */
-Node *          node_get_previous(Node *n);
+struct edge *   node_get_edges(Node *n);
 
 /**
  * Create a new graph.
@@ -113,10 +115,10 @@ bool graph_insert_edge(Graph *g, unsigned int source, unsigned int dest,
 
 /**
  * Retrieve a node.
- * This function performs binary search, therefore needs the nodes to be
- * sorted. Sorting is done automatically if necessary. Inserting a node will
- * break the sorted property, so first node retrieval after insertion is going
- * to be slow.
+ * Nodes are found in constant time through a map of their identifiers. The
+ * map is built by the first retrieval after inserting nodes, so that call
+ * takes time proportional to the number of nodes. This function fails if
+ * there is no such node or memory runs out.
  *
  * @param g     graph to be searched
  * @param id    identifier of the node
@@ -124,8 +126,34 @@ bool graph_insert_edge(Graph *g, unsigned int source, unsigned int dest,
  */
 Node * graph_get_node(Graph *g, unsigned int id);
 
+/**
+ * Compact the graph into compressed sparse row layout.
+ * Nodes are sorted by id and numbered densely from zero, outgoing edges of
+ * all nodes are stored in contiguous arrays. Map of identifiers for
+ * csr_find() is built as well. The graph itself is not
+ * modified apart from sorting and can still be used, but edges inserted,
+ * changed or removed afterwards are not reflected in the returned structure.
+ *
+ * The result does not refer to the graph, free it with csr_free().
+ *
+ * @param g     graph to freeze
+ * @return      frozen graph or NULL on failure
+ */
+Csr * graph_freeze(Graph *g);
+
+/**
+ * Get amount of memory held by a graph.
+ * Map of identifiers is not included.
+ *
+ * @param g     graph to query
+ * @return      size of nodes, edges and their arrays in bytes
+ */
+size_t graph_memory(const Graph *g);
+
 /**
  * Free memory used by nodes and edges.
+ * Nodes and edges are allocated in large chunks, so this takes time
+ * proportional to their total size in chunks rather than to their number.
  *
  * @param g     graph to be freed
  */
@@ -0,0 +1,134 @@
+/**
+ * Functions for mapping node identifiers to dense indices.
+ *
+ * Hash table uses linear probing over a power of two number of slots, at
+ * most half of which are occupied. Each slot stores the identifier next to
+ * its position, so a lookup usually reads a single cache line.
+ *
+ * @file    idmap.c
+ */
+#include "idmap.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/** Identifiers are indexed directly if their range is at most this many
+ * times larger than their number. */
+#define DIRECT_DENSITY 4
+
+/** Slot of the hash table. */
+struct slot {
+    /** Identifier stored in the slot */
+    uint32_t id;
+    /** Position of the identifier, `IDMAP_NONE` for empty slots */
+    uint32_t index;
+};
+
+struct idmap {
+    /** Whether identifiers index `direct` rather than `slots` */
+    bool is_direct;
+    /** Lowest identifier */
+    uint32_t min;
+    /** Number of entries of `direct` or `slots` */
+    size_t size;
+    /** Position of identifier `min + i` at index `i` */
+    uint32_t *direct;
+    /** Hash table of identifiers */
+    struct slot *slots;
+};
+
+/**
+ * Compute slot where search for an identifier starts.
+ *
+ * @param m     map with a hash table
+ * @param id    identifier
+ * @return      index of the slot
+ */
+static inline size_t slot_of(const Idmap *m, uint32_t id)
+{
+    /* Fibonacci hashing spreads consecutive identifiers over the table. */
+    return (size_t) ((id * UINT64_C(0x9e3779b97f4a7c15)) >> 32) & (m->size - 1);
+}
+
+Idmap * idmap_new(const uint32_t *ids, size_t len)
+{
+    if (!ids && len > 0) return NULL;
+    Idmap *m = calloc(1, sizeof *m);
+    if (!m) return NULL;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (ids[i] < min) min = ids[i];
+        if (ids[i] > max) max = ids[i];
+    }
+    m->min = min;
+    uint64_t range = len > 0 ? (uint64_t) max - min + 1 : 0;
+
+    if (range <= (uint64_t) DIRECT_DENSITY * len) {
+        m->is_direct = true;
+        m->size = range;
+        m->direct = malloc((range + 1) * sizeof *m->direct);
+        if (!m->direct) {
+            idmap_free(m);
+            return NULL;
+        }
+        for (size_t i = 0; i < range; i++) {
+            m->direct[i] = IDMAP_NONE;
+        }
+        for (size_t i = len; i > 0; i--) {
+            m->direct[ids[i - 1] - min] = i - 1;
+        }
+        return m;
+    }
+
+    m->size = 1;
+    while (m->size < 2 * len) {
+        m->size *= 2;
+    }
+    m->slots = malloc(m->size * sizeof *m->slots);
+    if (!m->slots) {
+        idmap_free(m);
+        return NULL;
+    }
+    for (size_t i = 0; i < m->size; i++) {
+        m->slots[i].index = IDMAP_NONE;
+    }
+    for (size_t i = 0; i < len; i++) {
+        size_t s = slot_of(m, ids[i]);
+        while (m->slots[s].index != IDMAP_NONE && m->slots[s].id != ids[i]) {
+            s = (s + 1) & (m->size - 1);
+        }
+        if (m->slots[s].index == IDMAP_NONE) {
+            m->slots[s].id = ids[i];
+            m->slots[s].index = i;
+        }
+    }
+    return m;
+}
+
+uint32_t idmap_find(const Idmap *m, uint32_t id)
+{
+    if (!m) return IDMAP_NONE;
+    if (m->is_direct) {
+        /* Identifiers below the minimum wrap around above the range. */
+        uint32_t offset = id - m->min;
+        return offset < m->size ? m->direct[offset] : IDMAP_NONE;
+    }
+    size_t s = slot_of(m, id);
+    while (m->slots[s].index != IDMAP_NONE) {
+        if (m->slots[s].id == id) {
+            return m->slots[s].index;
+        }
+        s = (s + 1) & (m->size - 1);
+    }
+    return IDMAP_NONE;
+}
+
+void idmap_free(Idmap *m)
+{
+    if (m) {
+        free(m->direct);
+        free(m->slots);
+    }
+    free(m);
+}
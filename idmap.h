@@ -0,0 +1,52 @@
+/**
+ * Interface for mapping node identifiers to dense indices.
+ *
+ * The map is built once from an array of identifiers and then answers each
+ * lookup in constant time. When identifiers fill most of the range between
+ * the lowest and the highest one, they index a plain array directly;
+ * otherwise they are kept in an open addressing hash table.
+ *
+ * @file    idmap.h
+ */
+#ifndef IDMAP_H
+#define IDMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Value returned by idmap_find() for unknown identifiers. */
+#define IDMAP_NONE UINT32_MAX
+
+/**
+ * Map is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct idmap Idmap;
+
+/**
+ * Build a map from identifiers to their positions in an array.
+ * If an identifier occurs more than once, its first position is used.
+ *
+ * @param ids   array of identifiers
+ * @param len   number of identifiers, less than `IDMAP_NONE`
+ * @return      new map or NULL if memory is exhausted
+ */
+Idmap * idmap_new(const uint32_t *ids, size_t len);
+
+/**
+ * Find position of an identifier.
+ *
+ * @param m     map to search
+ * @param id    identifier
+ * @return      position of the identifier or `IDMAP_NONE` if it is unknown
+ */
+uint32_t idmap_find(const Idmap *m, uint32_t id);
+
+/**
+ * Free a map.
+ *
+ * @param m     map to be freed
+ */
+void idmap_free(Idmap *m);
+
+#endif /* end of include guard: IDMAP_H */
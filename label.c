@@ -0,0 +1,669 @@
+/**
+ * Functions for distance queries answered by hub labels.
+ *
+ * While labels are built, each node keeps growing lists of entries. Hubs are
+ * processed in batches; searches of one batch read labels of earlier batches
+ * only and store what they find separately, which is appended to the labels
+ * after the whole batch finished. Hubs are appended in order of their rank,
+ * so entries of every label stay sorted.
+ *
+ * Label files start with a fixed size header followed by arrays `hubs`,
+ * `out_offsets`, `out`, `in_offsets` and `in`, laid out as described in
+ * binfile.h.
+ *
+ * @file    label.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "label.h"
+#include "binfile.h"
+#include "pq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Number of hubs processed one at a time before searches run in parallel.
+ * Labels of the first hubs prune all later searches the most. */
+#define SEQUENTIAL_HUBS 256
+/** Number of hubs of a parallel batch for each thread */
+#define HUBS_PER_WORKER 8
+
+/** Magic bytes identifying a label file */
+static const char LABEL_MAGIC[8] = "DIMEHUBL";
+
+/** Header of a label file. */
+struct label_header {
+    /** Always `LABEL_MAGIC` */
+    char magic[8];
+    /** Format version */
+    uint32_t version;
+    /** Always `BINFILE_BYTE_ORDER` in byte order of the writer */
+    uint32_t byte_order;
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Always zero */
+    uint32_t reserved;
+    /** Checksum of the graph, see binfile_graph_checksum() */
+    uint64_t graph_checksum;
+    /** Number of entries of outgoing and incoming labels */
+    uint64_t out_num;
+    uint64_t in_num;
+    /** File positions of the arrays */
+    uint64_t hubs_pos;
+    uint64_t out_offsets_pos;
+    uint64_t out_pos;
+    uint64_t in_offsets_pos;
+    uint64_t in_pos;
+    /** Total size of the file */
+    uint64_t file_size;
+    /** Checksum of everything after the header */
+    uint64_t data_checksum;
+    /** Checksum of the header with this member set to zero */
+    uint64_t header_checksum;
+};
+
+/** Growing label of a node. */
+struct entries {
+    struct label_entry *data;
+    uint32_t len;
+    uint32_t size;
+};
+
+/** Node reached by a search from a hub and not covered by earlier hubs. */
+struct reached {
+    /** Index of the node */
+    uint32_t node;
+    /** Distance between the hub and the node */
+    uint32_t dist;
+};
+
+/** Nodes found by one search of a batch. */
+struct found {
+    struct reached *data;
+    size_t len;
+    size_t size;
+};
+
+/** State of pruned searches owned by one thread. */
+struct labeler {
+    /** Epoch of current search, see search.c */
+    uint32_t epoch;
+    /** Epoch in which distance of each node was last written */
+    uint32_t *stamp;
+    /** Distance of each node from the hub */
+    uint32_t *dist;
+    /** Distance between the hub and each hub of its label by rank,
+     * `UINT32_MAX` for other ranks */
+    uint32_t *hub_dist;
+    /** Queue of reached but unfinished nodes */
+    Pq *queue;
+    /** Whether memory ran out */
+    bool failed;
+};
+
+/** Labels being built and state shared by all threads. */
+struct builder {
+    /** Graph with reverse edges */
+    const Csr *csr;
+    /** Index of the node of each rank */
+    uint32_t *hubs;
+    /** Outgoing and incoming label of each node */
+    struct entries *out;
+    struct entries *in;
+    /** State of each thread */
+    struct labeler *workers;
+    size_t workers_num;
+    /** Nodes found by each search of current batch; search `2 * i` goes
+     * forward and search `2 * i + 1` backward from hub `first + i` */
+    struct found *found;
+    size_t found_num;
+    /** Rank of the first hub of current batch */
+    uint32_t first;
+};
+
+/**
+ * Get number of edges of a node in both directions.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param node  index of the node
+ * @return      number of outgoing and incoming edges
+ */
+static uint64_t degree(const Csr *csr, uint32_t node)
+{
+    return (uint64_t) csr->offsets[node + 1] - csr->offsets[node]
+        + csr->rev_offsets[node + 1] - csr->rev_offsets[node];
+}
+
+/** Node with its degree, used to order hubs. */
+struct ranked {
+    uint64_t degree;
+    uint32_t node;
+};
+
+/**
+ * Compare nodes by decreasing degree, ties by index.
+ *
+ * @param a     first struct ranked
+ * @param b     second struct ranked
+ * @return      negative, zero or positive as for qsort()
+ */
+static int compare_ranked(const void *a, const void *b)
+{
+    const struct ranked *x = a;
+    const struct ranked *y = b;
+    if (x->degree != y->degree) return x->degree > y->degree ? -1 : 1;
+    return (x->node > y->node) - (x->node < y->node);
+}
+
+/**
+ * Order nodes by decreasing degree.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param hubs  array to be filled with the node of each rank
+ * @return      true if successful, false if memory ran out
+ */
+static bool order_hubs(const Csr *csr, uint32_t *hubs)
+{
+    struct ranked *r = malloc(((size_t) csr->nodes_num + 1) * sizeof *r);
+    if (!r) return false;
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        r[i].degree = degree(csr, i);
+        r[i].node = i;
+    }
+    qsort(r, csr->nodes_num, sizeof *r, compare_ranked);
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        hubs[i] = r[i].node;
+    }
+    free(r);
+    return true;
+}
+
+/**
+ * Check whether labels of earlier hubs give a distance.
+ *
+ * @param hub_dist  distance between the hub and hubs of its label by rank
+ * @param label     label of the other node in the opposite direction
+ * @param dist      distance between the hub and the other node
+ * @return          true if some earlier hub gives the distance or a shorter
+ *                  one
+ */
+static bool covered(const uint32_t *hub_dist, const struct entries *label,
+        uint32_t dist)
+{
+    for (uint32_t i = 0; i < label->len; i++) {
+        uint32_t via = hub_dist[label->data[i].hub];
+        if (via != UINT32_MAX
+                && (uint64_t) via + label->data[i].dist <= dist) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Run pruned search from a hub.
+ * Nodes whose distance is given by labels of earlier hubs are neither
+ * recorded nor expanded.
+ *
+ * @param b         builder
+ * @param w         state of the thread
+ * @param f         where to store found nodes
+ * @param rank      rank of the hub
+ * @param backward  find distances to the hub along reverse edges
+ */
+static void label_search(const struct builder *b, struct labeler *w,
+        struct found *f, uint32_t rank, bool backward)
+{
+    const Csr *csr = b->csr;
+    const uint32_t *offsets = backward ? csr->rev_offsets : csr->offsets;
+    const uint32_t *ends = backward ? csr->rev_sources : csr->targets;
+    const int32_t *weights = backward ? csr->rev_weights : csr->weights;
+    uint32_t hub = b->hubs[rank];
+    /* Distance from hub to v is covered by out(hub) and in(v). */
+    const struct entries *own = backward ? &b->in[hub] : &b->out[hub];
+    const struct entries *other = backward ? b->out : b->in;
+
+    for (uint32_t i = 0; i < own->len; i++) {
+        w->hub_dist[own->data[i].hub] = own->data[i].dist;
+    }
+    if (++w->epoch == 0) {
+        memset(w->stamp, 0, (size_t) csr->nodes_num * sizeof *w->stamp);
+        w->epoch = 1;
+    }
+    f->len = 0;
+    pq_clear(w->queue);
+    w->stamp[hub] = w->epoch;
+    w->dist[hub] = 0;
+    bool ok = pq_push(w->queue, hub, 0);
+    uint32_t current, dist;
+    while (ok && pq_pop(w->queue, &current, &dist)) {
+        if (covered(w->hub_dist, &other[current], dist)) continue;
+        if (f->len == f->size) {
+            size_t size = f->size ? 2 * f->size : 64;
+            struct reached *data = realloc(f->data, size * sizeof *data);
+            if (!data) {
+                ok = false;
+                break;
+            }
+            f->data = data;
+            f->size = size;
+        }
+        f->data[f->len].node = current;
+        f->data[f->len].dist = dist;
+        f->len++;
+        for (uint32_t e = offsets[current]; ok && e < offsets[current + 1];
+                e++) {
+            uint32_t next = ends[e];
+            uint32_t alt = dist + weights[e];
+            if (w->stamp[next] != w->epoch) {
+                w->stamp[next] = w->epoch;
+                w->dist[next] = alt;
+                ok = pq_push(w->queue, next, alt);
+            } else if (alt < w->dist[next]) {
+                w->dist[next] = alt;
+                ok = pq_decrease(w->queue, next, alt);
+            }
+        }
+    }
+    if (!ok) w->failed = true;
+    for (uint32_t i = 0; i < own->len; i++) {
+        w->hub_dist[own->data[i].hub] = UINT32_MAX;
+    }
+}
+
+/**
+ * Run one search of current batch, called from the thread pool.
+ *
+ * @param arg       shared struct builder
+ * @param worker    index of the thread
+ * @param task      index of the search
+ */
+static void label_task(void *arg, size_t worker, size_t task)
+{
+    struct builder *b = arg;
+    label_search(b, &b->workers[worker], &b->found[task],
+            b->first + task / 2, task % 2 == 1);
+}
+
+/**
+ * Append an entry to a label.
+ *
+ * @param label growing label
+ * @param hub   rank of the hub, higher than ranks in the label
+ * @param dist  distance between the node and the hub
+ * @return      true if successful, false if memory ran out
+ */
+static bool append_entry(struct entries *label, uint32_t hub, uint32_t dist)
+{
+    if (label->len == label->size) {
+        uint32_t size = label->size ? 2 * label->size : 4;
+        struct label_entry *data = realloc(label->data,
+                (size_t) size * sizeof *data);
+        if (!data) return false;
+        label->data = data;
+        label->size = size;
+    }
+    label->data[label->len].hub = hub;
+    label->data[label->len].dist = dist;
+    label->len++;
+    return true;
+}
+
+/**
+ * Append nodes found by searches of current batch to their labels.
+ *
+ * @param b     builder
+ * @param hubs  number of hubs in the batch
+ * @return      true if successful, false if memory ran out
+ */
+static bool commit_batch(struct builder *b, uint32_t hubs)
+{
+    for (size_t t = 0; t < 2 * (size_t) hubs; t++) {
+        const struct found *f = &b->found[t];
+        /* Forward search gives distances from the hub. */
+        struct entries *labels = t % 2 == 1 ? b->out : b->in;
+        uint32_t rank = b->first + t / 2;
+        for (size_t i = 0; i < f->len; i++) {
+            if (!append_entry(&labels[f->data[i].node], rank,
+                        f->data[i].dist)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Free a builder.
+ *
+ * @param b     builder to be freed
+ */
+static void builder_free(struct builder *b)
+{
+    for (uint32_t i = 0; b->out && i < b->csr->nodes_num; i++) {
+        free(b->out[i].data);
+    }
+    for (uint32_t i = 0; b->in && i < b->csr->nodes_num; i++) {
+        free(b->in[i].data);
+    }
+    for (size_t t = 0; b->workers && t < b->workers_num; t++) {
+        free(b->workers[t].stamp);
+        free(b->workers[t].dist);
+        free(b->workers[t].hub_dist);
+        pq_free(b->workers[t].queue);
+    }
+    for (size_t t = 0; b->found && t < b->found_num; t++) {
+        free(b->found[t].data);
+    }
+    free(b->hubs);
+    free(b->out);
+    free(b->in);
+    free(b->workers);
+    free(b->found);
+}
+
+/**
+ * Prepare a builder for a graph.
+ *
+ * @param b         builder to be initialized
+ * @param csr       frozen graph with reverse edges
+ * @param workers   number of threads
+ * @return          true if successful, false if memory ran out
+ */
+static bool builder_init(struct builder *b, const Csr *csr, size_t workers)
+{
+    memset(b, 0, sizeof *b);
+    size_t n = (size_t) csr->nodes_num + 1;
+    b->csr = csr;
+    b->hubs = malloc(n * sizeof *b->hubs);
+    b->out = calloc(n, sizeof *b->out);
+    b->in = calloc(n, sizeof *b->in);
+    b->workers = calloc(workers, sizeof *b->workers);
+    b->workers_num = workers;
+    b->found_num = workers > 1 ? 2 * HUBS_PER_WORKER * workers : 2;
+    b->found = calloc(b->found_num, sizeof *b->found);
+    if (!b->hubs || !b->out || !b->in || !b->workers || !b->found) {
+        return false;
+    }
+    for (size_t t = 0; t < workers; t++) {
+        struct labeler *w = &b->workers[t];
+        w->stamp = calloc(n, sizeof *w->stamp);
+        w->dist = malloc(n * sizeof *w->dist);
+        w->hub_dist = malloc(n * sizeof *w->hub_dist);
+        w->queue = pq_new(PQ_BINARY, csr->nodes_num, 0);
+        if (!w->stamp || !w->dist || !w->hub_dist || !w->queue) {
+            return false;
+        }
+        memset(w->hub_dist, 0xff, n * sizeof *w->hub_dist);
+    }
+    return order_hubs(csr, b->hubs);
+}
+
+/**
+ * Move growing labels into compact arrays.
+ * Each growing label is freed as soon as it is copied.
+ *
+ * @param labels    growing labels of all nodes
+ * @param nodes_num number of nodes
+ * @param[out] offsets  first entry of each label
+ * @param[out] entries  entries of all labels
+ * @return          true if successful, false if memory ran out
+ */
+static bool compact(struct entries *labels, uint32_t nodes_num,
+        uint64_t **offsets, struct label_entry **entries)
+{
+    uint64_t total = 0;
+    *offsets = malloc(((size_t) nodes_num + 1) * sizeof **offsets);
+    if (!*offsets) return false;
+    for (uint32_t i = 0; i < nodes_num; i++) {
+        (*offsets)[i] = total;
+        total += labels[i].len;
+    }
+    (*offsets)[nodes_num] = total;
+    *entries = malloc(((size_t) total + 1) * sizeof **entries);
+    if (!*entries) return false;
+    for (uint32_t i = 0; i < nodes_num; i++) {
+        if (labels[i].len > 0) {
+            memcpy(*entries + (*offsets)[i], labels[i].data,
+                    (size_t) labels[i].len * sizeof **entries);
+        }
+        free(labels[i].data);
+        labels[i].data = NULL;
+    }
+    return true;
+}
+
+Labels * label_build(Csr *csr, Pool *pool)
+{
+    if (!csr || csr->min_weight < 0 || !csr_build_reverse(csr)) return NULL;
+    size_t workers = pool_size(pool);
+    struct builder b;
+    bool ok = builder_init(&b, csr, workers);
+
+    while (ok && b.first < csr->nodes_num) {
+        /* Searches of one thread would only see less of the labels. */
+        uint32_t hubs = b.found_num / 2;
+        if (b.first < SEQUENTIAL_HUBS) hubs = 1;
+        if (hubs > csr->nodes_num - b.first) hubs = csr->nodes_num - b.first;
+        pool_run(workers > 1 ? pool : NULL, 2 * (size_t) hubs, label_task,
+                &b);
+        for (size_t t = 0; t < workers; t++) {
+            ok = ok && !b.workers[t].failed;
+        }
+        ok = ok && commit_batch(&b, hubs);
+        b.first += hubs;
+    }
+
+    Labels *l = ok ? calloc(1, sizeof *l) : NULL;
+    if (l) {
+        l->nodes_num = csr->nodes_num;
+        l->hubs = b.hubs;
+        b.hubs = NULL;
+        if (!compact(b.out, csr->nodes_num, &l->out_offsets, &l->out)
+                || !compact(b.in, csr->nodes_num, &l->in_offsets, &l->in)) {
+            label_free(l);
+            l = NULL;
+        }
+    }
+    builder_free(&b);
+    return l;
+}
+
+/**
+ * Compute checksum of the header.
+ *
+ * @param hdr   header to be hashed
+ * @return      checksum
+ */
+static uint64_t header_checksum(const struct label_header *hdr)
+{
+    struct label_header tmp = *hdr;
+    tmp.header_checksum = 0;
+    return binfile_checksum(BINFILE_CHECKSUM_INIT, &tmp, sizeof tmp);
+}
+
+bool label_save(const Labels *l, const Csr *csr, const char *path)
+{
+    if (!l || !csr || !path || l->nodes_num != csr->nodes_num) return false;
+    struct label_header hdr;
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, LABEL_MAGIC, sizeof hdr.magic);
+    hdr.version = LABEL_VERSION;
+    hdr.byte_order = BINFILE_BYTE_ORDER;
+    hdr.nodes_num = l->nodes_num;
+    hdr.graph_checksum = csr->checksum;
+    hdr.out_num = l->out_offsets[l->nodes_num];
+    hdr.in_num = l->in_offsets[l->nodes_num];
+
+    size_t offsets_len = ((size_t) l->nodes_num + 1) * sizeof *l->out_offsets;
+    const void *data[5] = {
+        l->hubs, l->out_offsets, l->out, l->in_offsets, l->in
+    };
+    size_t lens[5] = {
+        (size_t) l->nodes_num * sizeof *l->hubs,
+        offsets_len,
+        (size_t) hdr.out_num * sizeof *l->out,
+        offsets_len,
+        (size_t) hdr.in_num * sizeof *l->in,
+    };
+    uint64_t *pos[5] = {
+        &hdr.hubs_pos, &hdr.out_offsets_pos, &hdr.out_pos,
+        &hdr.in_offsets_pos, &hdr.in_pos
+    };
+    uint64_t at = binfile_align(sizeof hdr);
+    for (int i = 0; i < 5; i++) {
+        *pos[i] = at;
+        at += binfile_align(lens[i]);
+    }
+    hdr.file_size = at;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    /* Header is written twice, the second time with checksums filled in. */
+    bool ok = binfile_write_section(f, &hdr, sizeof hdr, NULL);
+    hdr.data_checksum = BINFILE_CHECKSUM_INIT;
+    for (int i = 0; ok && i < 5; i++) {
+        ok = binfile_write_section(f, data[i], lens[i], &hdr.data_checksum);
+    }
+    hdr.header_checksum = header_checksum(&hdr);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0
+        && fwrite(&hdr, sizeof hdr, 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+/**
+ * Check header of a mapped label file.
+ *
+ * @param hdr   header of the file
+ * @param size  real size of the file
+ * @param csr   graph the labels should belong to
+ * @return      true if the header describes usable labels
+ */
+static bool header_valid(const struct label_header *hdr, size_t size,
+        const Csr *csr)
+{
+    if (memcmp(hdr->magic, LABEL_MAGIC, sizeof hdr->magic) != 0
+            || hdr->byte_order != BINFILE_BYTE_ORDER
+            || hdr->version != LABEL_VERSION
+            || hdr->header_checksum != header_checksum(hdr)
+            || hdr->file_size != size
+            || !binfile_graph_matches(csr, hdr->nodes_num,
+                hdr->graph_checksum)
+            || hdr->out_num > size || hdr->in_num > size) {
+        return false;
+    }
+    uint64_t offsets_len = ((uint64_t) hdr->nodes_num + 1) * 8;
+    return binfile_section_valid(sizeof *hdr, size, hdr->hubs_pos,
+                (uint64_t) hdr->nodes_num * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->out_offsets_pos,
+                offsets_len)
+        && binfile_section_valid(sizeof *hdr, size, hdr->out_pos,
+                hdr->out_num * 8)
+        && binfile_section_valid(sizeof *hdr, size, hdr->in_offsets_pos,
+                offsets_len)
+        && binfile_section_valid(sizeof *hdr, size, hdr->in_pos,
+                hdr->in_num * 8);
+}
+
+/**
+ * Check that offsets of labels stay within their entries.
+ *
+ * @param offsets   first entry of each label, `nodes_num + 1` elements
+ * @param nodes_num number of nodes
+ * @param total     number of entries
+ * @return          true if the offsets are valid
+ */
+static bool offsets_valid(const uint64_t *offsets, uint32_t nodes_num,
+        uint64_t total)
+{
+    if (offsets[0] != 0 || offsets[nodes_num] != total) return false;
+    for (uint32_t i = 0; i < nodes_num; i++) {
+        if (offsets[i] > offsets[i + 1]) return false;
+    }
+    return true;
+}
+
+Labels * label_open(const Csr *csr, const char *path, bool verify)
+{
+    if (!csr) return NULL;
+    size_t size;
+    void *map = binfile_map(path, sizeof(struct label_header), &size);
+    if (!map) return NULL;
+    const struct label_header *hdr = map;
+    const char *base = map;
+    size_t data_pos = binfile_align(sizeof *hdr);
+    if (!header_valid(hdr, size, csr) || (verify && hdr->data_checksum
+                != binfile_checksum(BINFILE_CHECKSUM_INIT, base + data_pos,
+                    size - data_pos))) {
+        munmap(map, size);
+        return NULL;
+    }
+    Labels *l = calloc(1, sizeof *l);
+    if (!l) {
+        munmap(map, size);
+        return NULL;
+    }
+    l->map = map;
+    l->map_size = size;
+    l->nodes_num = hdr->nodes_num;
+    /* The mapping is read-only, see snapshot_open(). */
+    l->hubs = (uint32_t *) (base + hdr->hubs_pos);
+    l->out_offsets = (uint64_t *) (base + hdr->out_offsets_pos);
+    l->out = (struct label_entry *) (base + hdr->out_pos);
+    l->in_offsets = (uint64_t *) (base + hdr->in_offsets_pos);
+    l->in = (struct label_entry *) (base + hdr->in_pos);
+    if (!offsets_valid(l->out_offsets, l->nodes_num, hdr->out_num)
+            || !offsets_valid(l->in_offsets, l->nodes_num, hdr->in_num)) {
+        label_free(l);
+        return NULL;
+    }
+    return l;
+}
+
+uint32_t label_distance(const Labels *l, uint32_t source,
+        uint32_t destination)
+{
+    const struct label_entry *a = l->out + l->out_offsets[source];
+    const struct label_entry *a_end = l->out + l->out_offsets[source + 1];
+    const struct label_entry *b = l->in + l->in_offsets[destination];
+    const struct label_entry *b_end = l->in + l->in_offsets[destination + 1];
+    uint64_t best = UINT32_MAX;
+    while (a < a_end && b < b_end) {
+        if (a->hub < b->hub) {
+            a++;
+        } else if (a->hub > b->hub) {
+            b++;
+        } else {
+            uint64_t dist = (uint64_t) a->dist + b->dist;
+            if (dist < best) best = dist;
+            a++;
+            b++;
+        }
+    }
+    return best;
+}
+
+uint64_t label_entries(const Labels *l)
+{
+    return l->out_offsets[l->nodes_num] + l->in_offsets[l->nodes_num];
+}
+
+void label_free(Labels *l)
+{
+    if (l) {
+        if (l->map) {
+            munmap(l->map, l->map_size);
+        } else {
+            free(l->hubs);
+            free(l->out_offsets);
+            free(l->out);
+            free(l->in_offsets);
+            free(l->in);
+        }
+    }
+    free(l);
+}
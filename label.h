@@ -0,0 +1,137 @@
+/**
+ * Interface for distance queries answered by hub labels.
+ *
+ * Every node gets two labels: hubs it can reach with its distance to each of
+ * them (outgoing label) and hubs that can reach it with their distance to it
+ * (incoming label). Labels are built so that for every pair of nodes some
+ * hub on a shortest path between them is in the outgoing label of the first
+ * node and in the incoming label of the second one. The distance is then the
+ * minimum of sums over hubs common to both labels, found by merging the two
+ * labels sorted by hub.
+ *
+ * Labels are built by pruned landmark labeling: nodes are taken as hubs in
+ * order of decreasing degree and a search from each hub stops at nodes whose
+ * distance from (or to) the hub is already given by labels of earlier hubs.
+ * Hubs with many edges lie on many shortest paths, so later searches stay
+ * small and labels stay short. Searches of several hubs run in parallel
+ * after the first hubs; they only see labels of earlier batches, which adds
+ * a few unnecessary entries but keeps the result correct.
+ *
+ * Only graphs without negative edge weights can be labeled.
+ *
+ * @file    label.h
+ */
+#ifndef LABEL_H
+#define LABEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pool.h"
+
+/** Version of the label file format written by this program. */
+#define LABEL_VERSION 1
+
+/** Entry of a label. */
+struct label_entry {
+    /** Rank of the hub, lower ranks were processed first */
+    uint32_t hub;
+    /** Distance between the node and the hub */
+    uint32_t dist;
+};
+
+/** Hub labels of all nodes of a graph. */
+typedef struct labels Labels;
+
+/**
+ * Representation of hub labels.
+ *
+ * Labels of all nodes are stored one after another like edges of a frozen
+ * graph, entries of each label are sorted by hub.
+ */
+struct labels {
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Index of the node of each rank */
+    uint32_t *hubs;
+    /** First entry of the outgoing label of each node, `nodes_num + 1`
+     * elements */
+    uint64_t *out_offsets;
+    /** Entries of outgoing labels, distances from the nodes to the hubs */
+    struct label_entry *out;
+    /** First entry of the incoming label of each node, `nodes_num + 1`
+     * elements */
+    uint64_t *in_offsets;
+    /** Entries of incoming labels, distances from the hubs to the nodes */
+    struct label_entry *in;
+    /** Memory mapping holding the arrays, NULL if they were allocated */
+    void *map;
+    /** Size of the memory mapping */
+    size_t map_size;
+};
+
+/**
+ * Build hub labels of a graph.
+ * Reverse edges of the graph are built if they do not exist yet.
+ *
+ * @param csr   frozen graph without negative edge weights
+ * @param pool  threads running searches from hubs, may be NULL
+ * @return      labels or NULL if memory ran out or the graph has negative
+ *              weights
+ */
+Labels * label_build(Csr *csr, Pool *pool);
+
+/**
+ * Write labels into a file.
+ * The file records checksum of the graph and can only be opened with the
+ * same graph. Existing file is overwritten.
+ *
+ * @param l     labels to be stored
+ * @param csr   graph the labels were built for
+ * @param path  name of the file
+ * @return      true if successful, false otherwise
+ */
+bool label_save(const Labels *l, const Csr *csr, const char *path);
+
+/**
+ * Open a label file.
+ * The file is mapped read-only into memory.
+ *
+ * @param csr       graph the labels were built for
+ * @param path      name of the file
+ * @param verify    whether to verify checksum of the data
+ * @return          labels or NULL if the file does not exist, is damaged or
+ *                  belongs to a different graph
+ */
+Labels * label_open(const Csr *csr, const char *path, bool verify);
+
+/**
+ * Find distance between two nodes.
+ *
+ * @param l             labels of the graph
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              distance or `UINT32_MAX` if the destination is not
+ *                      reachable
+ */
+uint32_t label_distance(const Labels *l, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Get number of entries of all labels.
+ *
+ * @param l     labels to query
+ * @return      total number of entries of outgoing and incoming labels
+ */
+uint64_t label_entries(const Labels *l);
+
+/**
+ * Free labels.
+ *
+ * @param l     labels to be freed
+ */
+void label_free(Labels *l);
+
+#endif /* end of include guard: LABEL_H */
@@ -0,0 +1,714 @@
+/**
+ * Functions for reading DIMES CSV files.
+ *
+ * Every thread parses one chunk of the mapped file into its own arrays.
+ * Line boundaries are found with memchr(), which is vectorized in common C
+ * libraries, and numbers are converted by a small scanner that validates the
+ * whole field instead of silently accepting garbage like atoi() does.
+ *
+ * @file    loader.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "loader.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Maximum number of chunks a file is split into */
+#define MAX_CHUNKS 64
+/** Chunks are not made smaller than this number of bytes */
+static const size_t MIN_CHUNK_SIZE = 1 << 20;
+/** Number of malformed lines reported individually */
+static const size_t MAX_REPORTED = 20;
+/** Column holding minimum delay in a file with edges */
+#define DELAY_COLUMN 3
+/** Edges are merged by one thread per this many edges at least */
+static const size_t MIN_MERGE_PART = 1 << 16;
+
+/** Names of policies indexed by enum loader_duplicates */
+static const char *DUPLICATES_NAMES[LOADER_KEEP_KINDS] = {
+    "min", "median", "last", "all"
+};
+
+/** Work and results of a single thread. */
+struct chunk {
+    /** First byte of the chunk */
+    const char *begin;
+    /** Byte after the last byte of the chunk */
+    const char *end;
+    /** Whether the file contains edges rather than nodes */
+    bool edges;
+    /** Number of lines in the chunk */
+    size_t lines;
+    /** Number of parsed records */
+    size_t len;
+    /** Capacity of record arrays */
+    size_t size;
+    /** Parsed columns, only first one is used for nodes */
+    uint32_t *first;
+    uint32_t *second;
+    int32_t *delay;
+    /** Line numbers (relative to the chunk) of malformed lines */
+    size_t *bad;
+    size_t bad_len;
+    size_t bad_size;
+    /** Set if memory ran out */
+    bool no_memory;
+};
+
+/**
+ * Parse one numeric field.
+ * The field may be surrounded by spaces and must end with a comma or at the
+ * end of the line. A fractional part is cut off, as atoi() did with delays
+ * exported with decimals.
+ *
+ * @param p         start of the field, updated to point after the comma
+ * @param end       end of the line
+ * @param sign      whether a minus sign and a fractional part are allowed
+ * @param[out] out  parsed value
+ * @return          true if the field is a valid number
+ */
+static bool parse_number(const char **p, const char *end, bool sign,
+        int64_t *out)
+{
+    const char *s = *p;
+    while (s < end && *s == ' ') s++;
+    bool negative = false;
+    if (sign && s < end && *s == '-') {
+        negative = true;
+        s++;
+    }
+    const char *digits = s;
+    uint64_t val = 0;
+    while (s < end && (unsigned) (*s - '0') < 10) {
+        val = val * 10 + (*s - '0');
+        if (val > UINT32_MAX) return false;
+        s++;
+    }
+    if (s == digits) return false;
+    if (sign && s < end && *s == '.') {
+        do {
+            s++;
+        } while (s < end && (unsigned) (*s - '0') < 10);
+    }
+    while (s < end && *s == ' ') s++;
+    if (s < end) {
+        if (*s != ',') return false;
+        s++;
+    }
+    *p = s;
+    *out = negative ? -(int64_t) val : (int64_t) val;
+    return true;
+}
+
+/**
+ * Skip one field of a line.
+ *
+ * @param p     start of the field, updated to point after the comma
+ * @param end   end of the line
+ * @return      true if there was a comma after the field
+ */
+static bool skip_field(const char **p, const char *end)
+{
+    const char *comma = memchr(*p, ',', end - *p);
+    *p = comma ? comma + 1 : end;
+    return comma != NULL;
+}
+
+/**
+ * Parse a single line.
+ *
+ * @param c     chunk which the line belongs to
+ * @param p     first character of the line
+ * @param end   end of the line (without line terminator)
+ * @param rec   where to store parsed columns
+ * @return      true if the line is valid
+ */
+static bool parse_line(const struct chunk *c, const char *p, const char *end,
+        int64_t rec[3])
+{
+    if (!c->edges) {
+        return parse_number(&p, end, false, &rec[0]);
+    }
+    bool more = true;
+    for (int col = 0; col <= DELAY_COLUMN; col++) {
+        if (!more) return false;
+        const char *field = p;
+        if (col == 2) {
+            more = skip_field(&p, end);
+            continue;
+        }
+        if (!parse_number(&p, end, col == DELAY_COLUMN,
+                    &rec[col < 2 ? col : 2])) {
+            return false;
+        }
+        more = p > field && p[-1] == ',';
+    }
+    return rec[2] >= INT32_MIN && rec[2] <= INT32_MAX;
+}
+
+/**
+ * Append parsed record to the chunk.
+ *
+ * @param c     chunk to append to
+ * @param rec   parsed columns
+ * @return      true if successful, false if memory ran out
+ */
+static bool chunk_push(struct chunk *c, const int64_t rec[3])
+{
+    if (c->len >= c->size) {
+        size_t size = c->size ? c->size * 2 : 1024;
+        uint32_t *first = realloc(c->first, size * sizeof *first);
+        if (!first) return false;
+        c->first = first;
+        if (c->edges) {
+            uint32_t *second = realloc(c->second, size * sizeof *second);
+            if (!second) return false;
+            c->second = second;
+            int32_t *delay = realloc(c->delay, size * sizeof *delay);
+            if (!delay) return false;
+            c->delay = delay;
+        }
+        c->size = size;
+    }
+    c->first[c->len] = rec[0];
+    if (c->edges) {
+        c->second[c->len] = rec[1];
+        c->delay[c->len] = rec[2];
+    }
+    c->len++;
+    return true;
+}
+
+/**
+ * Remember a malformed line.
+ *
+ * @param c     chunk the line belongs to
+ * @return      true if successful, false if memory ran out
+ */
+static bool chunk_bad_line(struct chunk *c)
+{
+    if (c->bad_len >= c->bad_size) {
+        size_t size = c->bad_size ? c->bad_size * 2 : 16;
+        size_t *tmp = realloc(c->bad, size * sizeof *tmp);
+        if (!tmp) return false;
+        c->bad = tmp;
+        c->bad_size = size;
+    }
+    c->bad[c->bad_len++] = c->lines;
+    return true;
+}
+
+/**
+ * Parse all lines of a chunk. This is the thread entry point.
+ *
+ * @param arg   chunk to be parsed
+ * @return      NULL
+ */
+static void * parse_chunk(void *arg)
+{
+    struct chunk *c = arg;
+    const char *p = c->begin;
+    int64_t rec[3];
+    while (p < c->end) {
+        const char *nl = memchr(p, '\n', c->end - p);
+        const char *end = nl ? nl : c->end;
+        const char *next = nl ? nl + 1 : c->end;
+        c->lines++;
+        if (end > p && end[-1] == '\r') end--;
+        if (end > p) {
+            bool ok = parse_line(c, p, end, rec) ? chunk_push(c, rec)
+                : chunk_bad_line(c);
+            if (!ok) {
+                c->no_memory = true;
+                return NULL;
+            }
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+/**
+ * Find number of chunks to split work into.
+ *
+ * @param size      amount of work, like size of a file
+ * @param min_size  smallest amount worth a thread
+ * @return          number of chunks
+ */
+static size_t chunks_for(size_t size, size_t min_size)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t n = cpus > 0 ? (size_t) cpus : 1;
+    if (n > MAX_CHUNKS) n = MAX_CHUNKS;
+    if (n > size / min_size) n = size / min_size;
+    return n ? n : 1;
+}
+
+/**
+ * Map a file, parse it in parallel and report malformed lines.
+ * On success the caller must free arrays of all chunks with chunks_free().
+ *
+ * @param path          name of the file
+ * @param edges         whether the file contains edges
+ * @param chunks        array of `MAX_CHUNKS` chunks
+ * @param[out] num      number of used chunks
+ * @return              status of the operation
+ */
+static enum loader_status read_file(const char *path, bool edges,
+        struct chunk *chunks, size_t *num)
+{
+    memset(chunks, 0, MAX_CHUNKS * sizeof *chunks);
+    *num = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return LOADER_NO_FILE;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return LOADER_NO_FILE;
+    }
+    size_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return LOADER_OK;
+    }
+    char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return LOADER_NO_FILE;
+    posix_madvise(map, size, POSIX_MADV_WILLNEED);
+
+    /* Split the file into chunks of similar size ending after a newline. */
+    size_t n = chunks_for(size, MIN_CHUNK_SIZE);
+    const char *begin = map;
+    for (size_t i = 0; i < n && begin < map + size; i++) {
+        const char *end = map + size * (i + 1) / n;
+        if (end < begin) end = begin;
+        if (i + 1 < n && end < map + size) {
+            const char *nl = memchr(end, '\n', map + size - end);
+            end = nl ? nl + 1 : map + size;
+        } else {
+            end = map + size;
+        }
+        chunks[*num].begin = begin;
+        chunks[*num].end = end;
+        chunks[*num].edges = edges;
+        (*num)++;
+        begin = end;
+    }
+
+    pthread_t threads[MAX_CHUNKS];
+    bool started[MAX_CHUNKS] = { false };
+    for (size_t i = 1; i < *num; i++) {
+        started[i] = pthread_create(&threads[i], NULL, parse_chunk,
+                &chunks[i]) == 0;
+    }
+    parse_chunk(&chunks[0]);
+    for (size_t i = 1; i < *num; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            parse_chunk(&chunks[i]);
+        }
+    }
+    munmap(map, size);
+
+    size_t line = 0;
+    size_t reported = 0;
+    size_t bad = 0;
+    enum loader_status status = LOADER_OK;
+    for (size_t i = 0; i < *num; i++) {
+        if (chunks[i].no_memory) status = LOADER_NO_MEMORY;
+        for (size_t j = 0; j < chunks[i].bad_len; j++, bad++) {
+            if (reported++ < MAX_REPORTED) {
+                fprintf(stderr, "%s:%zu: chybny riadok\n", path,
+                        line + chunks[i].bad[j]);
+            }
+        }
+        line += chunks[i].lines;
+    }
+    if (bad > MAX_REPORTED) {
+        fprintf(stderr, "%s: %zu chybnych riadkov preskocenych\n", path, bad);
+    }
+    return status;
+}
+
+/**
+ * Free arrays of all chunks.
+ *
+ * @param chunks    chunks to be freed
+ * @param num       number of chunks
+ */
+static void chunks_free(struct chunk *chunks, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        free(chunks[i].first);
+        free(chunks[i].second);
+        free(chunks[i].delay);
+        free(chunks[i].bad);
+    }
+}
+
+/**
+ * Count records in all chunks.
+ *
+ * @param chunks    parsed chunks
+ * @param num       number of chunks
+ * @return          total number of records
+ */
+static size_t chunks_len(const struct chunk *chunks, size_t num)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < num; i++) {
+        len += chunks[i].len;
+    }
+    return len;
+}
+
+enum loader_status loader_read_nodes(const char *path, uint32_t **ids,
+        size_t *len)
+{
+    struct chunk chunks[MAX_CHUNKS];
+    size_t num;
+    enum loader_status status = read_file(path, false, chunks, &num);
+    if (status != LOADER_OK) {
+        chunks_free(chunks, num);
+        return status;
+    }
+    *len = chunks_len(chunks, num);
+    *ids = malloc((*len + 1) * sizeof **ids);
+    if (!*ids) {
+        chunks_free(chunks, num);
+        return LOADER_NO_MEMORY;
+    }
+    size_t at = 0;
+    for (size_t i = 0; i < num; i++) {
+        if (chunks[i].len) {
+            memcpy(*ids + at, chunks[i].first, chunks[i].len * sizeof **ids);
+            at += chunks[i].len;
+        }
+    }
+    chunks_free(chunks, num);
+    return LOADER_OK;
+}
+
+enum loader_status loader_read_edges(const char *path, struct edge_list *list)
+{
+    struct chunk chunks[MAX_CHUNKS];
+    size_t num;
+    memset(list, 0, sizeof *list);
+    enum loader_status status = read_file(path, true, chunks, &num);
+    if (status != LOADER_OK) {
+        chunks_free(chunks, num);
+        return status;
+    }
+    size_t len = chunks_len(chunks, num);
+    list->sources = malloc((len + 1) * sizeof *list->sources);
+    list->destinations = malloc((len + 1) * sizeof *list->destinations);
+    list->mindelays = malloc((len + 1) * sizeof *list->mindelays);
+    if (!list->sources || !list->destinations || !list->mindelays) {
+        loader_free_edges(list);
+        chunks_free(chunks, num);
+        return LOADER_NO_MEMORY;
+    }
+    for (size_t i = 0; i < num; i++) {
+        const struct chunk *c = &chunks[i];
+        if (!c->len) continue;
+        memcpy(list->sources + list->len, c->first, c->len * sizeof(uint32_t));
+        memcpy(list->destinations + list->len, c->second,
+                c->len * sizeof(uint32_t));
+        memcpy(list->mindelays + list->len, c->delay, c->len * sizeof(int32_t));
+        list->len += c->len;
+    }
+    chunks_free(chunks, num);
+    return LOADER_OK;
+}
+
+bool loader_parse_duplicates(const char *name,
+        enum loader_duplicates *policy)
+{
+    for (int i = 0; i < LOADER_KEEP_KINDS; i++) {
+        if (name && strcmp(name, DUPLICATES_NAMES[i]) == 0) {
+            *policy = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Empty slot of a table of pairs */
+#define NO_EDGE UINT32_MAX
+
+/** Repeated measurement of an edge, kept for the median. */
+struct repeat {
+    /** Position of the first occurrence of the pair */
+    uint32_t first;
+    /** Delay of the measurement */
+    int32_t delay;
+};
+
+/** First occurrence of a pair in a table of pairs. */
+struct pair {
+    uint32_t source;
+    uint32_t destination;
+    /** Position of the edge in the list, `NO_EDGE` for empty slots */
+    uint32_t first;
+};
+
+/** Edges with sources assigned to a single thread. */
+struct merge_part {
+    /** Edges being merged; delays of first occurrences are updated */
+    struct edge_list *list;
+    /** Positions of edges of the part in ascending order */
+    const uint32_t *edges;
+    /** Number of edges of the part */
+    size_t len;
+    /** Which delay is kept */
+    enum loader_duplicates policy;
+    /** Flags of the list set for removed edges */
+    bool *removed;
+    /** Repeated measurements for the median */
+    struct repeat *repeats;
+    size_t repeats_len;
+    size_t repeats_size;
+    /** Set if memory ran out */
+    bool no_memory;
+};
+
+/**
+ * Find slot of a pair in a hash table.
+ *
+ * @param source        source id
+ * @param destination   destination id
+ * @param bits          binary logarithm of the table size
+ * @return              first slot to probe
+ */
+static size_t pair_slot(uint32_t source, uint32_t destination, int bits)
+{
+    uint64_t key = (uint64_t) source << 32 | destination;
+    return (key * 0x9e3779b97f4a7c15u) >> (64 - bits);
+}
+
+/**
+ * Compare repeated measurements by first occurrence and delay.
+ *
+ * @param a     first measurement
+ * @param b     second measurement
+ * @return      negative, zero or positive number as for qsort()
+ */
+static int repeat_compare(const void *a, const void *b)
+{
+    const struct repeat *x = a;
+    const struct repeat *y = b;
+    if (x->first != y->first) return x->first < y->first ? -1 : 1;
+    return (x->delay > y->delay) - (x->delay < y->delay);
+}
+
+/**
+ * Remember a repeated measurement.
+ *
+ * @param m         part the edge belongs to
+ * @param first     position of the first occurrence
+ * @param delay     delay of the measurement
+ * @return          true if successful, false if memory ran out
+ */
+static bool merge_push(struct merge_part *m, uint32_t first, int32_t delay)
+{
+    if (m->repeats_len >= m->repeats_size) {
+        size_t size = m->repeats_size ? m->repeats_size * 2 : 1024;
+        struct repeat *tmp = realloc(m->repeats, size * sizeof *tmp);
+        if (!tmp) return false;
+        m->repeats = tmp;
+        m->repeats_size = size;
+    }
+    m->repeats[m->repeats_len].first = first;
+    m->repeats[m->repeats_len++].delay = delay;
+    return true;
+}
+
+/**
+ * Set delays of first occurrences to medians of their measurements.
+ *
+ * @param m     part with sorted repeated measurements
+ */
+static void merge_medians(struct merge_part *m)
+{
+    int32_t *delays = m->list->mindelays;
+    for (size_t i = 0, n; i < m->repeats_len; i += n) {
+        uint32_t first = m->repeats[i].first;
+        for (n = 1; i + n < m->repeats_len
+                && m->repeats[i + n].first == first; n++);
+        /* The first occurrence is not among the repeats, it is merged into
+         * them while walking to the middle. */
+        int32_t own = delays[first];
+        bool taken = false;
+        size_t j = i;
+        int32_t value = own;
+        for (size_t rank = 0; rank <= n / 2; rank++) {
+            if (!taken && (j == i + n || own <= m->repeats[j].delay)) {
+                value = own;
+                taken = true;
+            } else {
+                value = m->repeats[j++].delay;
+            }
+        }
+        delays[first] = value;
+    }
+}
+
+/**
+ * Merge repeated pairs of one part. This is the thread entry point.
+ * Edges are visited in order of the list and the first occurrence of each
+ * pair is kept in a hash table together with the pair, so probing does not
+ * read the list; later occurrences are folded into it.
+ *
+ * @param arg   part to be merged
+ * @return      NULL
+ */
+static void * merge_part(void *arg)
+{
+    struct merge_part *m = arg;
+    const uint32_t *sources = m->list->sources;
+    const uint32_t *destinations = m->list->destinations;
+    int32_t *delays = m->list->mindelays;
+
+    int bits = 4;
+    while ((size_t) 1 << bits < m->len * 2) bits++;
+    size_t mask = ((size_t) 1 << bits) - 1;
+    struct pair *table = malloc((mask + 1) * sizeof *table);
+    if (!table) {
+        m->no_memory = true;
+        return NULL;
+    }
+    memset(table, 0xff, (mask + 1) * sizeof *table);
+
+    for (size_t j = 0; j < m->len; j++) {
+        uint32_t i = m->edges[j];
+        uint32_t s = sources[i];
+        uint32_t d = destinations[i];
+        size_t slot = pair_slot(s, d, bits);
+        while (table[slot].first != NO_EDGE
+                && (table[slot].source != s
+                    || table[slot].destination != d)) {
+            slot = (slot + 1) & mask;
+        }
+        uint32_t first = table[slot].first;
+        if (first == NO_EDGE) {
+            table[slot].source = s;
+            table[slot].destination = d;
+            table[slot].first = i;
+            continue;
+        }
+        m->removed[i] = true;
+        if (m->policy == LOADER_KEEP_MIN) {
+            if (delays[i] < delays[first]) delays[first] = delays[i];
+        } else if (m->policy == LOADER_KEEP_LAST) {
+            delays[first] = delays[i];
+        } else if (!merge_push(m, first, delays[i])) {
+            m->no_memory = true;
+            break;
+        }
+    }
+    free(table);
+    if (!m->no_memory && m->repeats_len) {
+        qsort(m->repeats, m->repeats_len, sizeof *m->repeats, repeat_compare);
+        merge_medians(m);
+    }
+    return NULL;
+}
+
+enum loader_status loader_merge_edges(struct edge_list *list,
+        enum loader_duplicates policy, size_t *merged)
+{
+    *merged = 0;
+    if (policy == LOADER_KEEP_ALL || list->len < 2) return LOADER_OK;
+    /* Positions are stored in 32 bits, as in frozen graphs. */
+    if (list->len >= NO_EDGE) return LOADER_NO_MEMORY;
+
+    size_t parts = chunks_for(list->len, MIN_MERGE_PART);
+    bool *removed = calloc(list->len, sizeof *removed);
+    uint32_t *order = malloc(list->len * sizeof *order);
+    if (!removed || !order) {
+        free(removed);
+        free(order);
+        return LOADER_NO_MEMORY;
+    }
+
+    /* An edge belongs to part `source % parts`, so all edges of a source
+     * are in the same part and every thread updates different edges.
+     * Positions are sorted by part once, keeping their order, and each
+     * thread only visits its own slice. */
+    size_t start[MAX_CHUNKS + 1] = { 0 };
+    for (size_t i = 0; i < list->len; i++) {
+        start[list->sources[i] % parts + 1]++;
+    }
+    for (size_t p = 0; p < parts; p++) {
+        start[p + 1] += start[p];
+    }
+    size_t next[MAX_CHUNKS];
+    memcpy(next, start, parts * sizeof *next);
+    for (size_t i = 0; i < list->len; i++) {
+        order[next[list->sources[i] % parts]++] = i;
+    }
+
+    struct merge_part m[MAX_CHUNKS];
+    memset(m, 0, sizeof m);
+    pthread_t threads[MAX_CHUNKS];
+    bool started[MAX_CHUNKS] = { false };
+    for (size_t p = 0; p < parts; p++) {
+        m[p].list = list;
+        m[p].edges = order + start[p];
+        m[p].len = start[p + 1] - start[p];
+        m[p].policy = policy;
+        m[p].removed = removed;
+        if (p > 0) {
+            started[p] = pthread_create(&threads[p], NULL, merge_part,
+                    &m[p]) == 0;
+        }
+    }
+    merge_part(&m[0]);
+    bool no_memory = false;
+    for (size_t p = 0; p < parts; p++) {
+        if (started[p]) {
+            pthread_join(threads[p], NULL);
+        } else if (p > 0) {
+            merge_part(&m[p]);
+        }
+        no_memory = no_memory || m[p].no_memory;
+        free(m[p].repeats);
+    }
+    free(order);
+    if (no_memory) {
+        free(removed);
+        return LOADER_NO_MEMORY;
+    }
+
+    size_t len = 0;
+    for (size_t i = 0; i < list->len; i++) {
+        if (removed[i]) continue;
+        list->sources[len] = list->sources[i];
+        list->destinations[len] = list->destinations[i];
+        list->mindelays[len++] = list->mindelays[i];
+    }
+    free(removed);
+    *merged = list->len - len;
+    list->len = len;
+    return LOADER_OK;
+}
+
+void loader_free_edges(struct edge_list *list)
+{
+    if (list) {
+        free(list->sources);
+        free(list->destinations);
+        free(list->mindelays);
+        memset(list, 0, sizeof *list);
+    }
+}
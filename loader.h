@@ -0,0 +1,115 @@
+/**
+ * Interface for reading DIMES CSV files.
+ *
+ * Files are mapped into memory, split into chunks at line boundaries and the
+ * chunks are parsed in parallel. Results of the chunks are merged in the order
+ * of the file, so the outcome is the same as if the file was read line by
+ * line. Lines that can not be parsed are reported on standard error output
+ * together with their line number and skipped.
+ *
+ * DIMES exports contain repeated measurements of the same edge, which can be
+ * merged into one edge by loader_merge_edges() before building a graph.
+ *
+ * @file    loader.h
+ */
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Result of reading a file. */
+enum loader_status {
+    /** File was read successfully */
+    LOADER_OK,
+    /** File could not be opened */
+    LOADER_NO_FILE,
+    /** Memory ran out */
+    LOADER_NO_MEMORY,
+};
+
+/** What to keep of repeated edges with the same source and destination. */
+enum loader_duplicates {
+    /** Minimum delay of the measurements */
+    LOADER_KEEP_MIN,
+    /** Median delay, the lower one of the middle two for even counts */
+    LOADER_KEEP_MEDIAN,
+    /** Delay on the last line of the file */
+    LOADER_KEEP_LAST,
+    /** All edges are kept as they are */
+    LOADER_KEEP_ALL,
+    /** Number of policies */
+    LOADER_KEEP_KINDS
+};
+
+/** Edges read from a file. Each array has `len` elements. */
+struct edge_list {
+    /** Number of edges */
+    size_t len;
+    /** Ids of starting nodes */
+    uint32_t *sources;
+    /** Ids of ending nodes */
+    uint32_t *destinations;
+    /** Minimum delays */
+    int32_t *mindelays;
+};
+
+/**
+ * Read ids of nodes from a file.
+ * The id is the first column of each line, other columns are ignored.
+ * Free the returned array with free().
+ *
+ * @param path      name of the file
+ * @param[out] ids  where to store array of ids
+ * @param[out] len  where to store number of ids
+ * @return          status of the operation
+ */
+enum loader_status loader_read_nodes(const char *path, uint32_t **ids,
+        size_t *len);
+
+/**
+ * Read edges from a file.
+ * Columns of each line are source id, destination id, an ignored column and
+ * minimum delay. Further columns are ignored. Free the result with
+ * loader_free_edges().
+ *
+ * @param path      name of the file
+ * @param[out] list where to store the edges
+ * @return          status of the operation
+ */
+enum loader_status loader_read_edges(const char *path, struct edge_list *list);
+
+/**
+ * Parse name of a policy for repeated edges.
+ *
+ * @param name          `min`, `median`, `last` or `all`
+ * @param policy[out]   parsed value
+ * @return              true if the name is valid
+ */
+bool loader_parse_duplicates(const char *name,
+        enum loader_duplicates *policy);
+
+/**
+ * Merge repeated edges with the same source and destination into one.
+ * Edges are split among threads by their source; each thread finds repeated
+ * pairs of its part in a hash table and picks one delay for every pair. The
+ * remaining edges keep the order of their first occurrence.
+ *
+ * @param list          edges to be merged in place
+ * @param policy        which delay the merged edge gets
+ * @param merged[out]   number of removed edges
+ * @return              LOADER_OK or LOADER_NO_MEMORY, delays in the list
+ *                      may be partially merged on failure
+ */
+enum loader_status loader_merge_edges(struct edge_list *list,
+        enum loader_duplicates policy, size_t *merged);
+
+/**
+ * Free arrays of an edge list.
+ *
+ * @param list  edges to be freed
+ */
+void loader_free_edges(struct edge_list *list);
+
+#endif /* end of include guard: LOADER_H */
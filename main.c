@@ -7,198 +7,1554 @@
  * they are now. The comment tells Doxygen that this file should be
  * processed.
  */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "graph.h"
-#include "heap.h"
+#include "alt.h"
+#include "cache.h"
+#include "ch.h"
+#include "csr.h"
+#include "delta.h"
+#include "dynamic.h"
+#include "label.h"
+#include "loader.h"
+#include "matrix.h"
+#include "pool.h"
+#include "reorder.h"
+#include "scc.h"
+#include "search.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "yen.h"
 
 /**
- * @brief loadNodes loading nodes from F
+ * @brief loadNodes loading nodes from file
  * @param graph structure for adding nodes
- * @param f file for reading
- * @return true if successful false if not
+ * @param path file for reading
+ * @return 0 if successful, exit status of the program otherwise
  */
-
-bool loadNodes(Graph *graph, FILE* f){
-    unsigned int id = 0;
-    char buffer[201];
-    while(fgets(buffer,200,f)){
-        id = atoi(strtok(buffer,","));
-        if(!graph_insert_node(graph,id)){
+int loadNodes(Graph *graph, const char* path){
+    uint32_t *ids = NULL;
+    size_t len = 0;
+    enum loader_status status = loader_read_nodes(path,&ids,&len);
+    if(status == LOADER_NO_FILE){
+        fputs("zadany subor vrcholov neexistuje\n",stderr);
+        return 3;
+    }
+    if(status == LOADER_NO_MEMORY){
+        fputs("nedostatok pamati pri nacitavani vrcholov\n",stderr);
+        return 4;
+    }
+    for(size_t i = 0; i < len; i++){
+        if(!graph_insert_node(graph,ids[i])){
             fputs("nedostatok pamati pri nacitavani vrcholov\n",stderr);
-            return false;
+            free(ids);
+            return 4;
         }
     }
-    if(id == 0){
+    free(ids);
+    if(len == 0){
         fputs("ziadne vrcholy v grafe\n",stderr);
-        return false;
+        return 4;
     }
-    return true;
+    return 0;
 }
 /**
- * @brief loadEdges loading edges from file F
+ * @brief loadEdges loading edges from file
+ *
+ * Repeated edges between the same nodes are merged before they are inserted
+ * into the graph.
+ *
  * @param graph structure for adding edges
- * @param f file for reading
- * @return true if successful false if not
- */
-bool loadEdges(Graph *graph, FILE* f){
-    unsigned int source = 0;
-    unsigned int destination = 0;
-    int mindelay = 0;
-    char buffer[201];
-    while(fgets(buffer,200,f)){
-        source = atoi(strtok(buffer,","));
-        destination = atoi(strtok(NULL,","));
-        strtok(NULL,",");
-        mindelay = atoi(strtok(NULL,","));
-        if(!graph_insert_edge(graph,source,destination,mindelay)){
+ * @param path file for reading
+ * @param duplicates which delay of repeated edges is kept
+ * @param verbose report number of merged edges
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int loadEdges(Graph *graph, const char* path, enum loader_duplicates duplicates, bool verbose){
+    struct edge_list edges;
+    enum loader_status status = loader_read_edges(path,&edges);
+    if(status == LOADER_NO_FILE){
+        fputs("zadany subor hran neexistuje\n",stderr);
+        return 3;
+    }
+    if(status == LOADER_NO_MEMORY){
+        fputs("nedostatok pamati pri nacitavani hran\n",stderr);
+        return 4;
+    }
+    size_t merged = 0;
+    if(loader_merge_edges(&edges,duplicates,&merged) != LOADER_OK){
+        fputs("nedostatok pamati pri nacitavani hran\n",stderr);
+        loader_free_edges(&edges);
+        return 4;
+    }
+    if(verbose){
+        fprintf(stderr,"zlucene opakovane hrany: %zu, zostava %zu\n",merged,edges.len);
+    }
+    for(size_t i = 0; i < edges.len; i++){
+        if(!graph_insert_edge(graph,edges.sources[i],edges.destinations[i],edges.mindelays[i])){
             fputs("nedostatok pamati pri nacitavani hran\n",stderr);
-            return false;
+            loader_free_edges(&edges);
+            return 4;
         }
     }
-    return true;
+    loader_free_edges(&edges);
+    return 0;
 }
 /**
- * @brief dijkstra function for exploring graph
- * @param graph structure to be explored
- * @param s starting node
- * @param d destination node
+ * @brief engine algorithm answering queries
  */
-void dijkstra(Graph* graph, Node* s, Node* d){
-    Heap *heap = heap_new_from_graph(graph);
-    if (!heap){
-        fputs("nedostatok pamati pre haldu\n",stderr);
-        return;
-    }
-    Node * current = NULL;
-    struct edge * edges = NULL;
-    unsigned short out = 0;
-    unsigned short alt = 0;
-    heap_decrease_distance(heap,s,0,NULL);
-    while(!heap_is_empty(heap)){
-        current = heap_extract_min(heap);
-        if(node_get_distance(current) == UINT_MAX){
-            break;
-        }
-        if(current == d){
-            break;
-        }
-        edges = node_get_edges(current);
-        out = node_get_n_outgoing(current);
-        for(int i = 0; i < out; i++){
-            alt = node_get_distance(current) + edges[i].mindelay;
-            if(alt < node_get_distance(edges[i].destination)){
-                heap_decrease_distance(heap,edges[i].destination,alt,current);
+enum engine {
+    /** Dijkstra's algorithm from the starting node */
+    ENGINE_DIJKSTRA,
+    /** Dijkstra's algorithm from both ends of the path */
+    ENGINE_BIDIR,
+    /** A* search with landmarks */
+    ENGINE_ALT,
+    /** contraction hierarchies */
+    ENGINE_CH,
+    /** hub labels for distances, Dijkstra's algorithm for paths */
+    ENGINE_LABELS,
+    /** parallel delta-stepping, only for paths to all nodes */
+    ENGINE_DELTA
+};
+
+/**
+ * @brief options parsed command line
+ */
+struct options {
+    /** snapshot to be used instead of CSV files */
+    const char* snapshot;
+    /** file where to store snapshot of loaded graph */
+    const char* saveSnapshot;
+    /** verify checksum of the snapshot */
+    bool verify;
+    /** report memory used while loading */
+    bool verbose;
+    /** write time of phases and counters as JSON */
+    bool stats;
+    /** file with queries, "-" for standard input */
+    const char* queries;
+    /** file with changes of edges applied after --all, "-" for standard
+     * input */
+    const char* updates;
+    /** print one line per path instead of DOT */
+    bool lineFormat;
+    /** print only distance of each query instead of the path */
+    bool distanceFormat;
+    /** write distance matrix in binary form instead of CSV */
+    bool binaryFormat;
+    /** find paths from one node to all nodes */
+    bool all;
+    /** find distances between lists of nodes */
+    bool matrix;
+    /** do not find strongly connected components before queries */
+    bool noComponents;
+    /** search compressed edges */
+    bool packed;
+    /** number of threads for batch queries, 0 for all processors */
+    size_t threads;
+    /** memory for cached shortest-path trees in MiB, 0 disables the cache */
+    size_t cache;
+    /** number of shortest loopless paths of a single query, 0 for just the
+     * shortest path in the original format */
+    uint32_t paths;
+    /** priority queue used by searches */
+    enum pq_kind queue;
+    /** order of nodes in memory */
+    enum reorder_kind reorder;
+    /** which delay of repeated edges is kept */
+    enum loader_duplicates duplicates;
+    /** algorithm answering queries */
+    enum engine engine;
+    /** number of landmarks for ALT */
+    uint32_t landmarks;
+    /** width of buckets for delta-stepping, 0 picks it automatically */
+    uint32_t delta;
+    /** way of picking landmarks */
+    enum alt_selection landmarkSelect;
+    /** file with landmarks, built and stored if it can not be used */
+    const char* landmarkFile;
+    /** file with contraction hierarchy, built and stored if it can not be
+     * used */
+    const char* chFile;
+    /** file with hub labels, built and stored if it can not be used */
+    const char* labelFile;
+    /** file with nodes */
+    const char* nodes;
+    /** file with edges */
+    const char* edges;
+    /** positional arguments following the graph files */
+    char* args[5];
+    /** number of positional arguments */
+    int argsNum;
+};
+
+/**
+ * @brief parseOptions processing command line
+ * @param argc number of arguments
+ * @param argv arguments
+ * @param opts structure to be filled
+ * @return true if arguments are valid false if not
+ */
+bool parseOptions(int argc, char* argv[], struct options* opts){
+    memset(opts,0,sizeof *opts);
+    opts->queue = PQ_AUTO;
+    opts->landmarks = ALT_DEFAULT_LANDMARKS;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i],"--snapshot") == 0 && i + 1 < argc){
+            opts->snapshot = argv[++i];
+        }else if(strcmp(argv[i],"--save-snapshot") == 0 && i + 1 < argc){
+            opts->saveSnapshot = argv[++i];
+        }else if(strcmp(argv[i],"--verify") == 0){
+            opts->verify = true;
+        }else if(strcmp(argv[i],"--verbose") == 0){
+            opts->verbose = true;
+        }else if(strcmp(argv[i],"--stats") == 0){
+            opts->stats = true;
+        }else if(strcmp(argv[i],"--queries") == 0 && i + 1 < argc){
+            opts->queries = argv[++i];
+        }else if(strcmp(argv[i],"--updates") == 0 && i + 1 < argc){
+            opts->updates = argv[++i];
+        }else if(strcmp(argv[i],"--heap") == 0 && i + 1 < argc){
+            if(!pq_parse(argv[++i],&opts->queue)){
+                return false;
             }
+        }else if(strcmp(argv[i],"--duplicates") == 0 && i + 1 < argc){
+            if(!loader_parse_duplicates(argv[++i],&opts->duplicates)){
+                return false;
+            }
+        }else if(strcmp(argv[i],"--reorder") == 0 && i + 1 < argc){
+            if(!reorder_parse(argv[++i],&opts->reorder)){
+                return false;
+            }
+        }else if(strcmp(argv[i],"--engine") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i],"bidir") == 0){
+                opts->engine = ENGINE_BIDIR;
+            }else if(strcmp(argv[i],"alt") == 0){
+                opts->engine = ENGINE_ALT;
+            }else if(strcmp(argv[i],"ch") == 0){
+                opts->engine = ENGINE_CH;
+            }else if(strcmp(argv[i],"labels") == 0){
+                opts->engine = ENGINE_LABELS;
+            }else if(strcmp(argv[i],"delta") == 0){
+                opts->engine = ENGINE_DELTA;
+            }else if(strcmp(argv[i],"dijkstra") != 0){
+                return false;
+            }
+        }else if(strcmp(argv[i],"--all") == 0){
+            opts->all = true;
+        }else if(strcmp(argv[i],"--matrix") == 0){
+            opts->matrix = true;
+        }else if(strcmp(argv[i],"--no-scc") == 0){
+            opts->noComponents = true;
+        }else if(strcmp(argv[i],"--packed") == 0){
+            opts->packed = true;
+        }else if(strcmp(argv[i],"--delta") == 0 && i + 1 < argc){
+            opts->delta = strtoul(argv[++i],NULL,10);
+        }else if(strcmp(argv[i],"--landmarks") == 0 && i + 1 < argc){
+            opts->landmarks = strtoul(argv[++i],NULL,10);
+        }else if(strcmp(argv[i],"--landmark-select") == 0 && i + 1 < argc){
+            if(!alt_parse_selection(argv[++i],&opts->landmarkSelect)){
+                return false;
+            }
+        }else if(strcmp(argv[i],"--landmark-file") == 0 && i + 1 < argc){
+            opts->landmarkFile = argv[++i];
+        }else if(strcmp(argv[i],"--ch-file") == 0 && i + 1 < argc){
+            opts->chFile = argv[++i];
+        }else if(strcmp(argv[i],"--label-file") == 0 && i + 1 < argc){
+            opts->labelFile = argv[++i];
+        }else if(strcmp(argv[i],"--threads") == 0 && i + 1 < argc){
+            opts->threads = strtoul(argv[++i],NULL,10);
+        }else if(strcmp(argv[i],"--cache") == 0 && i + 1 < argc){
+            opts->cache = strtoul(argv[++i],NULL,10);
+        }else if(strcmp(argv[i],"-k") == 0 && i + 1 < argc){
+            opts->paths = strtoul(argv[++i],NULL,10);
+            if(opts->paths == 0){
+                return false;
+            }
+        }else if(strcmp(argv[i],"--format") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i],"line") == 0){
+                opts->lineFormat = true;
+            }else if(strcmp(argv[i],"distance") == 0){
+                opts->distanceFormat = true;
+            }else if(strcmp(argv[i],"binary") == 0){
+                opts->binaryFormat = true;
+            }else if(strcmp(argv[i],"dot") != 0 && strcmp(argv[i],"csv") != 0){
+                return false;
+            }
+        }else if(strncmp(argv[i],"--",2) == 0 || opts->argsNum == 5){
+            return false;
+        }else{
+            opts->args[opts->argsNum++] = argv[i];
+        }
+    }
+    /* Take CSV file names away so that query arguments are always first. */
+    if(!opts->snapshot){
+        if(opts->argsNum < 2){
+            return false;
         }
+        opts->nodes = opts->args[0];
+        opts->edges = opts->args[1];
+        opts->argsNum -= 2;
+        memmove(opts->args,opts->args + 2,opts->argsNum * sizeof *opts->args);
+    }
+    if(opts->packed && (opts->engine != ENGINE_DIJKSTRA || opts->all || opts->matrix)){
+        return false;
+    }
+    if(opts->cache && (opts->engine != ENGINE_DIJKSTRA || opts->packed || !opts->queries)){
+        return false;
+    }
+    if(opts->paths && (opts->engine != ENGINE_DIJKSTRA || opts->packed || opts->queries || opts->all
+                || opts->matrix || opts->lineFormat || opts->distanceFormat)){
+        return false;
+    }
+    if(opts->matrix){
+        return !opts->all && !opts->queries && !opts->lineFormat && !opts->distanceFormat
+            && (opts->argsNum == 2 || opts->argsNum == 3)
+            && opts->engine == ENGINE_DIJKSTRA;
+    }
+    if(opts->binaryFormat || (opts->distanceFormat && (opts->all || !opts->queries))){
+        return false;
+    }
+    if(opts->updates && (!opts->all || opts->engine != ENGINE_DIJKSTRA)){
+        return false;
+    }
+    if(opts->all){
+        return !opts->queries && (opts->argsNum == 1 || opts->argsNum == 2)
+            && (opts->engine == ENGINE_DIJKSTRA || opts->engine == ENGINE_DELTA);
+    }
+    if(opts->engine == ENGINE_DELTA){
+        return false;
     }
-    heap_free(heap);
+    if(opts->queries){
+        return opts->argsNum <= 1;
+    }
+    if(opts->argsNum == 0){
+        return opts->saveSnapshot != NULL;
+    }
+    return opts->argsNum == 2 || opts->argsNum == 3;
 }
-int main(int argc, char* argv[]){
-    FILE *fNodes = NULL;
-    FILE *fEdges = NULL;
-    if((argc < 5)||(argc > 6)){
-        fputs("zly pocet argumentov\n",stderr);
-        return 1;
+
+/**
+ * @brief nowMicros reading monotonic clock
+ * @return current time in microseconds
+ */
+double nowMicros(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief endPhase adding time since its start to a phase of the program
+ * @param phase measured phase
+ * @param start time when the phase started
+ * @return current time, usable as start of the next phase
+ */
+double endPhase(enum stats_phase phase, double start){
+    double now = nowMicros();
+    stats_add_time(phase,now - start);
+    return now;
+}
+
+/**
+ * @brief residentMemory reading resident set size of the process
+ * @return size in bytes or 0 if it is not known
+ */
+size_t residentMemory(void){
+    FILE * f = fopen("/proc/self/statm","r");
+    if(!f){
+        return 0;
+    }
+    unsigned long pages = 0;
+    unsigned long resident = 0;
+    if(fscanf(f,"%lu %lu",&pages,&resident) != 2){
+        resident = 0;
     }
+    fclose(f);
+    return (size_t) resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief loadGraph loading graph from CSV files and freezing it
+ *
+ * The graph is freed once it is frozen. With verbose output its memory,
+ * resident set size before and after freeing it and the time freeing took
+ * are written to standard error.
+ *
+ * @param nodes name of file with nodes
+ * @param edges name of file with edges
+ * @param duplicates which delay of repeated edges is kept
+ * @param verbose report memory of the graph and merged edges
+ * @param csr where to store the frozen graph
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int loadGraph(const char* nodes, const char* edges, enum loader_duplicates duplicates, bool verbose, Csr** csr){
     Graph * graph = graph_new();
     if(!graph){
         fputs("nepodarilo sa vytvorit graf / malo pamate\n",stderr);
         return 2;
     }
-    fNodes = fopen(argv[1],"r");
-    if(!fNodes){
-        graph_free(graph);
-        fputs("zadany subor vrcholov neexistuje\n",stderr);
-        return 3;
+    double phase = nowMicros();
+    int status = loadNodes(graph,nodes);
+    phase = endPhase(STATS_LOAD_NODES,phase);
+    if(status == 0){
+        status = loadEdges(graph,edges,duplicates,verbose);
+        phase = endPhase(STATS_LOAD_EDGES,phase);
     }
-    fEdges = fopen(argv[2],"r");
-    if(!fEdges){
-        fclose(fNodes);
-        graph_free(graph);
-        fputs("zadany subor hran neexistuje\n",stderr);
-        return 3;
+    if(status == 0){
+        *csr = graph_freeze(graph);
+        if(!*csr){
+            fputs("nepodarilo sa vytvorit kompaktny graf / malo pamate\n",stderr);
+            status = 2;
+        }
+    }
+    size_t memory = graph_memory(graph);
+    size_t before = verbose ? residentMemory() : 0;
+    double start = nowMicros();
+    graph_free(graph);
+    double duration = nowMicros() - start;
+    endPhase(STATS_INDEX,phase);
+    if(verbose && status == 0){
+        fprintf(stderr,"graf: %.1f MiB, RSS pred uvolnenim %.1f MiB, po uvolneni %.1f MiB, uvolnenie %.1f ms\n",
+                memory / 1048576.0,before / 1048576.0,residentMemory() / 1048576.0,duration / 1e3);
+    }
+    return status;
+}
+
+/**
+ * @brief reorderGraph renumbering nodes of the graph for better cache locality
+ * @param csr frozen graph, replaced by the renumbered one
+ * @param kind order of nodes
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int reorderGraph(Csr** csr, enum reorder_kind kind){
+    if(kind == REORDER_NONE){
+        return 0;
+    }
+    uint32_t * order = reorder_compute(*csr,kind);
+    Csr * reordered = order ? reorder_apply(*csr,order) : NULL;
+    free(order);
+    if(!reordered){
+        fputs("nedostatok pamati pri preusporiadani vrcholov\n",stderr);
+        return 4;
+    }
+    csr_free(*csr);
+    *csr = reordered;
+    return 0;
+}
+
+/**
+ * @brief indices data prepared for the selected engine
+ */
+struct indices {
+    /** algorithm answering queries */
+    enum engine engine;
+    /** landmarks for ALT */
+    Landmarks* landmarks;
+    /** contraction hierarchy */
+    Hierarchy* hierarchy;
+    /** strongly connected components rejecting queries without a path */
+    Components* components;
+    /** compressed edges replacing those of the graph */
+    Packed* packed;
+    /** shortest-path trees of recent starting nodes */
+    Cache* cache;
+    /** hub labels answering distances */
+    Labels* labels;
+};
+
+/**
+ * @brief checkWeights rejecting negative edge weights, which no search and no
+ * index supports
+ * @param csr frozen graph
+ * @param opts command line options
+ * @return 0 if the graph can be used, exit status of the program otherwise
+ */
+int checkWeights(const Csr* csr, const struct options* opts){
+    bool indexed = opts->engine == ENGINE_ALT || opts->engine == ENGINE_CH
+        || opts->engine == ENGINE_LABELS;
+    if(csr->min_weight < 0 && (opts->queries || opts->argsNum > 0 || indexed)){
+        fputs("hladanie nepodporuje zaporne vahy hran\n",stderr);
+        return 8;
+    }
+    return 0;
+}
+
+/**
+ * @brief prepareLandmarks opening or building landmarks for ALT
+ * @param csr frozen graph to be searched
+ * @param opts command line options
+ * @param idx where to store the landmarks
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int prepareLandmarks(Csr* csr, const struct options* opts, struct indices* idx){
+    if(opts->landmarkFile){
+        idx->landmarks = alt_open(csr,opts->landmarkFile,opts->verify);
+        if(idx->landmarks){
+            return 0;
+        }
+    }
+    Pool * pool = pool_new(opts->threads);
+    idx->landmarks = alt_build(csr,opts->landmarks,opts->landmarkSelect,pool);
+    pool_free(pool);
+    if(!idx->landmarks){
+        fputs("nedostatok pamati pre orientacne body\n",stderr);
+        return 4;
+    }
+    if(opts->landmarkFile && !alt_save(idx->landmarks,csr,opts->landmarkFile)){
+        fputs("nepodarilo sa ulozit orientacne body\n",stderr);
+        return 7;
+    }
+    return 0;
+}
+
+/**
+ * @brief prepareHierarchy opening or building contraction hierarchy
+ * @param csr frozen graph to be searched
+ * @param opts command line options
+ * @param idx where to store the hierarchy
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int prepareHierarchy(Csr* csr, const struct options* opts, struct indices* idx){
+    if(opts->chFile){
+        idx->hierarchy = ch_open(csr,opts->chFile,opts->verify);
+        if(idx->hierarchy){
+            return 0;
+        }
+    }
+    Pool * pool = pool_new(opts->threads);
+    idx->hierarchy = ch_build(csr,pool);
+    pool_free(pool);
+    if(!idx->hierarchy){
+        fputs("nedostatok pamati pre hierarchiu\n",stderr);
+        return 4;
+    }
+    if(opts->chFile && !ch_save(idx->hierarchy,csr,opts->chFile)){
+        fputs("nepodarilo sa ulozit hierarchiu\n",stderr);
+        return 7;
+    }
+    return 0;
+}
+
+/**
+ * @brief prepareLabels opening or building hub labels
+ * @param csr frozen graph to be searched
+ * @param opts command line options
+ * @param idx where to store the labels
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int prepareLabels(Csr* csr, const struct options* opts, struct indices* idx){
+    if(opts->labelFile){
+        idx->labels = label_open(csr,opts->labelFile,opts->verify);
+    }
+    if(!idx->labels){
+        Pool * pool = pool_new(opts->threads);
+        idx->labels = label_build(csr,pool);
+        pool_free(pool);
+        if(!idx->labels){
+            fputs("nedostatok pamati pre stitky\n",stderr);
+            return 4;
+        }
+        if(opts->labelFile && !label_save(idx->labels,csr,opts->labelFile)){
+            fputs("nepodarilo sa ulozit stitky\n",stderr);
+            return 7;
+        }
+    }
+    if(opts->verbose){
+        uint64_t entries = label_entries(idx->labels);
+        fprintf(stderr,"stitky: %llu poloziek, %.1f na vrchol, %.1f MiB\n",(unsigned long long) entries,
+                csr->nodes_num ? (double) entries / csr->nodes_num : 0.0,
+                entries * sizeof(struct label_entry) / 1048576.0);
+    }
+    return 0;
+}
+
+/**
+ * @brief prepareEngine building indices needed by the selected engine
+ * @param csr frozen graph to be searched
+ * @param opts command line options
+ * @param idx indices to be filled in
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int prepareEngine(Csr* csr, const struct options* opts, struct indices* idx){
+    idx->engine = opts->engine;
+    int status = checkWeights(csr,opts);
+    if(status != 0){
+        return status;
+    }
+    if((opts->queries || opts->argsNum > 0) && !opts->all && !opts->matrix
+            && !opts->noComponents){
+        idx->components = scc_build(csr);
+        if(!idx->components){
+            fputs("nedostatok pamati pre komponenty grafu\n",stderr);
+            return 4;
+        }
+    }
+    if(opts->packed){
+        idx->packed = packed_new(csr);
+        if(!idx->packed){
+            fputs("nedostatok pamati pre zbalene hrany\n",stderr);
+            return 4;
+        }
+        if(opts->verbose){
+            fprintf(stderr,"hrany: %.1f MiB, zbalene %.1f MiB\n",
+                    csr_edge_memory(csr) / 1048576.0,packed_memory(idx->packed) / 1048576.0);
+        }
+        csr_release_edges(csr);
+    }
+    if(opts->cache){
+        idx->cache = cache_new(csr,opts->cache << 20);
+        if(!idx->cache){
+            fputs("nedostatok pamati pre cache\n",stderr);
+            return 4;
+        }
     }
-    if(!loadNodes(graph, fNodes)){
-        fclose(fNodes);
-        fclose(fEdges);
-        graph_free(graph);
+    if(opts->engine == ENGINE_BIDIR && !csr_build_reverse(csr)){
+        fputs("nedostatok pamati pre spatne hrany\n",stderr);
         return 4;
     }
-    if(!loadEdges(graph, fEdges)){
-        fclose(fNodes);
-        fclose(fEdges);
-        graph_free(graph);
+    if(opts->engine == ENGINE_ALT){
+        return prepareLandmarks(csr,opts,idx);
+    }
+    if(opts->engine == ENGINE_CH){
+        return prepareHierarchy(csr,opts,idx);
+    }
+    if(opts->engine == ENGINE_LABELS){
+        return prepareLabels(csr,opts,idx);
+    }
+    return 0;
+}
+
+/**
+ * @brief searchedGraph graph that search contexts of the engine are created for
+ * @param csr frozen graph to be searched
+ * @param idx engine and its indices
+ * @return graph for search_new()
+ */
+const Csr* searchedGraph(const Csr* csr, const struct indices* idx){
+    return idx->hierarchy ? &idx->hierarchy->graph : csr;
+}
+
+/**
+ * @brief findPath searching shortest path with the selected engine
+ *
+ * Queries between nodes that can not be connected are rejected without
+ * searching if components of the graph are known.
+ *
+ * @param search search context
+ * @param idx engine and its indices
+ * @param s index of starting node
+ * @param d index of destination node
+ * @return true if the path was found false if not
+ */
+bool findPath(Search* search, const struct indices* idx, uint32_t s, uint32_t d){
+    if(idx->components && !scc_may_reach(idx->components,s,d)){
+        return false;
+    }
+    if(idx->packed){
+        return search_run_packed(search,idx->packed,s,d);
+    }
+    if(idx->cache){
+        return cache_run(idx->cache,search,s,d);
+    }
+    if(idx->engine == ENGINE_BIDIR){
+        return search_run_bidirectional(search,s,d);
+    }
+    if(idx->engine == ENGINE_ALT){
+        return alt_run(search,idx->landmarks,s,d);
+    }
+    if(idx->engine == ENGINE_CH){
+        return ch_run(search,idx->hierarchy,s,d);
+    }
+    if(idx->labels && label_distance(idx->labels,s,d) == UINT32_MAX){
+        return false;
+    }
+    return search_run(search,s,d);
+}
+
+/**
+ * @brief findDistance finding length of shortest path without the path
+ *
+ * Hub labels answer without searching, other engines search the path.
+ *
+ * @param search search context
+ * @param idx engine and its indices
+ * @param s index of starting node
+ * @param d index of destination node
+ * @return distance or UINT32_MAX if the path was not found
+ */
+uint32_t findDistance(Search* search, const struct indices* idx, uint32_t s, uint32_t d){
+    if(idx->labels){
+        return label_distance(idx->labels,s,d);
+    }
+    return findPath(search,idx,s,d) ? search_distance(search,d) : UINT32_MAX;
+}
+
+/**
+ * @brief printEdges writing edges of found path in DOT format
+ * @param f file for writing
+ * @param search context of finished search
+ * @param s index of starting node
+ * @param d index of destination node
+ * @param indent prefix of each line
+ */
+void printEdges(FILE* f, const Search* search, uint32_t s, uint32_t d, const char* indent){
+    const Csr * csr = search_graph(search);
+    while(d != s){
+        uint32_t p = search_previous(search,d);
+        fprintf(f,"%s%u -> %u [label=%u];\n",indent,csr->ids[p],csr->ids[d],(search_distance(search,d) - search_distance(search,p)));
+        d = p;
+    }
+}
+
+/**
+ * @brief printPath writing found path in DOT format
+ * @param f file for writing
+ * @param search context of finished search
+ * @param s index of starting node
+ * @param d index of destination node
+ */
+void printPath(FILE* f, const Search* search, uint32_t s, uint32_t d){
+    fprintf(f,"digraph {\n");
+    printEdges(f,search,s,d,"\t");
+    fprintf(f,"}\n");
+}
+
+/**
+ * @brief printPaths writing several paths in DOT format
+ *
+ * Each path is a subgraph `pathN` numbered from 1 with a comment giving its
+ * length.
+ *
+ * @param f file for writing
+ * @param search context whose results are replaced by the paths
+ * @param paths paths to be written
+ * @param count number of paths
+ */
+void printPaths(FILE* f, Search* search, const struct yen_path* paths, uint32_t count){
+    fprintf(f,"digraph {\n");
+    for(uint32_t i = 0; i < count; i++){
+        const struct yen_path * p = &paths[i];
+        search_set_path(search,p->nodes,p->dists,p->len);
+        fprintf(f,"\tsubgraph path%u {\n\t\t// dlzka %u\n",i + 1,p->dists[p->len - 1]);
+        printEdges(f,search,p->nodes[0],p->nodes[p->len - 1],"\t\t");
+        fprintf(f,"\t}\n");
+    }
+    fprintf(f,"}\n");
+}
+
+/**
+ * @brief printLine writing found path as a single line
+ *
+ * The line contains ids of both nodes, total distance and ids of all nodes on
+ * the path separated by spaces, e.g. `1,3,12,1 2 3`.
+ *
+ * @param f file for writing
+ * @param search context of finished search
+ * @param s index of starting node
+ * @param d index of destination node
+ * @param path buffer for nodes on the path, resized as needed
+ * @param pathSize size of the buffer
+ * @return true if successful false if memory ran out
+ */
+bool printLine(FILE* f, const Search* search, uint32_t s, uint32_t d, uint32_t** path, size_t* pathSize){
+    const Csr * csr = search_graph(search);
+    size_t len = 0;
+    for(uint32_t n = d; n != CSR_NONE; n = n == s ? CSR_NONE : search_previous(search,n)){
+        if(len == *pathSize){
+            size_t size = *pathSize ? *pathSize * 2 : 64;
+            uint32_t * tmp = realloc(*path,size * sizeof *tmp);
+            if(!tmp){
+                return false;
+            }
+            *path = tmp;
+            *pathSize = size;
+        }
+        (*path)[len++] = n;
+    }
+    fprintf(f,"%u,%u,%u,",csr->ids[s],csr->ids[d],search_distance(search,d));
+    while(len-- > 0){
+        fprintf(f,len ? "%u " : "%u\n",csr->ids[(*path)[len]]);
+    }
+    return true;
+}
+
+/**
+ * @brief compareDoubles comparison function for qsort
+ */
+int compareDoubles(const void* a, const void* b){
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief printLatencies writing latency percentiles of answered queries
+ * @param latencies latency of each query in microseconds, gets sorted
+ * @param len number of queries
+ */
+void printLatencies(double* latencies, size_t len){
+    static const double percentiles[] = { 50, 90, 99, 99.9, 100 };
+    fprintf(stderr,"dotazy: %zu",len);
+    if(len > 0){
+        qsort(latencies,len,sizeof *latencies,compareDoubles);
+        for(size_t i = 0; i < sizeof percentiles / sizeof *percentiles; i++){
+            size_t rank = (size_t) (percentiles[i] / 100 * len + 0.5);
+            rank = rank > 0 ? rank - 1 : 0;
+            fprintf(stderr,", p%g %.1f us",percentiles[i],latencies[rank < len ? rank : len - 1]);
+        }
+    }
+    fputc('\n',stderr);
+}
+
+/** number of queries read and answered at once in batch mode */
+#define BATCH_BLOCK 4096
+
+/**
+ * @brief job single query of a batch
+ */
+struct job {
+    /** line number in the file with queries */
+    size_t line;
+    /** index of starting node */
+    uint32_t source;
+    /** index of destination node */
+    uint32_t destination;
+    /** error message, NULL if the query is valid */
+    const char* error;
+    /** formatted result */
+    char* text;
+    /** length of the result */
+    size_t textLen;
+    /** duration of the search in microseconds, negative if there was no
+     * search */
+    double latency;
+    /** duration of formatting the result in microseconds */
+    double formatting;
+};
+
+/**
+ * @brief worker state owned by one thread of the pool
+ */
+struct worker {
+    /** search context of this thread */
+    Search* search;
+    /** buffer for nodes on a path */
+    uint32_t* path;
+    /** size of the buffer */
+    size_t pathSize;
+};
+
+/**
+ * @brief batchState data shared by all threads answering a block of queries
+ */
+struct batchState {
+    /** queries of the block */
+    struct job* jobs;
+    /** state of each thread */
+    struct worker* workers;
+    /** write one line per path instead of DOT */
+    bool lineFormat;
+    /** write only distances */
+    bool distanceFormat;
+    /** engine and its indices */
+    const struct indices* idx;
+};
+
+/** longest line with a distance, three numbers, two commas and newline */
+#define DISTANCE_LINE 34
+
+/**
+ * @brief runDistanceJob answering one query with distance only
+ * @param state shared data of the block
+ * @param job query to be answered
+ * @param w state of the thread
+ */
+void runDistanceJob(const struct batchState* state, struct job* job, struct worker* w){
+    const Csr * csr = search_graph(w->search);
+    double start = nowMicros();
+    uint32_t dist = findDistance(w->search,state->idx,job->source,job->destination);
+    double end = nowMicros();
+    job->latency = end - start;
+    if(dist == UINT32_MAX){
+        job->error = "cesta neexistuje";
+        return;
+    }
+    job->text = malloc(DISTANCE_LINE + 1);
+    if(!job->text){
+        job->error = "nedostatok pamati";
+        return;
+    }
+    job->textLen = snprintf(job->text,DISTANCE_LINE + 1,"%u,%u,%u\n",csr->ids[job->source],csr->ids[job->destination],dist);
+    job->formatting = nowMicros() - end;
+}
+
+/**
+ * @brief runJob answering one query, called from the thread pool
+ * @param arg shared struct batchState
+ * @param worker index of the thread
+ * @param task index of the query in the block
+ */
+void runJob(void* arg, size_t worker, size_t task){
+    struct batchState * state = arg;
+    struct job * job = &state->jobs[task];
+    struct worker * w = &state->workers[worker];
+    if(job->error){
+        return;
+    }
+    if(state->distanceFormat){
+        runDistanceJob(state,job,w);
+        return;
+    }
+    double start = nowMicros();
+    bool found = findPath(w->search,state->idx,job->source,job->destination);
+    double end = nowMicros();
+    job->latency = end - start;
+    if(!found){
+        job->error = "cesta neexistuje";
+        return;
+    }
+    FILE * f = open_memstream(&job->text,&job->textLen);
+    if(!f){
+        job->error = "nedostatok pamati";
+        return;
+    }
+    if(!state->lineFormat){
+        printPath(f,w->search,job->source,job->destination);
+    }else if(!printLine(f,w->search,job->source,job->destination,&w->path,&w->pathSize)){
+        job->error = "nedostatok pamati";
+    }
+    fclose(f);
+    job->formatting = nowMicros() - end;
+}
+
+/**
+ * @brief parseJob parsing one line with a query
+ * @param csr frozen graph the query is for
+ * @param line text of the line
+ * @param job query to be filled
+ * @return false if the line is empty
+ */
+bool parseJob(const Csr* csr, char* line, struct job* job){
+    char * end = NULL;
+    job->error = NULL;
+    job->text = NULL;
+    job->textLen = 0;
+    job->latency = -1;
+    job->formatting = 0;
+    unsigned long source = strtoul(line,&end,10);
+    if(end == line || *end != ','){
+        job->error = "chybny riadok";
+        return strspn(line," \r\n") != strlen(line);
+    }
+    char * rest = end + 1;
+    unsigned long destination = strtoul(rest,&end,10);
+    if(end == rest || strspn(end," \r\n") != strlen(end)){
+        job->error = "chybny riadok";
+        return true;
+    }
+    job->source = csr_find(csr,source);
+    job->destination = csr_find(csr,destination);
+    if(job->source == CSR_NONE){
+        job->error = "neexistuje vychodzi bod";
+    }else if(job->destination == CSR_NONE){
+        job->error = "neexistuje cielovy bod";
+    }
+    return true;
+}
+
+/**
+ * @brief batch answering many queries against one graph
+ *
+ * Each line of the input contains ids of starting and destination node
+ * separated by a comma. Queries are read in blocks, each block is answered in
+ * parallel and the results are written in the order of the input. Queries
+ * that can not be answered are reported on standard error output with their
+ * line number.
+ *
+ * @param csr frozen graph to be searched
+ * @param opts command line options
+ * @param idx engine and its indices
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int batch(Csr* csr, const struct options* opts, const struct indices* idx){
+    const char * queries = opts->queries;
+    const char * output = opts->argsNum == 1 ? opts->args[0] : NULL;
+    FILE * in = strcmp(queries,"-") == 0 ? stdin : fopen(queries,"r");
+    if(!in){
+        fputs("zadany subor dotazov neexistuje\n",stderr);
+        return 3;
+    }
+    FILE * out = output ? fopen(output,"w") : stdout;
+    if(!out){
+        if(in != stdin){
+            fclose(in);
+        }
+        fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
+        return 7;
+    }
+    int status = 0;
+    Pool * pool = pool_new(opts->threads);
+    size_t workersNum = pool_size(pool);
+    struct batchState state = { NULL, NULL, opts->lineFormat, opts->distanceFormat, idx };
+    state.jobs = malloc(BATCH_BLOCK * sizeof *state.jobs);
+    state.workers = calloc(workersNum,sizeof *state.workers);
+    /* Many endpoints will be looked up, snapshots come without the map. */
+    if(!pool || !state.jobs || !state.workers || !csr_build_idmap(csr)){
+        status = 4;
+    }
+    double phase = nowMicros();
+    for(size_t i = 0; status == 0 && i < workersNum; i++){
+        state.workers[i].search = search_new(searchedGraph(csr,idx),opts->queue);
+        if(!state.workers[i].search){
+            status = 4;
+        }
+    }
+    endPhase(STATS_QUEUE,phase);
+    char * line = NULL;
+    size_t lineSize = 0;
+    size_t lineNum = 0;
+    double * latencies = NULL;
+    size_t latenciesLen = 0;
+    size_t latenciesSize = 0;
+    bool eof = false;
+    while(status == 0 && !eof){
+        size_t jobsNum = 0;
+        while(jobsNum < BATCH_BLOCK){
+            if(getline(&line,&lineSize,in) == -1){
+                eof = true;
+                break;
+            }
+            state.jobs[jobsNum].line = ++lineNum;
+            if(parseJob(csr,line,&state.jobs[jobsNum])){
+                jobsNum++;
+            }
+        }
+        if(latenciesLen + jobsNum > latenciesSize){
+            size_t size = latenciesSize * 2 + BATCH_BLOCK;
+            double * tmp = realloc(latencies,size * sizeof *tmp);
+            if(!tmp){
+                status = 4;
+                break;
+            }
+            latencies = tmp;
+            latenciesSize = size;
+        }
+        pool_run(pool,jobsNum,runJob,&state);
+        phase = nowMicros();
+        for(size_t i = 0; i < jobsNum; i++){
+            struct job * job = &state.jobs[i];
+            stats_add_time(STATS_SEARCH,job->latency >= 0 ? job->latency : 0);
+            stats_add_time(STATS_OUTPUT,job->formatting);
+            if(job->text && !job->error){
+                fwrite(job->text,1,job->textLen,out);
+            }
+            if(job->error){
+                fprintf(stderr,"%s:%zu: %s\n",queries,job->line,job->error);
+            }
+            if(job->latency >= 0){
+                latencies[latenciesLen++] = job->latency;
+            }
+            free(job->text);
+        }
+        endPhase(STATS_OUTPUT,phase);
+    }
+    if(status == 4){
+        fputs("nedostatok pamati pri spracovani dotazov\n",stderr);
+    }
+    printLatencies(latencies,latenciesLen);
+    if(idx->cache){
+        struct cache_stats cs;
+        cache_get_stats(idx->cache,&cs);
+        fprintf(stderr,"cache: zasahy %llu, pokracovania %llu, minutia %llu, vyhodene %llu, stromov %zu, %.1f MiB\n",
+                (unsigned long long) cs.hits,(unsigned long long) cs.resumed,(unsigned long long) cs.misses,
+                (unsigned long long) cs.evicted,cs.trees,cs.memory / 1048576.0);
+    }
+    for(size_t i = 0; state.workers && i < workersNum; i++){
+        search_free(state.workers[i].search);
+        free(state.workers[i].path);
+    }
+    free(state.workers);
+    free(state.jobs);
+    pool_free(pool);
+    free(latencies);
+    free(line);
+    if(in != stdin){
+        fclose(in);
+    }
+    if(out != stdout){
+        fclose(out);
+    }
+    return status;
+}
+
+/**
+ * @brief findPaths finding several shortest loopless paths between two nodes
+ * @param csr frozen graph to be searched
+ * @param opts command line options with number of paths
+ * @param s index of starting node
+ * @param d index of destination node
+ * @param paths where to store array of found paths
+ * @param count where to store number of found paths
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int findPaths(Csr* csr, const struct options* opts, uint32_t s, uint32_t d, struct yen_path** paths, uint32_t* count){
+    *paths = calloc(opts->paths,sizeof **paths);
+    Pool * pool = pool_new(opts->threads);
+    bool ok = *paths && pool && yen_run(csr,pool,s,d,opts->paths,*paths,count);
+    pool_free(pool);
+    if(!ok){
+        fputs("nedostatok pamati pre hladanie ciest\n",stderr);
         return 4;
     }
-    fclose(fNodes);
-    fclose(fEdges);
-    unsigned int source = atoi(argv[3]);
-    unsigned int destination= atoi(argv[4]);
-    Node * s = graph_get_node(graph,source);
-    if(!s){
+    return 0;
+}
+
+/**
+ * @brief printResult writing result of a single query in DOT format
+ * @param f file for writing
+ * @param search context of finished search
+ * @param s index of starting node
+ * @param d index of destination node
+ * @param paths paths found by findPaths() instead of the search, may be NULL
+ * @param count number of the paths
+ */
+void printResult(FILE* f, Search* search, uint32_t s, uint32_t d, const struct yen_path* paths, uint32_t count){
+    if(paths){
+        printPaths(f,search,paths,count);
+    }else{
+        printPath(f,search,s,d);
+    }
+}
+
+/**
+ * @brief query finding and printing shortest path between two nodes
+ * @param csr frozen graph to be searched
+ * @param opts command line options with ids of both nodes
+ * @param idx engine and its indices
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int query(Csr* csr, const struct options* opts, const struct indices* idx){
+    unsigned int source = atoi(opts->args[0]);
+    unsigned int destination = atoi(opts->args[1]);
+    const char * output = opts->argsNum == 3 ? opts->args[2] : NULL;
+    uint32_t s = csr_find(csr,source);
+    if(s == CSR_NONE){
         fputs("neexistuje vychodzi bod\n",stderr);
-        graph_free(graph);
         return 5;
     }
-    Node * d = graph_get_node(graph,destination);
-    if(!d){
+    uint32_t d = csr_find(csr,destination);
+    if(d == CSR_NONE){
         fputs("neexistuje cielovy bod\n",stderr);
-        graph_free(graph);
         return 5;
     }
-    if(s != d){
-        dijkstra(graph,s,d);
-        if(node_get_previous(d) == NULL){
-            fputs("cesta neexistuje\n",stderr);
-            graph_free(graph);
-            return 6;
-        }
+    double phase = nowMicros();
+    Search * search = search_new(searchedGraph(csr,idx),opts->queue);
+    phase = endPhase(STATS_QUEUE,phase);
+    if(!search){
+        fputs("nedostatok pamati pre haldu\n",stderr);
+        return 4;
+    }
+    int status = 0;
+    struct yen_path * paths = NULL;
+    uint32_t count = 0;
+    bool found;
+    if(opts->paths){
+        status = findPaths(csr,opts,s,d,&paths,&count);
+        found = count > 0;
     }else{
-        if(argc == 5){
-            fprintf(stdout,"digraph {\n");
-            fprintf(stdout,"}\n");
-            graph_free(graph);
-            return 0;
+        found = findPath(search,idx,s,d);
+    }
+    phase = endPhase(STATS_SEARCH,phase);
+    if(status != 0){
+        /* Already reported. */
+    }else if(!found){
+        fputs("cesta neexistuje\n",stderr);
+        status = 6;
+    }else if(!output){
+        printResult(stdout,search,s,d,paths,count);
+    }else{
+        FILE * result = fopen(output, "w");
+        if(!result){
+            fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
+            status = 7;
         }else{
-            FILE * result = fopen(argv[5], "w");
-            if(!result){
-                graph_free(graph);
-                fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
-                return 7;
-            }
-            fprintf(result,"digraph {\n");
-            fprintf(result,"}\n");
+            printResult(result,search,s,d,paths,count);
             fclose(result);
-            graph_free(graph);
-            return 0;
         }
     }
-    if(argc == 5){
-        fprintf(stdout,"digraph {\n");
-        while(d != s){
-            fprintf(stdout,"\t%u -> %u [label=%u];\n", node_get_id(node_get_previous(d)),node_get_id(d),(node_get_distance(d) - node_get_distance(node_get_previous(d))));
-            d = node_get_previous(d);
+    endPhase(STATS_OUTPUT,phase);
+    yen_free_paths(paths,count);
+    free(paths);
+    search_free(search);
+    return status;
+}
+
+/**
+ * @brief applyUpdate parsing one line with a change of an edge and applying it
+ * @param csr frozen graph the change is for
+ * @param dynamic paths to be repaired later
+ * @param line text of the line
+ * @param status set to 4 if memory ran out
+ * @return error message or NULL if the change was applied
+ */
+const char* applyUpdate(const Csr* csr, Dynamic* dynamic, char* line, int* status){
+    char * end = NULL;
+    unsigned long source = strtoul(line,&end,10);
+    if(end == line || *end != ','){
+        return "chybny riadok";
+    }
+    char * rest = end + 1;
+    unsigned long destination = strtoul(rest,&end,10);
+    if(end == rest || *end != ','){
+        return "chybny riadok";
+    }
+    rest = end + 1;
+    bool remove = *rest == '-' && strspn(rest + 1," \r\n") == strlen(rest + 1);
+    long delay = remove ? 0 : strtol(rest,&end,10);
+    if(!remove && (end == rest || strspn(end," \r\n") != strlen(end))){
+        return "chybny riadok";
+    }
+    if(delay < 0 || delay > INT_MAX){
+        return "zaporne alebo prilis velke oneskorenie";
+    }
+    uint32_t s = csr_find(csr,source);
+    uint32_t d = csr_find(csr,destination);
+    if(s == CSR_NONE){
+        return "neexistuje vychodzi bod";
+    }
+    if(d == CSR_NONE){
+        return "neexistuje cielovy bod";
+    }
+    bool removed = true;
+    if(remove ? !dynamic_remove_edge(dynamic,s,d,&removed) : !dynamic_set_edge(dynamic,s,d,delay)){
+        *status = 4;
+        return "nedostatok pamati";
+    }
+    return removed ? NULL : "hrana neexistuje";
+}
+
+/**
+ * @brief applyUpdates changing edges and repairing shortest paths
+ *
+ * Each line of the input contains ids of both ends of an edge and its new
+ * delay separated by commas, the edge is inserted if it does not exist;
+ * `-` instead of the delay removes the edge. An empty line ends a batch of
+ * changes, after which the paths are repaired, as well as the end of the
+ * input. Lines that can not be applied are reported on standard error output
+ * with their line number.
+ *
+ * @param csr frozen graph the changes are for
+ * @param opts command line options with the file of changes
+ * @param dynamic paths from the starting node to be repaired
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int applyUpdates(Csr* csr, const struct options* opts, Dynamic* dynamic){
+    FILE * in = strcmp(opts->updates,"-") == 0 ? stdin : fopen(opts->updates,"r");
+    if(!in){
+        fputs("zadany subor zmien neexistuje\n",stderr);
+        return 3;
+    }
+    int status = csr_build_idmap(csr) ? 0 : 4;
+    char * line = NULL;
+    size_t lineSize = 0;
+    size_t lineNum = 0;
+    size_t batchNum = 0;
+    size_t changes = 0;
+    bool eof = false;
+    double phase = nowMicros();
+    while(status == 0 && !eof){
+        eof = getline(&line,&lineSize,in) == -1;
+        if(!eof && strspn(line," \r\n") != strlen(line)){
+            const char * error = applyUpdate(csr,dynamic,line,&status);
+            lineNum++;
+            if(error){
+                fprintf(stderr,"%s:%zu: %s\n",opts->updates,lineNum,error);
+            }else{
+                changes++;
+            }
+            continue;
+        }
+        lineNum += !eof;
+        if(changes == 0){
+            continue;
+        }
+        phase = endPhase(STATS_LOAD_EDGES,phase);
+        if(!dynamic_repair(dynamic)){
+            status = 4;
+            break;
+        }
+        double end = endPhase(STATS_SEARCH,phase);
+        batchNum++;
+        if(opts->verbose){
+            fprintf(stderr,"davka %zu: zmien %zu, prepocitanych vrcholov %u, %.1f ms\n",
+                    batchNum,changes,dynamic_settled(dynamic),(end - phase) / 1e3);
+        }
+        phase = end;
+        changes = 0;
+    }
+    endPhase(STATS_LOAD_EDGES,phase);
+    free(line);
+    if(in != stdin){
+        fclose(in);
+    }
+    return status;
+}
+
+/**
+ * @brief allPaths finding shortest paths from one node to all nodes
+ *
+ * Every reachable node is written as a line `vrchol,vzdialenost,predchodca`,
+ * the predecessor of the starting node is empty. With changes of edges the
+ * paths are written after all of them were applied.
+ *
+ * @param csr frozen graph to be searched
+ * @param opts command line options with id of the starting node
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int allPaths(Csr* csr, const struct options* opts){
+    unsigned int source = atoi(opts->args[0]);
+    const char * output = opts->argsNum == 2 ? opts->args[1] : NULL;
+    uint32_t s = csr_find(csr,source);
+    if(s == CSR_NONE){
+        fputs("neexistuje vychodzi bod\n",stderr);
+        return 5;
+    }
+    FILE * out = output ? fopen(output,"w") : stdout;
+    if(!out){
+        fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
+        return 7;
+    }
+    int status = 0;
+    Pool * pool = NULL;
+    Delta * delta = NULL;
+    Search * search = NULL;
+    Dynamic * dynamic = NULL;
+    double phase = nowMicros();
+    if(opts->updates){
+        dynamic = dynamic_new(csr,opts->queue);
+        phase = endPhase(STATS_QUEUE,phase);
+        if(!dynamic || !dynamic_run(dynamic,s)){
+            status = 4;
+        }
+        phase = endPhase(STATS_SEARCH,phase);
+        if(status == 0){
+            status = applyUpdates(csr,opts,dynamic);
+        }
+        phase = nowMicros();
+    }else if(opts->engine == ENGINE_DELTA){
+        pool = pool_new(opts->threads);
+        delta = pool ? delta_new(csr,opts->delta,pool) : NULL;
+        phase = endPhase(STATS_QUEUE,phase);
+        if(!delta || !delta_run(delta,s)){
+            status = 4;
         }
-        fprintf(stdout,"}\n");
     }else{
-        FILE * result = fopen(argv[5], "w");
-        if(!result){
-            graph_free(graph);
-            fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
-            return 7;
+        search = search_new(csr,opts->queue);
+        phase = endPhase(STATS_QUEUE,phase);
+        if(!search || !search_run_all(search,s,false)){
+            status = 4;
         }
-        fprintf(result,"digraph {\n");
-        while(d != s){
-            fprintf(result,"\t%u -> %u [label=%u];\n", node_get_id(node_get_previous(d)),node_get_id(d),(node_get_distance(d) - node_get_distance(node_get_previous(d))));
-            d = node_get_previous(d);
+    }
+    phase = endPhase(STATS_SEARCH,phase);
+    for(uint32_t n = 0; status == 0 && n < csr->nodes_num; n++){
+        uint32_t dist, prev;
+        if(dynamic){
+            dist = dynamic_distance(dynamic,n);
+            prev = dynamic_previous(dynamic,n);
+        }else if(delta){
+            dist = delta_distance(delta,n);
+            prev = delta_previous(delta,n);
+        }else{
+            dist = search_distance(search,n);
+            prev = search_previous(search,n);
+        }
+        if(dist == UINT32_MAX){
+            continue;
+        }
+        if(prev == CSR_NONE){
+            fprintf(out,"%u,%u,\n",csr->ids[n],dist);
+        }else{
+            fprintf(out,"%u,%u,%u\n",csr->ids[n],dist,csr->ids[prev]);
         }
-        fprintf(result,"}\n");
-        fclose(result);
     }
-    graph_free(graph);
+    endPhase(STATS_OUTPUT,phase);
+    if(status == 4){
+        fputs("nedostatok pamati pri hladani\n",stderr);
+    }
+    search_free(search);
+    delta_free(delta);
+    dynamic_free(dynamic);
+    pool_free(pool);
+    if(out != stdout){
+        fclose(out);
+    }
+    return status;
+}
+
+/**
+ * @brief loadNodeList reading identifiers of nodes and finding their indices
+ * @param csr frozen graph containing the nodes
+ * @param path file with one identifier per line
+ * @param nodes where to store allocated array of indices
+ * @param len where to store number of nodes
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int loadNodeList(const Csr* csr, const char* path, uint32_t** nodes, uint32_t* len){
+    uint32_t *ids = NULL;
+    size_t count = 0;
+    enum loader_status status = loader_read_nodes(path,&ids,&count);
+    if(status == LOADER_NO_FILE){
+        fprintf(stderr,"zadany zoznam vrcholov %s neexistuje\n",path);
+        return 3;
+    }
+    if(status == LOADER_NO_MEMORY || count >= UINT32_MAX){
+        fputs("nedostatok pamati pri nacitavani zoznamu vrcholov\n",stderr);
+        free(ids);
+        return 4;
+    }
+    for(size_t i = 0; i < count; i++){
+        ids[i] = csr_find(csr,ids[i]);
+        if(ids[i] == CSR_NONE){
+            fprintf(stderr,"vrchol zo zoznamu %s neexistuje\n",path);
+            free(ids);
+            return 5;
+        }
+    }
+    *nodes = ids;
+    *len = count;
     return 0;
 }
+
+/**
+ * @brief distanceMatrix finding distances from every node of one list to
+ * every node of another list
+ *
+ * The matrix is written as CSV with identifiers of targets in the first line
+ * and identifiers of sources in the first column, or in binary form
+ * described in matrix.h.
+ *
+ * @param csr frozen graph to be searched
+ * @param opts command line options with files listing the nodes
+ * @return 0 if successful, exit status of the program otherwise
+ */
+int distanceMatrix(Csr* csr, const struct options* opts){
+    const char * output = opts->argsNum == 3 ? opts->args[2] : NULL;
+    if(!csr_build_idmap(csr)){
+        fputs("nedostatok pamati pre mapu vrcholov\n",stderr);
+        return 4;
+    }
+    uint32_t *sources = NULL;
+    uint32_t *targets = NULL;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    int status = loadNodeList(csr,opts->args[0],&sources,&rows);
+    if(status == 0){
+        status = loadNodeList(csr,opts->args[1],&targets,&cols);
+    }
+    Matrix * matrix = NULL;
+    if(status == 0){
+        double phase = nowMicros();
+        Pool * pool = pool_new(opts->threads);
+        matrix = pool ? matrix_compute(csr,sources,rows,targets,cols,opts->queue,pool) : NULL;
+        pool_free(pool);
+        endPhase(STATS_SEARCH,phase);
+        if(!matrix){
+            fputs("nedostatok pamati pri hladani\n",stderr);
+            status = 4;
+        }
+    }
+    FILE * out = NULL;
+    if(status == 0){
+        out = output ? fopen(output,opts->binaryFormat ? "wb" : "w") : stdout;
+        if(!out){
+            fputs("nepodarilo sa otvorit subor na vypis\n",stderr);
+            status = 7;
+        }
+    }
+    if(status == 0){
+        double phase = nowMicros();
+        bool written = opts->binaryFormat ? matrix_write_binary(matrix,csr,out)
+            : matrix_write_csv(matrix,csr,out);
+        if(out != stdout && fclose(out) != 0){
+            written = false;
+        }
+        if(!written){
+            fputs("nepodarilo sa zapisat maticu vzdialenosti\n",stderr);
+            status = 7;
+        }
+        endPhase(STATS_OUTPUT,phase);
+    }
+    matrix_free(matrix);
+    free(sources);
+    free(targets);
+    return status;
+}
+
+int main(int argc, char* argv[]){
+    struct options opts;
+    if(!parseOptions(argc,argv,&opts)){
+        fputs("zly pocet argumentov\n",stderr);
+        return 1;
+    }
+    Csr * csr = NULL;
+    struct indices idx = { ENGINE_DIJKSTRA, NULL, NULL, NULL, NULL, NULL, NULL };
+    int status = 0;
+    double phase = nowMicros();
+    if(opts.snapshot){
+        csr = snapshot_open(opts.snapshot,opts.verify);
+        phase = endPhase(STATS_SNAPSHOT,phase);
+        if(!csr){
+            fputs("zadany snapshot neexistuje alebo je poskodeny\n",stderr);
+            return 3;
+        }
+    }else{
+        status = loadGraph(opts.nodes,opts.edges,opts.duplicates,opts.verbose,&csr);
+    }
+    phase = nowMicros();
+    if(status == 0){
+        status = reorderGraph(&csr,opts.reorder);
+    }
+    phase = endPhase(STATS_INDEX,phase);
+    if(status == 0 && opts.saveSnapshot && !snapshot_save(csr,opts.saveSnapshot)){
+        fputs("nepodarilo sa ulozit snapshot\n",stderr);
+        status = 7;
+    }
+    phase = endPhase(STATS_OUTPUT,phase);
+    if(status == 0){
+        status = prepareEngine(csr,&opts,&idx);
+    }
+    endPhase(STATS_INDEX,phase);
+    if(status == 0 && opts.matrix){
+        status = distanceMatrix(csr,&opts);
+    }else if(status == 0 && opts.all){
+        status = allPaths(csr,&opts);
+    }else if(status == 0 && opts.queries){
+        status = batch(csr,&opts,&idx);
+    }else if(status == 0 && opts.argsNum > 0){
+        status = query(csr,&opts,&idx);
+    }
+    alt_free(idx.landmarks);
+    ch_free(idx.hierarchy);
+    scc_free(idx.components);
+    packed_free(idx.packed);
+    cache_free(idx.cache);
+    label_free(idx.labels);
+    csr_free(csr);
+    /* Counters are added to the totals when their owners are freed. */
+    if(opts.stats && !stats_write_json(stderr)){
+        status = 7;
+    }
+    return status;
+}
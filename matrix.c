@@ -0,0 +1,178 @@
+/**
+ * Functions for matrices of distances between groups of nodes.
+ *
+ * Every thread owns one search context and computes whole rows, so rows can
+ * be written without any synchronization.
+ *
+ * @file    matrix.c
+ */
+#include "matrix.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "binfile.h"
+#include "search.h"
+
+/** Magic bytes at the start of binary matrices */
+static const char MATRIX_MAGIC[8] = "DIMEMATX";
+
+/** Header of a binary matrix. */
+struct matrix_header {
+    /** Always `MATRIX_MAGIC` */
+    char magic[8];
+    /** Format version */
+    uint32_t version;
+    /** Always `BINFILE_BYTE_ORDER` in byte order of the writer */
+    uint32_t byte_order;
+    /** Number of starting nodes */
+    uint32_t rows;
+    /** Number of target nodes */
+    uint32_t cols;
+};
+
+/** State of computation of a matrix shared by all threads. */
+struct fill {
+    /** Matrix being computed */
+    Matrix *m;
+    /** Search context of each thread */
+    Search **searches;
+    /** Whether memory ran out in each thread */
+    bool *failed;
+};
+
+/**
+ * Compute one row, called from the thread pool.
+ *
+ * @param arg       shared struct fill
+ * @param worker    index of the thread
+ * @param task      index of the row
+ */
+static void fill_task(void *arg, size_t worker, size_t task)
+{
+    struct fill *f = arg;
+    Matrix *m = f->m;
+    Search *s = f->searches[worker];
+    if (!search_run_targets(s, m->sources[task], m->targets, m->cols)) {
+        f->failed[worker] = true;
+        return;
+    }
+    uint32_t *row = m->dist + task * m->cols;
+    for (uint32_t j = 0; j < m->cols; j++) {
+        row[j] = search_distance(s, m->targets[j]);
+    }
+}
+
+Matrix * matrix_compute(const Csr *csr, const uint32_t *sources, uint32_t rows,
+        const uint32_t *targets, uint32_t cols, enum pq_kind queue,
+        Pool *pool)
+{
+    if (!csr || (!sources && rows > 0) || (!targets && cols > 0)) return NULL;
+    Matrix *m = calloc(1, sizeof *m);
+    if (!m) return NULL;
+    m->rows = rows;
+    m->cols = cols;
+    m->sources = malloc(((size_t) rows + 1) * sizeof *m->sources);
+    m->targets = malloc(((size_t) cols + 1) * sizeof *m->targets);
+    m->dist = malloc(((size_t) rows * cols + 1) * sizeof *m->dist);
+    if (!m->sources || !m->targets || !m->dist) {
+        matrix_free(m);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < rows; i++) {
+        m->sources[i] = sources[i];
+    }
+    for (uint32_t j = 0; j < cols; j++) {
+        m->targets[j] = targets[j];
+    }
+
+    size_t workers = pool_size(pool);
+    struct fill f = { m, NULL, NULL };
+    f.searches = calloc(workers, sizeof *f.searches);
+    f.failed = calloc(workers, sizeof *f.failed);
+    bool ok = f.searches && f.failed;
+    for (size_t i = 0; ok && i < workers; i++) {
+        f.searches[i] = search_new(csr, queue);
+        ok = f.searches[i] != NULL;
+    }
+    if (ok) {
+        pool_run(pool, rows, fill_task, &f);
+        for (size_t i = 0; i < workers; i++) {
+            ok = ok && !f.failed[i];
+        }
+    }
+    for (size_t i = 0; f.searches && i < workers; i++) {
+        search_free(f.searches[i]);
+    }
+    free(f.searches);
+    free(f.failed);
+    if (!ok) {
+        matrix_free(m);
+        return NULL;
+    }
+    return m;
+}
+
+bool matrix_write_csv(const Matrix *m, const Csr *csr, FILE *f)
+{
+    if (!m || !csr || !f) return false;
+    for (uint32_t j = 0; j < m->cols; j++) {
+        fprintf(f, ",%u", csr->ids[m->targets[j]]);
+    }
+    fputc('\n', f);
+    for (uint32_t i = 0; i < m->rows; i++) {
+        const uint32_t *row = m->dist + (size_t) i * m->cols;
+        fprintf(f, "%u", csr->ids[m->sources[i]]);
+        for (uint32_t j = 0; j < m->cols; j++) {
+            if (row[j] == UINT32_MAX) {
+                fputc(',', f);
+            } else {
+                fprintf(f, ",%u", row[j]);
+            }
+        }
+        fputc('\n', f);
+    }
+    return !ferror(f);
+}
+
+/**
+ * Write identifiers of nodes.
+ *
+ * @param csr       graph the nodes belong to
+ * @param nodes     indices of the nodes
+ * @param len       number of nodes
+ * @param f         file to write to
+ * @return          true if successful, false if writing failed
+ */
+static bool write_ids(const Csr *csr, const uint32_t *nodes, uint32_t len,
+        FILE *f)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t id = csr->ids[nodes[i]];
+        if (fwrite(&id, sizeof id, 1, f) != 1) return false;
+    }
+    return true;
+}
+
+bool matrix_write_binary(const Matrix *m, const Csr *csr, FILE *f)
+{
+    if (!m || !csr || !f) return false;
+    struct matrix_header hdr = { {0}, MATRIX_VERSION, BINFILE_BYTE_ORDER,
+        m->rows, m->cols };
+    memcpy(hdr.magic, MATRIX_MAGIC, sizeof hdr.magic);
+    size_t len = (size_t) m->rows * m->cols;
+    return fwrite(&hdr, sizeof hdr, 1, f) == 1
+        && write_ids(csr, m->sources, m->rows, f)
+        && write_ids(csr, m->targets, m->cols, f)
+        && fwrite(m->dist, sizeof *m->dist, len, f) == len;
+}
+
+void matrix_free(Matrix *m)
+{
+    if (m) {
+        free(m->sources);
+        free(m->targets);
+        free(m->dist);
+    }
+    free(m);
+}
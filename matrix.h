@@ -0,0 +1,93 @@
+/**
+ * Interface for matrices of distances between groups of nodes.
+ *
+ * Rows of a matrix belong to starting nodes and columns to target nodes.
+ * Each row is computed by a single search that stops as soon as all targets
+ * are finished; rows are computed in parallel.
+ *
+ * Binary files hold a header followed by identifiers of the starting nodes,
+ * identifiers of the target nodes and the distances row by row, all as
+ * 32-bit unsigned integers in native byte order. Unreachable targets have
+ * distance `UINT32_MAX`.
+ *
+ * @file    matrix.h
+ */
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "csr.h"
+#include "pool.h"
+#include "pq.h"
+
+/** Version of the binary matrix format written by this program. */
+#define MATRIX_VERSION 1
+
+/** Matrix of distances. */
+typedef struct matrix Matrix;
+
+/** Representation of a matrix of distances. */
+struct matrix {
+    /** Number of starting nodes */
+    uint32_t rows;
+    /** Number of target nodes */
+    uint32_t cols;
+    /** Index of each starting node */
+    uint32_t *sources;
+    /** Index of each target node */
+    uint32_t *targets;
+    /** Distance from starting node `i` to target `j` at position
+     * `i * cols + j`, `UINT32_MAX` if it is unreachable */
+    uint32_t *dist;
+};
+
+/**
+ * Compute distances from every starting node to every target.
+ *
+ * @param csr       frozen graph
+ * @param sources   indices of starting nodes
+ * @param rows      number of starting nodes
+ * @param targets   indices of target nodes
+ * @param cols      number of target nodes
+ * @param queue     priority queue used by the searches
+ * @param pool      threads running the searches, may be NULL
+ * @return          matrix or NULL if memory ran out
+ */
+Matrix * matrix_compute(const Csr *csr, const uint32_t *sources, uint32_t rows,
+        const uint32_t *targets, uint32_t cols, enum pq_kind queue,
+        Pool *pool);
+
+/**
+ * Write a matrix as CSV.
+ * The first line holds identifiers of the targets after an empty field, each
+ * following line the identifier of a starting node and its distances.
+ * Unreachable targets are left empty.
+ *
+ * @param m     matrix to be written
+ * @param csr   graph the matrix was computed for
+ * @param f     file to write to
+ * @return      true if successful, false if writing failed
+ */
+bool matrix_write_csv(const Matrix *m, const Csr *csr, FILE *f);
+
+/**
+ * Write a matrix in binary form.
+ *
+ * @param m     matrix to be written
+ * @param csr   graph the matrix was computed for
+ * @param f     file to write to
+ * @return      true if successful, false if writing failed
+ */
+bool matrix_write_binary(const Matrix *m, const Csr *csr, FILE *f);
+
+/**
+ * Free a matrix.
+ *
+ * @param m     matrix to be freed
+ */
+void matrix_free(Matrix *m);
+
+#endif /* end of include guard: MATRIX_H */
@@ -0,0 +1,148 @@
+/**
+ * Functions for compressed outgoing edges of frozen graphs.
+ *
+ * @file    packed.c
+ */
+#include "packed.h"
+
+#include <stdlib.h>
+
+/** Longest encoding of a 32-bit value */
+#define VARINT_MAX 5
+
+/**
+ * Append a variable length integer.
+ *
+ * @param out       position to write to
+ * @param value     value to be encoded
+ * @return          position behind the written bytes
+ */
+static uint8_t * put_varint(uint8_t *out, uint32_t value)
+{
+    while (value >= 0x80) {
+        *out++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t) value;
+    return out;
+}
+
+/**
+ * Encode a signed value so that small magnitudes give small results.
+ *
+ * @param value     value to be encoded
+ * @return          zigzag encoded value
+ */
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t) value << 1) ^ (uint32_t) -(int32_t) (value < 0);
+}
+
+/**
+ * Compare edges by destination, packed with weight in the lower half.
+ *
+ * @param a     first edge
+ * @param b     second edge
+ * @return      negative, zero or positive number as for qsort()
+ */
+static int edge_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Encode sorted edges of one node.
+ *
+ * @param out       position to write to
+ * @param node      index of the node
+ * @param edges     edges with destination in the upper half and weight in
+ *                  the lower half
+ * @param len       number of edges
+ * @return          position behind the written bytes
+ */
+static uint8_t * encode(uint8_t *out, uint32_t node, const uint64_t *edges,
+        size_t len)
+{
+    uint32_t last = node;
+    for (size_t i = 0; i < len; i++) {
+        uint32_t target = edges[i] >> 32;
+        uint32_t delta = target - last;
+        out = put_varint(out, i == 0 ? zigzag((int32_t) delta) : delta);
+        out = put_varint(out, zigzag((int32_t) (uint32_t) edges[i]));
+        last = target;
+    }
+    return out;
+}
+
+Packed * packed_new(const Csr *csr)
+{
+    if (!csr) return NULL;
+    Packed *p = calloc(1, sizeof *p);
+    if (!p) return NULL;
+    p->nodes_num = csr->nodes_num;
+    p->edges_num = csr->edges_num;
+    uint32_t max_degree = 0;
+    for (uint32_t v = 0; v < csr->nodes_num; v++) {
+        uint32_t degree = csr->offsets[v + 1] - csr->offsets[v];
+        if (degree > max_degree) max_degree = degree;
+    }
+    p->offsets = malloc(((size_t) csr->nodes_num + 1) * sizeof *p->offsets);
+    uint64_t *edges = malloc(((size_t) max_degree + 1) * sizeof *edges);
+    /* Most edges take a few bytes, the buffer grows when a node might not
+     * fit. */
+    size_t size = (size_t) csr->edges_num * 3 + 2 * VARINT_MAX;
+    uint8_t *data = malloc(size);
+    bool ok = p->offsets && edges && data;
+
+    size_t used = 0;
+    for (uint32_t v = 0; ok && v < csr->nodes_num; v++) {
+        size_t len = 0;
+        for (uint32_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++) {
+            edges[len++] = (uint64_t) csr->targets[e] << 32
+                | (uint32_t) csr->weights[e];
+        }
+        if (used + len * 2 * VARINT_MAX > size) {
+            size_t bigger = size + size / 2 + len * 2 * VARINT_MAX;
+            uint8_t *tmp = realloc(data, bigger);
+            if (!tmp) {
+                ok = false;
+                break;
+            }
+            data = tmp;
+            size = bigger;
+        }
+        qsort(edges, len, sizeof *edges, edge_compare);
+        p->offsets[v] = used;
+        used = encode(data + used, v, edges, len) - data;
+    }
+    free(edges);
+    if (!ok) {
+        free(data);
+        packed_free(p);
+        return NULL;
+    }
+    p->offsets[csr->nodes_num] = used;
+    p->data = realloc(data, used + 1);
+    if (!p->data) {
+        p->data = data;
+    }
+    return p;
+}
+
+size_t packed_memory(const Packed *p)
+{
+    if (!p) return 0;
+    return ((size_t) p->nodes_num + 1) * sizeof *p->offsets
+        + p->offsets[p->nodes_num];
+}
+
+void packed_free(Packed *p)
+{
+    if (p) {
+        free(p->offsets);
+        free(p->data);
+    }
+    free(p);
+}
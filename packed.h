@@ -0,0 +1,142 @@
+/**
+ * Interface for compressed outgoing edges of frozen graphs.
+ *
+ * Edges of each node are sorted by destination and stored as variable
+ * length integers: the first destination relative to the node itself, the
+ * following ones as differences from the previous destination, each followed
+ * by its weight. Seven bits are stored per byte, the highest bit marks that
+ * more bytes follow. Signed values are zigzag encoded, so small negative
+ * numbers stay short.
+ *
+ * Neighbours in real networks tend to have close indices and weights are
+ * small, so most edges take two or three bytes instead of eight.
+ *
+ * @file    packed.h
+ */
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "csr.h"
+
+/** Compressed edges of a graph. */
+typedef struct packed Packed;
+
+/** Representation of compressed edges. */
+struct packed {
+    /** Number of nodes */
+    uint32_t nodes_num;
+    /** Number of edges */
+    uint32_t edges_num;
+    /** Position of the first byte of each node in `data`, `nodes_num + 1`
+     * elements */
+    uint64_t *offsets;
+    /** Encoded edges */
+    uint8_t *data;
+};
+
+/** Position in the encoded edges of one node. */
+struct packed_cursor {
+    /** Next byte to decode */
+    const uint8_t *pos;
+    /** End of edges of the node */
+    const uint8_t *end;
+    /** Destination of the previous edge, the node itself at first */
+    uint32_t last;
+    /** Whether the first edge was not read yet */
+    bool first;
+};
+
+/**
+ * Compress outgoing edges of a graph.
+ *
+ * @param csr   frozen graph
+ * @return      compressed edges or NULL if memory ran out
+ */
+Packed * packed_new(const Csr *csr);
+
+/**
+ * Get memory taken by compressed edges.
+ *
+ * @param p     compressed edges
+ * @return      size of the arrays in bytes
+ */
+size_t packed_memory(const Packed *p);
+
+/**
+ * Free compressed edges.
+ *
+ * @param p     compressed edges to be freed
+ */
+void packed_free(Packed *p);
+
+/**
+ * Start reading outgoing edges of a node.
+ *
+ * @param p         compressed edges
+ * @param node      index of the node
+ * @param cursor    cursor to be set
+ */
+static inline void packed_edges(const Packed *p, uint32_t node,
+        struct packed_cursor *cursor)
+{
+    cursor->pos = p->data + p->offsets[node];
+    cursor->end = p->data + p->offsets[node + 1];
+    cursor->last = node;
+    cursor->first = true;
+}
+
+/**
+ * Decode one variable length integer.
+ *
+ * @param pos   position of the integer, moved behind it
+ * @return      decoded value
+ */
+static inline uint32_t packed_varint(const uint8_t **pos)
+{
+    const uint8_t *p = *pos;
+    uint32_t value = *p++;
+    if (value >= 0x80) {
+        value &= 0x7f;
+        int shift = 7;
+        uint8_t byte;
+        do {
+            byte = *p++;
+            value |= (uint32_t) (byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte >= 0x80);
+    }
+    *pos = p;
+    return value;
+}
+
+/**
+ * Read next outgoing edge.
+ *
+ * @param cursor        cursor of the node
+ * @param target[out]   destination of the edge
+ * @param weight[out]   weight of the edge
+ * @return              false if there are no more edges
+ */
+static inline bool packed_next(struct packed_cursor *cursor,
+        uint32_t *target, int32_t *weight)
+{
+    if (cursor->pos >= cursor->end) return false;
+    uint32_t delta = packed_varint(&cursor->pos);
+    if (cursor->first) {
+        /* Only the first difference may be negative. */
+        cursor->last += (delta >> 1) ^ -(delta & 1);
+        cursor->first = false;
+    } else {
+        cursor->last += delta;
+    }
+    uint32_t w = packed_varint(&cursor->pos);
+    *target = cursor->last;
+    *weight = (int32_t) ((w >> 1) ^ -(w & 1));
+    return true;
+}
+
+#endif /* end of include guard: PACKED_H */
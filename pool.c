@@ -0,0 +1,166 @@
+/**
+ * Functions for running tasks on a pool of threads.
+ *
+ * @file    pool.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** Upper limit of workers in a pool */
+#define MAX_WORKERS 256
+
+struct pool {
+    /** Number of workers including the calling thread */
+    size_t size;
+    pthread_t threads[MAX_WORKERS];
+    pthread_mutex_t lock;
+    /** Signalled when new work is submitted or the pool is stopped */
+    pthread_cond_t work;
+    /** Signalled when a worker finishes its part of the work */
+    pthread_cond_t done;
+    /** Incremented with every call to pool_run() */
+    unsigned long generation;
+    /** Current work */
+    pool_task fn;
+    void *arg;
+    size_t tasks;
+    /** Next task to be handed out */
+    size_t next;
+    /** Number of workers still working on current work */
+    size_t busy;
+    /** Set when the pool is being freed */
+    bool stop;
+};
+
+/** Argument of a worker thread. */
+struct worker {
+    Pool *pool;
+    size_t index;
+};
+
+size_t pool_default_threads(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return cpus < MAX_WORKERS ? (size_t) cpus : MAX_WORKERS;
+}
+
+/**
+ * Run tasks of current work until there are none left.
+ *
+ * @param p         pool with the lock held, the lock is held on return too
+ * @param worker    index of the worker
+ */
+static void work(Pool *p, size_t worker)
+{
+    while (p->next < p->tasks) {
+        size_t task = p->next++;
+        pthread_mutex_unlock(&p->lock);
+        p->fn(p->arg, worker, task);
+        pthread_mutex_lock(&p->lock);
+    }
+    if (--p->busy == 0) {
+        pthread_cond_broadcast(&p->done);
+    }
+}
+
+/**
+ * Main loop of a worker thread.
+ *
+ * @param arg   struct worker, freed by this function
+ * @return      NULL
+ */
+static void * worker_main(void *arg)
+{
+    struct worker *w = arg;
+    Pool *p = w->pool;
+    size_t index = w->index;
+    free(w);
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!p->stop && p->generation == seen) {
+            pthread_cond_wait(&p->work, &p->lock);
+        }
+        if (p->stop) break;
+        seen = p->generation;
+        work(p, index);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+Pool * pool_new(size_t threads)
+{
+    Pool *p = calloc(1, sizeof *p);
+    if (!p) return NULL;
+    if (threads == 0) threads = pool_default_threads();
+    if (threads > MAX_WORKERS) threads = MAX_WORKERS;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work, NULL);
+    pthread_cond_init(&p->done, NULL);
+    p->size = 1;
+    while (p->size < threads) {
+        struct worker *w = malloc(sizeof *w);
+        if (!w) break;
+        w->pool = p;
+        w->index = p->size;
+        if (pthread_create(&p->threads[p->size], NULL, worker_main, w) != 0) {
+            free(w);
+            break;
+        }
+        p->size++;
+    }
+    return p;
+}
+
+size_t pool_size(const Pool *p)
+{
+    return p ? p->size : 1;
+}
+
+void pool_run(Pool *p, size_t tasks, pool_task fn, void *arg)
+{
+    if (!p) {
+        for (size_t i = 0; i < tasks; i++) {
+            fn(arg, 0, i);
+        }
+        return;
+    }
+    pthread_mutex_lock(&p->lock);
+    p->fn = fn;
+    p->arg = arg;
+    p->tasks = tasks;
+    p->next = 0;
+    p->busy = p->size;
+    p->generation++;
+    pthread_cond_broadcast(&p->work);
+    work(p, 0);
+    while (p->busy > 0) {
+        pthread_cond_wait(&p->done, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+void pool_free(Pool *p)
+{
+    if (!p) return;
+    pthread_mutex_lock(&p->lock);
+    p->stop = true;
+    pthread_cond_broadcast(&p->work);
+    pthread_mutex_unlock(&p->lock);
+    for (size_t i = 1; i < p->size; i++) {
+        pthread_join(p->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->work);
+    pthread_cond_destroy(&p->done);
+    free(p);
+}
@@ -0,0 +1,75 @@
+/**
+ * Interface for running tasks on a pool of threads.
+ *
+ * A pool keeps a fixed number of worker threads. Work is submitted as a
+ * number of independent tasks sharing one function; pool_run() blocks until
+ * all of them are finished. The calling thread takes part in the work as
+ * worker zero.
+ *
+ * @file    pool.h
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/**
+ * Pool is an opaque structure.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct pool Pool;
+
+/**
+ * Function executing a single task.
+ *
+ * @param arg       argument given to pool_run()
+ * @param worker    index of the worker running the task, lower than
+ *                  pool_size()
+ * @param task      index of the task
+ */
+typedef void (*pool_task)(void *arg, size_t worker, size_t task);
+
+/**
+ * Get number of processors available to the program.
+ *
+ * @return  number of online processors, at least one
+ */
+size_t pool_default_threads(void);
+
+/**
+ * Create a new pool.
+ * If threads can not be started, the pool is created with fewer workers.
+ *
+ * @param threads   number of workers including the calling thread, zero
+ *                  means pool_default_threads()
+ * @return          new pool or NULL if memory is exhausted
+ */
+Pool * pool_new(size_t threads);
+
+/**
+ * Get number of workers of a pool.
+ *
+ * @param p     pool to query
+ * @return      number of workers
+ */
+size_t pool_size(const Pool *p);
+
+/**
+ * Run tasks on all workers and wait for them to finish.
+ * Tasks are handed out in ascending order, but may finish in any order.
+ *
+ * @param p     pool to run on
+ * @param tasks number of tasks
+ * @param fn    function executing the tasks
+ * @param arg   argument passed to the function
+ */
+void pool_run(Pool *p, size_t tasks, pool_task fn, void *arg);
+
+/**
+ * Stop all workers and free the pool.
+ *
+ * @param p     pool to be freed
+ */
+void pool_free(Pool *p);
+
+#endif /* end of include guard: POOL_H */
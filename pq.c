@@ -0,0 +1,625 @@
+/**
+ * Functions for working with priority queues of node indices.
+ *
+ * Heaps store the key next to the node index, so comparisons never need to
+ * look into other arrays. Every public function dispatches on the kind of
+ * the queue; implementations are static and get inlined into the dispatcher.
+ *
+ * @file    pq.c
+ */
+#include "pq.h"
+#include "stats.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Marks missing node in links of a pairing heap */
+#define NONE UINT32_MAX
+/** Number of buckets of a radix heap, one for each possible bit length of
+ * difference between a key and the last removed key */
+#define RADIX_BUCKETS 33
+
+/** Entry of a heap. */
+struct entry {
+    uint32_t key;
+    uint32_t node;
+};
+
+/** Bucket of a radix heap. */
+struct bucket {
+    struct entry *data;
+    uint32_t len;
+    uint32_t size;
+};
+
+struct pq {
+    /** Implementation of this queue */
+    enum pq_kind kind;
+    /** Number of entries */
+    uint32_t len;
+
+    /* d-ary heaps */
+    /** Array representation of the heap */
+    struct entry *heap;
+    /** Position of each node in the heap */
+    uint32_t *pos;
+
+    /* radix heap */
+    struct bucket buckets[RADIX_BUCKETS];
+    /** Last removed key, also used by bucket queue */
+    uint32_t last;
+
+    /* bucket queue */
+    /** Circular array of buckets, bucket `k % width` holds key `k` */
+    struct bucket *ring;
+    /** Number of buckets */
+    uint32_t width;
+    /** Number of entries in the buckets */
+    uint32_t ring_len;
+    /** Binary heap of entries with keys too far ahead */
+    struct bucket overflow;
+
+    /* pairing heap */
+    /** Node with minimal key or `NONE` */
+    uint32_t root;
+    /** Key of each node */
+    uint32_t *keys;
+    /** Leftmost child of each node */
+    uint32_t *child;
+    /** Right sibling of each node */
+    uint32_t *next;
+    /** Left sibling of each node or its parent if it is the leftmost child */
+    uint32_t *prev;
+    /** Temporary storage for merging children of removed root */
+    uint32_t *stack;
+
+#ifdef GRAPH_STATS
+    /** Operations not yet added to the totals */
+    uint64_t counts[STATS_COUNTERS];
+#endif
+};
+
+static const char *PQ_NAMES[PQ_KINDS] = {
+    [PQ_BINARY] = "binary",
+    [PQ_QUATERNARY] = "4ary",
+    [PQ_RADIX] = "radix",
+    [PQ_PAIRING] = "pairing",
+    [PQ_DIAL] = "dial",
+};
+
+/** Name of `PQ_AUTO` */
+static const char *PQ_AUTO_NAME = "auto";
+
+/*
+ * d-ary heaps
+ */
+
+/**
+ * Move entry at position pos toward root of the heap until it is no longer
+ * lesser than its parent.
+ *
+ * @param q     queue
+ * @param pos   position of entry to fix
+ * @param d     arity of the heap
+ */
+static inline void dary_up(Pq *q, uint32_t pos, unsigned d)
+{
+    struct entry e = q->heap[pos];
+    while (pos > 0) {
+        uint32_t parent = (pos - 1) / d;
+        if (q->heap[parent].key <= e.key) break;
+        q->heap[pos] = q->heap[parent];
+        q->pos[q->heap[pos].node] = pos;
+        pos = parent;
+    }
+    q->heap[pos] = e;
+    q->pos[e.node] = pos;
+}
+
+/**
+ * Move entry at position pos toward leaves of the heap until all its children
+ * are greater.
+ *
+ * @param q     queue
+ * @param pos   position of entry to fix
+ * @param d     arity of the heap
+ */
+static inline void dary_down(Pq *q, uint32_t pos, unsigned d)
+{
+    struct entry e = q->heap[pos];
+    for (;;) {
+        uint64_t first = (uint64_t) pos * d + 1;
+        if (first >= q->len) break;
+        uint32_t last = first + d < q->len ? first + d : q->len;
+        uint32_t best = first;
+        for (uint32_t c = first + 1; c < last; c++) {
+            if (q->heap[c].key < q->heap[best].key) best = c;
+        }
+        if (e.key <= q->heap[best].key) break;
+        q->heap[pos] = q->heap[best];
+        q->pos[q->heap[pos].node] = pos;
+        pos = best;
+    }
+    q->heap[pos] = e;
+    q->pos[e.node] = pos;
+}
+
+static inline void dary_push(Pq *q, uint32_t node, uint32_t key, unsigned d)
+{
+    q->heap[q->len].key = key;
+    q->heap[q->len].node = node;
+    dary_up(q, q->len++, d);
+}
+
+static inline void dary_decrease(Pq *q, uint32_t node, uint32_t key,
+        unsigned d)
+{
+    uint32_t pos = q->pos[node];
+    assert(q->heap[pos].node == node && key < q->heap[pos].key);
+    q->heap[pos].key = key;
+    dary_up(q, pos, d);
+}
+
+static inline void dary_pop(Pq *q, uint32_t *node, uint32_t *key, unsigned d)
+{
+    *node = q->heap[0].node;
+    *key = q->heap[0].key;
+    if (--q->len > 0) {
+        q->heap[0] = q->heap[q->len];
+        dary_down(q, 0, d);
+    }
+}
+
+/*
+ * radix heap
+ */
+
+/**
+ * Find bucket for a key.
+ * Bucket zero holds keys equal to the last removed key, bucket `i` holds keys
+ * whose highest bit differing from the last removed key is bit `i - 1`.
+ *
+ * @param q     queue
+ * @param key   key to be stored
+ * @return      index of the bucket
+ */
+static inline unsigned radix_bucket(const Pq *q, uint32_t key)
+{
+    uint32_t diff = key ^ q->last;
+    if (diff == 0) return 0;
+#ifdef __GNUC__
+    return 32 - __builtin_clz(diff);
+#else
+    unsigned bits = 0;
+    while (diff) {
+        diff >>= 1;
+        bits++;
+    }
+    return bits;
+#endif
+}
+
+/**
+ * Make sure a bucket has room for more entries.
+ *
+ * @param b     bucket to grow
+ * @param extra number of entries to be added
+ * @return      true if successful, false if memory ran out
+ */
+static bool bucket_reserve(struct bucket *b, uint32_t extra)
+{
+    if (b->size - b->len >= extra) return true;
+    uint32_t size = b->size ? b->size : 64;
+    while (size - b->len < extra) size *= 2;
+    struct entry *tmp = realloc(b->data, size * sizeof *tmp);
+    if (!tmp) return false;
+    b->data = tmp;
+    b->size = size;
+    return true;
+}
+
+static bool radix_push(Pq *q, uint32_t node, uint32_t key)
+{
+    assert(key >= q->last);
+    struct bucket *b = &q->buckets[radix_bucket(q, key)];
+    if (!bucket_reserve(b, 1)) return false;
+    b->data[b->len].key = key;
+    b->data[b->len].node = node;
+    b->len++;
+    q->len++;
+    return true;
+}
+
+static bool radix_pop(Pq *q, uint32_t *node, uint32_t *key)
+{
+    if (q->buckets[0].len == 0) {
+        /* Refill bucket zero from the first nonempty bucket. Its entries all
+         * move to lower buckets once the last key becomes their minimum. */
+        unsigned i = 1;
+        while (q->buckets[i].len == 0) i++;
+        struct bucket *b = &q->buckets[i];
+        uint32_t min = b->data[0].key;
+        for (uint32_t j = 1; j < b->len; j++) {
+            if (b->data[j].key < min) min = b->data[j].key;
+        }
+        uint32_t last = q->last;
+        uint32_t counts[RADIX_BUCKETS] = { 0 };
+        q->last = min;
+        for (uint32_t j = 0; j < b->len; j++) {
+            counts[radix_bucket(q, b->data[j].key)]++;
+        }
+        for (unsigned t = 0; t < i; t++) {
+            if (!bucket_reserve(&q->buckets[t], counts[t])) {
+                q->last = last;
+                return false;
+            }
+        }
+        for (uint32_t j = 0; j < b->len; j++) {
+            struct bucket *t = &q->buckets[radix_bucket(q, b->data[j].key)];
+            t->data[t->len++] = b->data[j];
+        }
+        b->len = 0;
+    }
+    struct bucket *b = &q->buckets[0];
+    b->len--;
+    q->len--;
+    *node = b->data[b->len].node;
+    *key = b->data[b->len].key;
+    return true;
+}
+
+/*
+ * pairing heap
+ */
+
+/**
+ * Link two trees, the one with greater key becomes leftmost child of the
+ * other one.
+ *
+ * @param q     queue
+ * @param a     root of first tree or `NONE`
+ * @param b     root of second tree or `NONE`
+ * @return      root of resulting tree
+ */
+static inline uint32_t pairing_link(Pq *q, uint32_t a, uint32_t b)
+{
+    if (a == NONE) return b;
+    if (b == NONE) return a;
+    if (q->keys[b] < q->keys[a]) {
+        uint32_t tmp = a;
+        a = b;
+        b = tmp;
+    }
+    q->next[b] = q->child[a];
+    if (q->child[a] != NONE) q->prev[q->child[a]] = b;
+    q->prev[b] = a;
+    q->child[a] = b;
+    q->next[a] = NONE;
+    q->prev[a] = NONE;
+    return a;
+}
+
+static void pairing_push(Pq *q, uint32_t node, uint32_t key)
+{
+    q->keys[node] = key;
+    q->child[node] = NONE;
+    q->next[node] = NONE;
+    q->prev[node] = NONE;
+    q->root = pairing_link(q, q->root, node);
+    q->len++;
+}
+
+static void pairing_decrease(Pq *q, uint32_t node, uint32_t key)
+{
+    assert(key < q->keys[node]);
+    q->keys[node] = key;
+    if (node == q->root) return;
+    /* Cut the subtree of the node and link it with the root. */
+    uint32_t p = q->prev[node];
+    if (q->child[p] == node) {
+        q->child[p] = q->next[node];
+    } else {
+        q->next[p] = q->next[node];
+    }
+    if (q->next[node] != NONE) q->prev[q->next[node]] = p;
+    q->next[node] = NONE;
+    q->prev[node] = NONE;
+    q->root = pairing_link(q, q->root, node);
+}
+
+static void pairing_pop(Pq *q, uint32_t *node, uint32_t *key)
+{
+    *node = q->root;
+    *key = q->keys[q->root];
+    q->len--;
+    /* Link children in pairs from left to right, then link the pairs from
+     * right to left. */
+    uint32_t top = 0;
+    uint32_t c = q->child[q->root];
+    while (c != NONE) {
+        uint32_t a = c;
+        uint32_t b = q->next[a];
+        c = b != NONE ? q->next[b] : NONE;
+        q->stack[top++] = pairing_link(q, a, b);
+    }
+    uint32_t root = NONE;
+    while (top > 0) {
+        root = pairing_link(q, q->stack[--top], root);
+    }
+    q->root = root;
+}
+
+/*
+ * bucket queue
+ */
+
+/**
+ * Insert an entry into the overflow heap of a bucket queue.
+ *
+ * @param o     overflow heap
+ * @param e     entry to be inserted
+ * @return      true if successful, false if memory ran out
+ */
+static bool overflow_push(struct bucket *o, struct entry e)
+{
+    if (!bucket_reserve(o, 1)) return false;
+    uint32_t pos = o->len++;
+    while (pos > 0 && o->data[(pos - 1) / 2].key > e.key) {
+        o->data[pos] = o->data[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    o->data[pos] = e;
+    return true;
+}
+
+/**
+ * Remove entry with minimal key from nonempty overflow heap.
+ *
+ * @param o     overflow heap
+ * @return      removed entry
+ */
+static struct entry overflow_pop(struct bucket *o)
+{
+    struct entry min = o->data[0];
+    struct entry e = o->data[--o->len];
+    uint32_t pos = 0;
+    uint32_t child;
+    while ((child = 2 * pos + 1) < o->len) {
+        if (child + 1 < o->len && o->data[child + 1].key < o->data[child].key) {
+            child++;
+        }
+        if (e.key <= o->data[child].key) break;
+        o->data[pos] = o->data[child];
+        pos = child;
+    }
+    if (o->len > 0) o->data[pos] = e;
+    return min;
+}
+
+static bool dial_push(Pq *q, uint32_t node, uint32_t key)
+{
+    assert(key >= q->last);
+    struct entry e = { key, node };
+    if (key - q->last >= q->width) {
+        if (!overflow_push(&q->overflow, e)) return false;
+    } else {
+        struct bucket *b = &q->ring[key % q->width];
+        if (!bucket_reserve(b, 1)) return false;
+        b->data[b->len++] = e;
+        q->ring_len++;
+    }
+    q->len++;
+    return true;
+}
+
+static void dial_pop(Pq *q, uint32_t *node, uint32_t *key)
+{
+    /* All entries in the buckets have keys from last to last + width - 1,
+     * each bucket holds entries with equal keys. */
+    struct bucket *o = &q->overflow;
+    if (q->ring_len > 0) {
+        uint32_t k = q->last;
+        struct bucket *b;
+        while ((b = &q->ring[k % q->width])->len == 0) k++;
+        if (o->len == 0 || k < o->data[0].key) {
+            b->len--;
+            q->ring_len--;
+            q->len--;
+            q->last = k;
+            *node = b->data[b->len].node;
+            *key = k;
+            return;
+        }
+    }
+    struct entry e = overflow_pop(o);
+    q->len--;
+    q->last = e.key;
+    *node = e.node;
+    *key = e.key;
+}
+
+/*
+ * dispatch
+ */
+
+Pq * pq_new(enum pq_kind kind, uint32_t capacity, uint32_t width)
+{
+    if (kind >= PQ_KINDS) return NULL;
+    Pq *q = calloc(1, sizeof *q);
+    if (!q) return NULL;
+    q->kind = kind;
+    q->root = NONE;
+    size_t n = (size_t) capacity + 1;
+    bool ok = true;
+    switch (kind) {
+    case PQ_BINARY:
+    case PQ_QUATERNARY:
+        q->heap = malloc(n * sizeof *q->heap);
+        q->pos = malloc(n * sizeof *q->pos);
+        ok = q->heap && q->pos;
+        break;
+    case PQ_RADIX:
+        break;
+    case PQ_DIAL:
+        q->width = width ? width : 1;
+        q->ring = calloc(q->width, sizeof *q->ring);
+        ok = q->ring != NULL;
+        break;
+    case PQ_PAIRING:
+        q->keys = malloc(n * sizeof *q->keys);
+        q->child = malloc(n * sizeof *q->child);
+        q->next = malloc(n * sizeof *q->next);
+        q->prev = malloc(n * sizeof *q->prev);
+        q->stack = malloc(n * sizeof *q->stack);
+        ok = q->keys && q->child && q->next && q->prev && q->stack;
+        break;
+    default:
+        break;
+    }
+    if (!ok) {
+        pq_free(q);
+        return NULL;
+    }
+    return q;
+}
+
+bool pq_is_empty(const Pq *q)
+{
+    return q ? q->len == 0 : true;
+}
+
+enum pq_kind pq_get_kind(const Pq *q)
+{
+    assert(q);
+    return q->kind;
+}
+
+void pq_clear(Pq *q)
+{
+    if (!q) return;
+    q->len = 0;
+    q->last = 0;
+    q->root = NONE;
+    for (unsigned i = 0; i < RADIX_BUCKETS; i++) {
+        q->buckets[i].len = 0;
+    }
+    for (uint32_t i = 0; q->ring_len > 0 && i < q->width; i++) {
+        q->ring_len -= q->ring[i].len;
+        q->ring[i].len = 0;
+    }
+    q->overflow.len = 0;
+}
+
+bool pq_push(Pq *q, uint32_t node, uint32_t key)
+{
+    STATS_ADD(q->counts, STATS_PUSHES, 1);
+    switch (q->kind) {
+    case PQ_BINARY:
+        dary_push(q, node, key, 2);
+        return true;
+    case PQ_QUATERNARY:
+        dary_push(q, node, key, 4);
+        return true;
+    case PQ_RADIX:
+        return radix_push(q, node, key);
+    case PQ_PAIRING:
+        pairing_push(q, node, key);
+        return true;
+    case PQ_DIAL:
+        return dial_push(q, node, key);
+    default:
+        return false;
+    }
+}
+
+bool pq_decrease(Pq *q, uint32_t node, uint32_t key)
+{
+    STATS_ADD(q->counts, STATS_DECREASES, 1);
+    switch (q->kind) {
+    case PQ_BINARY:
+        dary_decrease(q, node, key, 2);
+        return true;
+    case PQ_QUATERNARY:
+        dary_decrease(q, node, key, 4);
+        return true;
+    case PQ_RADIX:
+        return radix_push(q, node, key);
+    case PQ_PAIRING:
+        pairing_decrease(q, node, key);
+        return true;
+    case PQ_DIAL:
+        return dial_push(q, node, key);
+    default:
+        return false;
+    }
+}
+
+bool pq_pop(Pq *q, uint32_t *node, uint32_t *key)
+{
+    if (q->len == 0) return false;
+    STATS_ADD(q->counts, STATS_POPS, 1);
+    switch (q->kind) {
+    case PQ_BINARY:
+        dary_pop(q, node, key, 2);
+        break;
+    case PQ_QUATERNARY:
+        dary_pop(q, node, key, 4);
+        break;
+    case PQ_RADIX:
+        return radix_pop(q, node, key);
+    case PQ_PAIRING:
+        pairing_pop(q, node, key);
+        break;
+    case PQ_DIAL:
+        dial_pop(q, node, key);
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+const char * pq_name(enum pq_kind kind)
+{
+    if (kind == PQ_AUTO) return PQ_AUTO_NAME;
+    return kind < PQ_KINDS ? PQ_NAMES[kind] : NULL;
+}
+
+bool pq_parse(const char *name, enum pq_kind *kind)
+{
+    if (name && strcmp(name, PQ_AUTO_NAME) == 0) {
+        *kind = PQ_AUTO;
+        return true;
+    }
+    for (int i = 0; i < PQ_KINDS; i++) {
+        if (name && strcmp(name, PQ_NAMES[i]) == 0) {
+            *kind = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void pq_free(Pq *q)
+{
+    if (q) {
+        STATS_FLUSH(q->counts);
+        free(q->heap);
+        free(q->pos);
+        for (unsigned i = 0; i < RADIX_BUCKETS; i++) {
+            free(q->buckets[i].data);
+        }
+        free(q->keys);
+        free(q->child);
+        free(q->next);
+        free(q->prev);
+        free(q->stack);
+        for (uint32_t i = 0; q->ring && i < q->width; i++) {
+            free(q->ring[i].data);
+        }
+        free(q->ring);
+        free(q->overflow.data);
+    }
+    free(q);
+}
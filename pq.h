@@ -0,0 +1,149 @@
+/**
+ * Interface for priority queues of node indices.
+ *
+ * A queue holds pairs of a node index and its key and is used by searches to
+ * pick the closest unfinished node. Several implementations are available and
+ * can be selected at runtime; all of them have the same interface.
+ *
+ * Some implementations handle pq_decrease() by inserting another entry and
+ * leave the old one in the queue. pq_pop() can then return an entry whose key
+ * is higher than the current key of the node. Callers are expected to skip
+ * such stale entries.
+ *
+ * @file    pq.h
+ */
+#ifndef PQ_H
+#define PQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Available implementations of a priority queue. */
+enum pq_kind {
+    /** Binary heap */
+    PQ_BINARY,
+    /** 4-ary heap */
+    PQ_QUATERNARY,
+    /** Monotone radix heap. Keys of inserted entries must not be lower than
+     * the key of the last removed entry. Decreasing a key leaves a stale
+     * entry. */
+    PQ_RADIX,
+    /** Pairing heap */
+    PQ_PAIRING,
+    /** Circular array of buckets, one for each key (Dial's algorithm). Keys
+     * of inserted entries must not be lower than the key of the last removed
+     * entry. Keys too far ahead are kept in a separate binary heap. Decreasing
+     * a key leaves a stale entry. */
+    PQ_DIAL,
+    /** Number of implementations */
+    PQ_KINDS,
+    /** Not an implementation, asks search_new() to pick one suitable for
+     * weights of the searched graph */
+    PQ_AUTO = PQ_KINDS
+};
+
+/**
+ * Queue is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct pq Pq;
+
+/**
+ * Create a new empty queue.
+ *
+ * Parameter `width` is only used by `PQ_DIAL` and gives the number of buckets.
+ * Entries with key at least `width` higher than the last removed key are
+ * stored outside of the buckets, which is slower. A good choice is one more
+ * than the typical weight of an edge.
+ *
+ * @param kind      implementation to be used, not `PQ_AUTO`
+ * @param capacity  number of nodes, all node indices must be lower
+ * @param width     number of buckets, at least one
+ * @return          new queue or NULL if memory is exhausted
+ */
+Pq * pq_new(enum pq_kind kind, uint32_t capacity, uint32_t width);
+
+/**
+ * Get implementation of a queue.
+ *
+ * @param q     queue to query
+ * @return      kind of the queue
+ */
+enum pq_kind pq_get_kind(const Pq *q);
+
+/**
+ * Remove all entries from a queue.
+ * This takes constant time.
+ *
+ * @param q     queue to be cleared
+ */
+void pq_clear(Pq *q);
+
+/**
+ * Insert a node that is not in the queue.
+ * This function fails only if memory runs out.
+ *
+ * @param q     queue to insert into
+ * @param node  index of the node
+ * @param key   key of the node
+ * @return      true if successful, false otherwise
+ */
+bool pq_push(Pq *q, uint32_t node, uint32_t key);
+
+/**
+ * Lower key of a node that is in the queue.
+ * The new key must be less than the original one. This function fails only
+ * if memory runs out.
+ *
+ * @param q     queue to be modified
+ * @param node  index of the node
+ * @param key   new key of the node
+ * @return      true if successful, false otherwise
+ */
+bool pq_decrease(Pq *q, uint32_t node, uint32_t key);
+
+/**
+ * Test if a queue is empty.
+ *
+ * @param q     queue to be tested
+ * @return      true if the queue is empty, false otherwise
+ */
+bool pq_is_empty(const Pq *q);
+
+/**
+ * Remove entry with minimal key from the queue.
+ * Removing may need to reorganize the queue, which fails if memory runs out.
+ * Use pq_is_empty() to tell this from an empty queue.
+ *
+ * @param q         queue to remove from
+ * @param[out] node index of removed node
+ * @param[out] key  key of removed entry
+ * @return          false if the queue was empty or memory ran out
+ */
+bool pq_pop(Pq *q, uint32_t *node, uint32_t *key);
+
+/**
+ * Get name of an implementation.
+ *
+ * @param kind  implementation or `PQ_AUTO`
+ * @return      name usable on command line
+ */
+const char * pq_name(enum pq_kind kind);
+
+/**
+ * Find implementation by name.
+ *
+ * @param name      name as returned by pq_name()
+ * @param[out] kind where to store the implementation
+ * @return          true if the name is known
+ */
+bool pq_parse(const char *name, enum pq_kind *kind);
+
+/**
+ * Free a queue.
+ *
+ * @param q     queue to be freed
+ */
+void pq_free(Pq *q);
+
+#endif /* end of include guard: PQ_H */
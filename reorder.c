@@ -0,0 +1,241 @@
+/**
+ * Functions for renumbering nodes of frozen graphs.
+ *
+ * @file    reorder.c
+ */
+#include "reorder.h"
+#include "binfile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Names of orders indexed by enum reorder_kind */
+static const char *REORDER_NAMES[REORDER_KINDS] = {
+    "none", "bfs", "rcm", "degree"
+};
+
+bool reorder_parse(const char *name, enum reorder_kind *kind)
+{
+    for (int i = 0; i < REORDER_KINDS; i++) {
+        if (name && strcmp(name, REORDER_NAMES[i]) == 0) {
+            *kind = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char * reorder_name(enum reorder_kind kind)
+{
+    return kind < REORDER_KINDS ? REORDER_NAMES[kind] : NULL;
+}
+
+/**
+ * Count outgoing and incoming edges of a node.
+ *
+ * @param csr   frozen graph with reverse edges
+ * @param node  index of the node
+ * @return      number of edges
+ */
+static uint32_t degree(const Csr *csr, uint32_t node)
+{
+    return csr->offsets[node + 1] - csr->offsets[node]
+        + csr->rev_offsets[node + 1] - csr->rev_offsets[node];
+}
+
+/**
+ * Sort nodes by number of their edges.
+ * Counting sort keeps nodes with the same degree in order of their indices.
+ *
+ * @param csr           frozen graph with reverse edges
+ * @param descending    put nodes with the most edges first
+ * @return              sorted indices of nodes or NULL if memory ran out
+ */
+static uint32_t * sort_by_degree(const Csr *csr, bool descending)
+{
+    uint32_t n = csr->nodes_num;
+    uint32_t max = 0;
+    for (uint32_t v = 0; v < n; v++) {
+        uint32_t d = degree(csr, v);
+        if (d > max) max = d;
+    }
+    uint32_t *first = calloc((size_t) max + 2, sizeof *first);
+    uint32_t *sorted = malloc(((size_t) n + 1) * sizeof *sorted);
+    if (!first || !sorted) {
+        free(first);
+        free(sorted);
+        return NULL;
+    }
+    for (uint32_t v = 0; v < n; v++) {
+        uint32_t d = degree(csr, v);
+        first[(descending ? max - d : d) + 1]++;
+    }
+    for (uint32_t d = 0; d <= max; d++) {
+        first[d + 1] += first[d];
+    }
+    for (uint32_t v = 0; v < n; v++) {
+        uint32_t d = degree(csr, v);
+        sorted[first[descending ? max - d : d]++] = v;
+    }
+    free(first);
+    return sorted;
+}
+
+/**
+ * Compare neighbours by degree, packed as degree in the upper half.
+ *
+ * @param a     first packed neighbour
+ * @param b     second packed neighbour
+ * @return      negative, zero or positive number as for qsort()
+ */
+static int packed_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Number nodes by breadth first search started from each unvisited node in
+ * turn.
+ *
+ * @param csr       frozen graph, with reverse edges if `undirected`
+ * @param roots     nodes in order in which searches start
+ * @param undirected follow edges in both directions, neighbours from the
+ *                  lowest degree
+ * @param order     where to store visited nodes
+ * @return          true if successful, false if memory ran out
+ */
+static bool breadth_first(const Csr *csr, const uint32_t *roots,
+        bool undirected, uint32_t *order)
+{
+    uint32_t n = csr->nodes_num;
+    bool *visited = calloc((size_t) n + 1, sizeof *visited);
+    /* Unvisited neighbours of a node with their degrees, sorted before
+     * they are queued. */
+    size_t size = 16;
+    uint64_t *next = malloc(size * sizeof *next);
+    bool ok = visited && next;
+    uint32_t tail = 0;
+    for (uint32_t r = 0; ok && r < n; r++) {
+        uint32_t root = roots ? roots[r] : r;
+        if (visited[root]) continue;
+        visited[root] = true;
+        uint32_t head = tail;
+        order[tail++] = root;
+        while (ok && head < tail) {
+            uint32_t v = order[head++];
+            size_t found = 0;
+            for (int dir = 0; dir < (undirected ? 2 : 1); dir++) {
+                const uint32_t *offsets = dir ? csr->rev_offsets
+                    : csr->offsets;
+                const uint32_t *ends = dir ? csr->rev_sources : csr->targets;
+                for (uint32_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                    uint32_t w = ends[e];
+                    if (visited[w]) continue;
+                    visited[w] = true;
+                    if (!undirected) {
+                        order[tail++] = w;
+                        continue;
+                    }
+                    if (found == size) {
+                        uint64_t *tmp = realloc(next, 2 * size * sizeof *tmp);
+                        if (!tmp) {
+                            ok = false;
+                            break;
+                        }
+                        next = tmp;
+                        size *= 2;
+                    }
+                    next[found++] = (uint64_t) degree(csr, w) << 32 | w;
+                }
+            }
+            qsort(next, found, sizeof *next, packed_compare);
+            for (size_t i = 0; i < found; i++) {
+                order[tail++] = (uint32_t) next[i];
+            }
+        }
+    }
+    free(visited);
+    free(next);
+    return ok;
+}
+
+uint32_t * reorder_compute(Csr *csr, enum reorder_kind kind)
+{
+    if (!csr || kind >= REORDER_KINDS) return NULL;
+    uint32_t n = csr->nodes_num;
+    if (kind == REORDER_NONE) {
+        uint32_t *order = malloc(((size_t) n + 1) * sizeof *order);
+        for (uint32_t v = 0; order && v < n; v++) {
+            order[v] = v;
+        }
+        return order;
+    }
+    if (kind == REORDER_BFS) {
+        uint32_t *order = malloc(((size_t) n + 1) * sizeof *order);
+        if (order && !breadth_first(csr, NULL, false, order)) {
+            free(order);
+            return NULL;
+        }
+        return order;
+    }
+    if (!csr_build_reverse(csr)) return NULL;
+    if (kind == REORDER_DEGREE) {
+        return sort_by_degree(csr, true);
+    }
+
+    /* Searches start from nodes of the lowest degree, which tend to lie
+     * on the periphery. */
+    uint32_t *roots = sort_by_degree(csr, false);
+    uint32_t *order = malloc(((size_t) n + 1) * sizeof *order);
+    bool ok = roots && order && breadth_first(csr, roots, true, order);
+    free(roots);
+    if (!ok) {
+        free(order);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n / 2; i++) {
+        uint32_t tmp = order[i];
+        order[i] = order[n - 1 - i];
+        order[n - 1 - i] = tmp;
+    }
+    return order;
+}
+
+Csr * reorder_apply(const Csr *csr, const uint32_t *order)
+{
+    if (!csr || !order) return NULL;
+    uint32_t n = csr->nodes_num;
+    uint32_t *rank = malloc(((size_t) n + 1) * sizeof *rank);
+    Csr *r = rank ? csr_new(n, csr->edges_num) : NULL;
+    if (!r) {
+        free(rank);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        rank[order[i]] = i;
+    }
+    uint32_t e = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = order[i];
+        r->ids[i] = csr->ids[v];
+        r->offsets[i] = e;
+        for (uint32_t f = csr->offsets[v]; f < csr->offsets[v + 1]; f++) {
+            r->targets[e] = rank[csr->targets[f]];
+            r->weights[e++] = csr->weights[f];
+        }
+    }
+    r->offsets[n] = e;
+    free(rank);
+    r->min_weight = csr->min_weight;
+    r->max_weight = csr->max_weight;
+    r->typical_weight = csr->typical_weight;
+    r->reordered = true;
+    r->checksum = binfile_graph_checksum(r);
+    if (!csr_build_idmap(r)) {
+        csr_free(r);
+        return NULL;
+    }
+    return r;
+}
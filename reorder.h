@@ -0,0 +1,76 @@
+/**
+ * Interface for renumbering nodes of frozen graphs.
+ *
+ * Nodes of a frozen graph are numbered by their identifiers, which usually
+ * says nothing about which nodes are connected. Searches then read
+ * neighbours from all over the arrays. Renumbering nodes so that neighbours
+ * get close numbers keeps more of them in the same cache lines.
+ *
+ * Identifiers of nodes do not change, only their order. A renumbered graph
+ * always has the map of identifiers, because they are no longer sorted.
+ *
+ * @file    reorder.h
+ */
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+
+/** Orders of nodes. */
+enum reorder_kind {
+    /** Nodes stay sorted by identifier. */
+    REORDER_NONE,
+    /** Nodes are numbered in order of breadth first search along edges. */
+    REORDER_BFS,
+    /** Reverse Cuthill-McKee: breadth first search ignoring directions of
+     * edges, starting at a node of minimum degree and visiting neighbours
+     * from the lowest degree, reversed at the end. */
+    REORDER_RCM,
+    /** Nodes with the most edges come first, so hubs share cache lines. */
+    REORDER_DEGREE,
+    /** Number of orders */
+    REORDER_KINDS
+};
+
+/**
+ * Parse name of an order.
+ *
+ * @param name          `none`, `bfs`, `rcm` or `degree`
+ * @param kind[out]     parsed value
+ * @return              true if the name is valid
+ */
+bool reorder_parse(const char *name, enum reorder_kind *kind);
+
+/**
+ * Get name of an order.
+ *
+ * @param kind  order
+ * @return      name accepted by reorder_parse()
+ */
+const char * reorder_name(enum reorder_kind kind);
+
+/**
+ * Compute new order of nodes.
+ * Reverse edges of the graph are built if the order needs them.
+ *
+ * @param csr   frozen graph
+ * @param kind  order to compute
+ * @return      array with the old index of each new node, NULL if memory
+ *              ran out
+ */
+uint32_t * reorder_compute(Csr *csr, enum reorder_kind kind);
+
+/**
+ * Create a copy of a graph with renumbered nodes.
+ * Outgoing edges of each node keep their order.
+ *
+ * @param csr   frozen graph
+ * @param order old index of each new node, a permutation
+ * @return      new frozen graph or NULL if memory ran out
+ */
+Csr * reorder_apply(const Csr *csr, const uint32_t *order);
+
+#endif /* end of include guard: REORDER_H */
@@ -0,0 +1,339 @@
+/**
+ * Functions for strongly connected components and reachability between them.
+ *
+ * Components are found by Tarjan's algorithm with an explicit stack, so deep
+ * graphs do not overflow the call stack. It finishes a component only after
+ * all components reachable from it, which numbers them in reverse
+ * topological order.
+ *
+ * @file    scc.c
+ */
+#include "scc.h"
+
+#include <stdlib.h>
+
+/** Number of interval labels of each component of a large condensation */
+#define LABELINGS 2
+
+struct components {
+    /** Number of nodes of the graph */
+    uint32_t nodes_num;
+    /** Number of components */
+    uint32_t count;
+    /** Component of each node */
+    uint32_t *component;
+    /** Number of 64-bit words per row of `closure` */
+    size_t words;
+    /** Bit `d` of row `c` is set if component `c` reaches component `d`,
+     * NULL for condensations larger than `SCC_CLOSURE_LIMIT` */
+    uint64_t *closure;
+    /** Lowest finishing time in the subtree of each component for each
+     * labeling, NULL if `closure` is used */
+    uint32_t *low[LABELINGS];
+    /** Finishing time of each component for each labeling */
+    uint32_t *post[LABELINGS];
+};
+
+/** Acyclic graph of components. */
+struct dag {
+    /** Number of components */
+    uint32_t count;
+    /** Index of the first edge of each component, `count + 1` elements */
+    uint32_t *offsets;
+    /** Component at the end of each edge */
+    uint32_t *targets;
+};
+
+/**
+ * Find components by Tarjan's algorithm.
+ *
+ * @param csr       frozen graph
+ * @param component where to store component of each node
+ * @param count     where to store number of components
+ * @return          true if successful, false if memory ran out
+ */
+static bool tarjan(const Csr *csr, uint32_t *component, uint32_t *count)
+{
+    uint32_t n = csr->nodes_num;
+    uint32_t *index = malloc(((size_t) n + 1) * sizeof *index);
+    uint32_t *low = malloc(((size_t) n + 1) * sizeof *low);
+    uint32_t *stack = malloc(((size_t) n + 1) * sizeof *stack);
+    /* Nodes being visited and their next edges, one per level of recursion */
+    uint32_t *calls = malloc(((size_t) n + 1) * sizeof *calls);
+    uint32_t *edges = malloc(((size_t) n + 1) * sizeof *edges);
+    bool ok = index && low && stack && calls && edges;
+    uint32_t visited = 0;
+    uint32_t top = 0;
+    *count = 0;
+    for (uint32_t v = 0; ok && v < n; v++) {
+        index[v] = CSR_NONE;
+        component[v] = CSR_NONE;
+    }
+    for (uint32_t root = 0; ok && root < n; root++) {
+        if (index[root] != CSR_NONE) continue;
+        uint32_t depth = 0;
+        index[root] = low[root] = visited++;
+        stack[top++] = root;
+        calls[depth] = root;
+        edges[depth++] = csr->offsets[root];
+        while (depth > 0) {
+            uint32_t v = calls[depth - 1];
+            uint32_t e = edges[depth - 1];
+            if (e < csr->offsets[v + 1]) {
+                edges[depth - 1]++;
+                uint32_t w = csr->targets[e];
+                if (index[w] == CSR_NONE) {
+                    index[w] = low[w] = visited++;
+                    stack[top++] = w;
+                    calls[depth] = w;
+                    edges[depth++] = csr->offsets[w];
+                } else if (component[w] == CSR_NONE && index[w] < low[v]) {
+                    low[v] = index[w];      /* w is still on the stack */
+                }
+                continue;
+            }
+            depth--;
+            if (low[v] == index[v]) {
+                uint32_t w;
+                do {
+                    w = stack[--top];
+                    component[w] = *count;
+                } while (w != v);
+                (*count)++;
+            }
+            if (depth > 0 && low[v] < low[calls[depth - 1]]) {
+                low[calls[depth - 1]] = low[v];
+            }
+        }
+    }
+    free(index);
+    free(low);
+    free(stack);
+    free(calls);
+    free(edges);
+    return ok;
+}
+
+/**
+ * Build graph of components without parallel edges and loops.
+ *
+ * @param csr       frozen graph
+ * @param c         components of the graph
+ * @param g         where to store the graph of components
+ * @return          true if successful, false if memory ran out
+ */
+static bool condense(const Csr *csr, const Components *c, struct dag *g)
+{
+    uint32_t k = c->count;
+    g->count = k;
+    g->offsets = calloc((size_t) k + 1, sizeof *g->offsets);
+    g->targets = NULL;
+    /* Nodes sorted by component, those of component `i` start at
+     * `first[i]`. */
+    uint32_t *first = calloc((size_t) k + 2, sizeof *first);
+    uint32_t *members = malloc(((size_t) c->nodes_num + 1) * sizeof *members);
+    uint32_t *seen = malloc(((size_t) k + 1) * sizeof *seen);
+    bool ok = g->offsets && first && members && seen;
+    for (uint32_t v = 0; ok && v < c->nodes_num; v++) {
+        first[c->component[v] + 2]++;
+    }
+    for (uint32_t i = 2; ok && i <= k; i++) {
+        first[i] += first[i - 1];
+    }
+    for (uint32_t v = 0; ok && v < c->nodes_num; v++) {
+        members[first[c->component[v] + 1]++] = v;
+    }
+
+    /* The first pass counts edges, the second one stores them. */
+    for (int pass = 0; ok && pass < 2; pass++) {
+        for (uint32_t i = 0; i < k; i++) {
+            seen[i] = CSR_NONE;
+        }
+        uint32_t edges = 0;
+        for (uint32_t i = 0; i < k; i++) {
+            for (uint32_t m = first[i]; m < first[i + 1]; m++) {
+                uint32_t v = members[m];
+                for (uint32_t e = csr->offsets[v]; e < csr->offsets[v + 1];
+                        e++) {
+                    uint32_t j = c->component[csr->targets[e]];
+                    if (j == i || seen[j] == i) continue;
+                    seen[j] = i;
+                    if (pass == 1) g->targets[edges] = j;
+                    edges++;
+                }
+            }
+            g->offsets[i + 1] = edges;
+        }
+        if (pass == 0) {
+            g->targets = malloc(((size_t) edges + 1) * sizeof *g->targets);
+            ok = g->targets != NULL;
+        }
+    }
+    free(first);
+    free(members);
+    free(seen);
+    return ok;
+}
+
+/**
+ * Compute transitive closure of the graph of components.
+ *
+ * @param c     components to be filled in
+ * @param g     graph of components
+ * @return      true if successful, false if memory ran out
+ */
+static bool close_transitively(Components *c, const struct dag *g)
+{
+    c->words = (g->count + 63) / 64;
+    c->closure = calloc((size_t) g->count * c->words + 1,
+            sizeof *c->closure);
+    if (!c->closure) return false;
+    /* Edges lead to lower numbers, whose rows are already complete. */
+    for (uint32_t i = 0; i < g->count; i++) {
+        uint64_t *row = c->closure + i * c->words;
+        row[i / 64] |= UINT64_C(1) << (i % 64);
+        for (uint32_t e = g->offsets[i]; e < g->offsets[i + 1]; e++) {
+            const uint64_t *next = c->closure + g->targets[e] * c->words;
+            for (size_t w = 0; w < c->words; w++) {
+                row[w] |= next[w];
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Assign interval labels by depth first traversal of the graph of
+ * components.
+ *
+ * @param g         graph of components
+ * @param low       where to store lowest finishing time in each subtree
+ * @param post      where to store finishing time of each component
+ * @param reverse   visit edges of each component from the last one
+ * @return          true if successful, false if memory ran out
+ */
+static bool label(const struct dag *g, uint32_t *low, uint32_t *post,
+        bool reverse)
+{
+    uint32_t *calls = malloc(((size_t) g->count + 1) * sizeof *calls);
+    uint32_t *edges = malloc(((size_t) g->count + 1) * sizeof *edges);
+    if (!calls || !edges) {
+        free(calls);
+        free(edges);
+        return false;
+    }
+    for (uint32_t i = 0; i < g->count; i++) {
+        post[i] = CSR_NONE;
+    }
+    uint32_t finished = 0;
+    /* Components without incoming edges have high numbers. */
+    for (uint32_t root = g->count; root-- > 0;) {
+        if (post[root] != CSR_NONE) continue;
+        uint32_t depth = 0;
+        low[root] = CSR_NONE;
+        calls[depth] = root;
+        edges[depth++] = 0;
+        while (depth > 0) {
+            uint32_t i = calls[depth - 1];
+            uint32_t degree = g->offsets[i + 1] - g->offsets[i];
+            if (edges[depth - 1] < degree) {
+                uint32_t e = edges[depth - 1]++;
+                uint32_t j = g->targets[reverse ? g->offsets[i + 1] - 1 - e
+                    : g->offsets[i] + e];
+                /* The graph is acyclic, so j is not being visited. */
+                if (post[j] == CSR_NONE) {
+                    low[j] = CSR_NONE;
+                    calls[depth] = j;
+                    edges[depth++] = 0;
+                } else if (low[j] < low[i]) {
+                    low[i] = low[j];
+                }
+                continue;
+            }
+            depth--;
+            post[i] = finished++;
+            if (post[i] < low[i]) low[i] = post[i];
+            if (depth > 0 && low[i] < low[calls[depth - 1]]) {
+                low[calls[depth - 1]] = low[i];
+            }
+        }
+    }
+    free(calls);
+    free(edges);
+    return true;
+}
+
+Components * scc_build(const Csr *csr)
+{
+    if (!csr) return NULL;
+    Components *c = calloc(1, sizeof *c);
+    if (!c) return NULL;
+    c->nodes_num = csr->nodes_num;
+    c->component = malloc(((size_t) csr->nodes_num + 1)
+            * sizeof *c->component);
+    struct dag g = { 0, NULL, NULL };
+    bool ok = c->component && tarjan(csr, c->component, &c->count)
+        && condense(csr, c, &g);
+    if (ok && c->count <= SCC_CLOSURE_LIMIT) {
+        ok = close_transitively(c, &g);
+    }
+    for (int l = 0; ok && !c->closure && l < LABELINGS; l++) {
+        c->low[l] = malloc(((size_t) c->count + 1) * sizeof *c->low[l]);
+        c->post[l] = malloc(((size_t) c->count + 1) * sizeof *c->post[l]);
+        ok = c->low[l] && c->post[l]
+            && label(&g, c->low[l], c->post[l], l % 2 == 1);
+    }
+    free(g.offsets);
+    free(g.targets);
+    if (!ok) {
+        scc_free(c);
+        return NULL;
+    }
+    return c;
+}
+
+uint32_t scc_count(const Components *c)
+{
+    return c ? c->count : 0;
+}
+
+uint32_t scc_component(const Components *c, uint32_t node)
+{
+    return c->component[node];
+}
+
+bool scc_is_exact(const Components *c)
+{
+    return c && c->closure;
+}
+
+bool scc_may_reach(const Components *c, uint32_t source,
+        uint32_t destination)
+{
+    uint32_t s = c->component[source];
+    uint32_t d = c->component[destination];
+    if (s == d) return true;
+    if (c->closure) {
+        return c->closure[s * c->words + d / 64] >> (d % 64) & 1;
+    }
+    if (d > s) return false;
+    for (int l = 0; l < LABELINGS; l++) {
+        if (c->low[l][d] < c->low[l][s] || c->post[l][d] > c->post[l][s]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void scc_free(Components *c)
+{
+    if (c) {
+        free(c->component);
+        free(c->closure);
+        for (int l = 0; l < LABELINGS; l++) {
+            free(c->low[l]);
+            free(c->post[l]);
+        }
+    }
+    free(c);
+}
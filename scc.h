@@ -0,0 +1,91 @@
+/**
+ * Interface for strongly connected components and reachability between them.
+ *
+ * Nodes that can reach each other form a strongly connected component.
+ * Components connected by edges of the graph form an acyclic graph
+ * (condensation), so whether one node can reach another depends only on
+ * reachability between their components in it.
+ *
+ * If the condensation is small, its transitive closure is stored as a bit
+ * matrix and answers are exact. Otherwise each component gets a topological
+ * position and interval labels from depth first traversals of the
+ * condensation (GRAIL); a node can only be reached if all labels of its
+ * component are nested in labels of the starting component. Such answer may
+ * be a false positive, but never a false negative.
+ *
+ * @file    scc.h
+ */
+#ifndef SCC_H
+#define SCC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+
+/** Condensations with at most this many components store transitive
+ * closure. */
+#define SCC_CLOSURE_LIMIT 4096
+
+/**
+ * Components are an opaque type.
+ * Do not access their members directly, use provided functions.
+ */
+typedef struct components Components;
+
+/**
+ * Find strongly connected components of a graph and build reachability
+ * index over them.
+ *
+ * @param csr   frozen graph
+ * @return      new components or NULL if memory ran out
+ */
+Components * scc_build(const Csr *csr);
+
+/**
+ * Get number of components.
+ *
+ * @param c     components to query
+ * @return      number of components
+ */
+uint32_t scc_count(const Components *c);
+
+/**
+ * Get component of a node.
+ * Components are numbered in reverse topological order, so an edge never
+ * leads to a component with a higher number.
+ *
+ * @param c     components to query
+ * @param node  index of the node
+ * @return      index of its component
+ */
+uint32_t scc_component(const Components *c, uint32_t node);
+
+/**
+ * Check whether answers of scc_may_reach() are exact.
+ *
+ * @param c     components to query
+ * @return      true if transitive closure of the condensation is stored
+ */
+bool scc_is_exact(const Components *c);
+
+/**
+ * Check whether a path between two nodes may exist.
+ * False is always correct, true may be wrong unless scc_is_exact().
+ *
+ * @param c             components to query
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              false if no path exists, true otherwise
+ */
+bool scc_may_reach(const Components *c, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Free components.
+ *
+ * @param c     components to be freed
+ */
+void scc_free(Components *c);
+
+#endif /* end of include guard: SCC_H */
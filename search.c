@@ -0,0 +1,746 @@
+/**
+ * Functions for searching shortest paths in frozen graphs.
+ *
+ * Nodes that were reached but not finished yet are kept in a priority queue
+ * (see pq.h). Only nodes that were already reached are inserted into it.
+ *
+ * State of a node is valid only if its stamp equals the epoch of the context.
+ * Every search starts a new epoch, which invalidates all nodes at once, so
+ * preparing a search costs nothing regardless of size of the graph and the
+ * whole search costs time proportional to the number of nodes it touches.
+ *
+ * Bidirectional search keeps a second, backward state in the same context.
+ * It is allocated on first use, as well as potentials of A* search, marks of
+ * targets and queues of upward search.
+ *
+ * A context can also remember the order in which Dijkstra's algorithm
+ * finished nodes. Together with the nodes left in the queue this is the whole
+ * state of the search, which search_save() copies out and search_resume()
+ * puts back to continue the search later.
+ *
+ * @file    search.c
+ */
+#include "search.h"
+#include "stats.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** State of a search in one direction. */
+struct direction {
+    /** Epoch in which state of each node was last written */
+    uint32_t *stamp;
+    /** Distance of each node from the starting (or to the destination) node */
+    uint32_t *dist;
+    /** Neighbour of each node on the shortest path. This is the previous node
+     * for forward search and the next node for backward search. */
+    uint32_t *link;
+    /** Queue of reached but unfinished nodes */
+    Pq *queue;
+    /** Queue of reached but unfinished nodes below the core of a contraction
+     * hierarchy, allocated on first upward search */
+    Pq *below;
+};
+
+struct search {
+    /** Searched graph */
+    const Csr *csr;
+    /** Implementation of priority queues */
+    enum pq_kind kind;
+    /** Number of buckets of bucket queues */
+    uint32_t width;
+    /** Epoch of current search */
+    uint32_t epoch;
+    /** Forward search state */
+    struct direction forward;
+    /** Backward search state, used by bidirectional search only */
+    struct direction backward;
+    /** Lower bound of distance to the destination of each node reached by
+     * A* search, allocated on first use */
+    uint32_t *potential;
+    /** Epoch in which each node was last marked as a target of the search,
+     * allocated on first use */
+    uint32_t *target;
+    /** Number of nodes finished by last search */
+    uint32_t settled;
+    /** Nodes whose edges were relaxed by Dijkstra's algorithm in order,
+     * NULL unless search_trace() was called */
+    uint32_t *order;
+    /** Number of nodes in `order` */
+    uint32_t ordered;
+    /** Node finished last, its edges may not be relaxed yet */
+    uint32_t last;
+#ifdef GRAPH_STATS
+    /** Work of finished searches not yet added to the totals */
+    uint64_t counts[STATS_COUNTERS];
+#endif
+};
+
+/** Bucket queue is picked automatically only if it needs at most this many
+ * buckets */
+#define DIAL_AUTO_WIDTH 4096
+/** Upper limit of number of buckets of a bucket queue */
+#define DIAL_MAX_WIDTH 65536
+
+enum pq_kind search_auto_queue(const Csr *csr)
+{
+    if (csr && csr->min_weight >= 0 && csr->typical_weight < DIAL_AUTO_WIDTH) {
+        return PQ_DIAL;
+    }
+    return PQ_BINARY;
+}
+
+/**
+ * Allocate state of one direction.
+ *
+ * @param s     search context
+ * @param d     state to be allocated
+ * @return      true if successful, false if memory ran out
+ */
+static bool direction_init(Search *s, struct direction *d)
+{
+    size_t n = (size_t) s->csr->nodes_num + 1;
+    d->stamp = calloc(n, sizeof *d->stamp);
+    d->dist = malloc(n * sizeof *d->dist);
+    d->link = malloc(n * sizeof *d->link);
+    d->queue = pq_new(s->kind, s->csr->nodes_num, s->width);
+    return d->stamp && d->dist && d->link && d->queue;
+}
+
+/**
+ * Free state of one direction.
+ *
+ * @param d     state to be freed
+ */
+static void direction_free(struct direction *d)
+{
+    free(d->stamp);
+    free(d->dist);
+    free(d->link);
+    pq_free(d->queue);
+    pq_free(d->below);
+    memset(d, 0, sizeof *d);
+}
+
+Search * search_new(const Csr *csr, enum pq_kind queue)
+{
+    /* A negative edge could lower distance of a finished node, which is no
+     * longer in the queue. */
+    if (!csr || csr->min_weight < 0) return NULL;
+    Search *s = calloc(1, sizeof *s);
+    if (!s) return NULL;
+    s->csr = csr;
+    s->kind = queue == PQ_AUTO ? search_auto_queue(csr) : queue;
+    /* Bucket queue has one bucket for every distance within typical edge
+     * weight from the closest unfinished node. */
+    s->width = csr->typical_weight > 0 ? csr->typical_weight + 1 : 1;
+    if (s->width > DIAL_MAX_WIDTH) s->width = DIAL_MAX_WIDTH;
+    if (!direction_init(s, &s->forward)) {
+        search_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+const Csr * search_graph(const Search *s)
+{
+    assert(s);
+    return s->csr;
+}
+
+/**
+ * Start a new epoch, invalidating state of all nodes.
+ *
+ * @param s     search context
+ */
+static void new_epoch(Search *s)
+{
+    if (++s->epoch == 0) {
+        /* Stamps could match an old epoch after wrapping around. */
+        size_t n = (size_t) s->csr->nodes_num + 1;
+        memset(s->forward.stamp, 0, n * sizeof *s->forward.stamp);
+        if (s->backward.stamp) {
+            memset(s->backward.stamp, 0, n * sizeof *s->backward.stamp);
+        }
+        if (s->target) {
+            memset(s->target, 0, n * sizeof *s->target);
+        }
+        s->epoch = 1;
+    }
+    pq_clear(s->forward.queue);
+    pq_clear(s->backward.queue);
+    pq_clear(s->forward.below);
+    pq_clear(s->backward.below);
+    STATS_ADD(s->counts, STATS_SETTLED, s->settled);
+    s->settled = 0;
+    s->ordered = 0;
+    s->last = CSR_NONE;
+}
+
+/**
+ * Reach the starting node of one direction.
+ *
+ * @param d     state of the direction
+ * @param queue queue to insert the node into
+ * @param epoch current epoch
+ * @param node  index of the node
+ * @return      true if successful, false if memory ran out
+ */
+static bool start(struct direction *d, Pq *queue, uint32_t epoch,
+        uint32_t node)
+{
+    d->stamp[node] = epoch;
+    d->dist[node] = 0;
+    d->link[node] = CSR_NONE;
+    return pq_push(queue, node, 0);
+}
+
+/**
+ * Offer a new distance to a node.
+ *
+ * @param d     state of the direction
+ * @param queue queue holding the node while it is unfinished
+ * @param epoch current epoch
+ * @param node  index of the node
+ * @param dist  offered distance
+ * @param from  neighbour through which the node is reached
+ * @return      true if successful, false if memory ran out
+ */
+static inline bool relax(struct direction *d, Pq *queue, uint32_t epoch,
+        uint32_t node, uint32_t dist, uint32_t from)
+{
+    if (d->stamp[node] != epoch) {
+        d->stamp[node] = epoch;
+        d->dist[node] = dist;
+        d->link[node] = from;
+        return pq_push(queue, node, dist);
+    }
+    if (dist < d->dist[node]) {
+        d->dist[node] = dist;
+        d->link[node] = from;
+        return pq_decrease(queue, node, dist);
+    }
+    return true;
+}
+
+/**
+ * Continue Dijkstra's algorithm in the forward state of a context from nodes
+ * in its queue.
+ *
+ * @param s             search context with reached nodes in the queue
+ * @param offsets       first edge of each node
+ * @param ends          node at the other end of each edge
+ * @param weights       weight of each edge
+ * @param destination   index of destination node or `CSR_NONE` to finish
+ *                      all reachable nodes
+ * @param targets       number of nodes marked as targets in current epoch,
+ *                      the search stops once all of them are finished
+ * @return              true if the destination was reached or all nodes were
+ *                      finished, false otherwise
+ */
+static bool settle(Search *s, const uint32_t *offsets, const uint32_t *ends,
+        const int32_t *weights, uint32_t destination, size_t targets)
+{
+    struct direction *f = &s->forward;
+    bool ok = true;
+    uint32_t current, dist;
+    while (ok && pq_pop(f->queue, &current, &dist)) {
+        if (dist != f->dist[current]) {
+            continue;           /* Stale entry, the node was finished. */
+        }
+        s->settled++;
+        s->last = current;
+        if (current == destination) {
+            return true;
+        }
+        if (targets > 0 && s->target[current] == s->epoch && --targets == 0) {
+            return true;
+        }
+        STATS_ADD(s->counts, STATS_RELAXATIONS,
+                offsets[current + 1] - offsets[current]);
+        for (uint32_t e = offsets[current]; e < offsets[current + 1]; e++) {
+            ok = ok && relax(f, f->queue, s->epoch, ends[e],
+                    dist + weights[e], current);
+        }
+        if (s->order && ok) {
+            s->order[s->ordered++] = current;
+        }
+    }
+    return ok && destination == CSR_NONE && pq_is_empty(f->queue);
+}
+
+/**
+ * Run Dijkstra's algorithm in the forward state of a context.
+ *
+ * @param s             search context, with a new epoch started
+ * @param offsets       first edge of each node
+ * @param ends          node at the other end of each edge
+ * @param weights       weight of each edge
+ * @param source        index of starting node
+ * @param destination   index of destination node or `CSR_NONE` to finish
+ *                      all reachable nodes
+ * @param targets       number of nodes marked as targets in current epoch,
+ *                      the search stops once all of them are finished
+ * @return              true if the destination was reached or all nodes were
+ *                      finished, false otherwise
+ */
+static bool dijkstra(Search *s, const uint32_t *offsets, const uint32_t *ends,
+        const int32_t *weights, uint32_t source, uint32_t destination,
+        size_t targets)
+{
+    struct direction *f = &s->forward;
+    return start(f, f->queue, s->epoch, source)
+        && settle(s, offsets, ends, weights, destination, targets);
+}
+
+bool search_run(Search *s, uint32_t source, uint32_t destination)
+{
+    if (!s) return false;
+    const Csr *csr = s->csr;
+    assert(source < csr->nodes_num && destination < csr->nodes_num);
+    new_epoch(s);
+    return dijkstra(s, csr->offsets, csr->targets, csr->weights, source,
+            destination, 0);
+}
+
+bool search_run_packed(Search *s, const Packed *p, uint32_t source,
+        uint32_t destination)
+{
+    if (!s || !p) return false;
+    assert(p->nodes_num == s->csr->nodes_num);
+    assert(source < p->nodes_num && destination < p->nodes_num);
+    new_epoch(s);
+    struct direction *f = &s->forward;
+    bool ok = start(f, f->queue, s->epoch, source);
+    uint32_t current, dist;
+    while (ok && pq_pop(f->queue, &current, &dist)) {
+        if (dist != f->dist[current]) {
+            continue;           /* Stale entry, the node was finished. */
+        }
+        s->settled++;
+        if (current == destination) {
+            return true;
+        }
+        struct packed_cursor c;
+        uint32_t target;
+        int32_t weight;
+        packed_edges(p, current, &c);
+        while (ok && packed_next(&c, &target, &weight)) {
+            STATS_ADD(s->counts, STATS_RELAXATIONS, 1);
+            ok = relax(f, f->queue, s->epoch, target, dist + weight, current);
+        }
+    }
+    return false;
+}
+
+bool search_run_all(Search *s, uint32_t source, bool backward)
+{
+    if (!s || (backward && !s->csr->rev_offsets)) return false;
+    const Csr *csr = s->csr;
+    assert(source < csr->nodes_num);
+    new_epoch(s);
+    if (backward) {
+        return dijkstra(s, csr->rev_offsets, csr->rev_sources,
+                csr->rev_weights, source, CSR_NONE, 0);
+    }
+    return dijkstra(s, csr->offsets, csr->targets, csr->weights, source,
+            CSR_NONE, 0);
+}
+
+bool search_run_targets(Search *s, uint32_t source, const uint32_t *targets,
+        size_t len)
+{
+    if (!s || (!targets && len > 0)) return false;
+    const Csr *csr = s->csr;
+    assert(source < csr->nodes_num);
+    if (!s->target) {
+        s->target = calloc((size_t) csr->nodes_num + 1, sizeof *s->target);
+        if (!s->target) return false;
+    }
+    new_epoch(s);
+    size_t distinct = 0;
+    for (size_t i = 0; i < len; i++) {
+        assert(targets[i] < csr->nodes_num);
+        if (s->target[targets[i]] != s->epoch) {
+            s->target[targets[i]] = s->epoch;
+            distinct++;
+        }
+    }
+    if (distinct == 0) return true;
+    return dijkstra(s, csr->offsets, csr->targets, csr->weights, source,
+            CSR_NONE, distinct);
+}
+
+bool search_run_astar(Search *s, uint32_t source, uint32_t destination,
+        search_heuristic heuristic, const void *data)
+{
+    if (!s || !heuristic) return false;
+    const Csr *csr = s->csr;
+    assert(source < csr->nodes_num && destination < csr->nodes_num);
+    if (!s->potential) {
+        s->potential = malloc(((size_t) csr->nodes_num + 1)
+                * sizeof *s->potential);
+        if (!s->potential) return false;
+    }
+    new_epoch(s);
+    struct direction *f = &s->forward;
+    uint32_t *potential = s->potential;
+
+    /* Nodes are ordered by distance from the source plus the lower bound of
+     * distance to the destination, which is computed once per node. */
+    potential[source] = heuristic(data, source, destination);
+    if (potential[source] == UINT32_MAX) {
+        return false;
+    }
+    f->stamp[source] = s->epoch;
+    f->dist[source] = 0;
+    f->link[source] = CSR_NONE;
+    bool ok = pq_push(f->queue, source, potential[source]);
+    uint32_t current, key;
+    while (ok && pq_pop(f->queue, &current, &key)) {
+        uint32_t dist = f->dist[current];
+        if (key != dist + potential[current]) {
+            continue;           /* Stale entry, the node was finished. */
+        }
+        s->settled++;
+        if (current == destination) {
+            return true;
+        }
+        STATS_ADD(s->counts, STATS_RELAXATIONS,
+                csr->offsets[current + 1] - csr->offsets[current]);
+        for (uint32_t e = csr->offsets[current];
+                ok && e < csr->offsets[current + 1]; e++) {
+            uint32_t next = csr->targets[e];
+            uint32_t alt = dist + csr->weights[e];
+            if (f->stamp[next] != s->epoch) {
+                uint32_t bound = heuristic(data, next, destination);
+                if (bound == UINT32_MAX) {
+                    continue;   /* The destination is not reachable. */
+                }
+                potential[next] = bound;
+                f->stamp[next] = s->epoch;
+                f->dist[next] = alt;
+                f->link[next] = current;
+                ok = pq_push(f->queue, next, alt + bound);
+            } else if (alt < f->dist[next]) {
+                f->dist[next] = alt;
+                f->link[next] = current;
+                ok = pq_decrease(f->queue, next, alt + potential[next]);
+            }
+        }
+    }
+    return false;
+}
+
+/** Progress of bidirectional search. */
+struct meeting {
+    /** Length of the best path found so far */
+    uint64_t best;
+    /** Node where forward and backward parts of the best path meet */
+    uint32_t node;
+};
+
+/**
+ * Finish the closest unfinished node of one direction of bidirectional
+ * search.
+ *
+ * Nodes reached in the core of a contraction hierarchy are inserted into the
+ * main queue of the direction and other nodes into the queue of nodes below
+ * the core. Plain bidirectional search has no ranks and all nodes are in the
+ * core.
+ *
+ * @param s             search context
+ * @param forward       advance forward search, backward search otherwise
+ * @param queue         queue to take the node from
+ * @param rank          rank of each node or NULL
+ * @param core_rank     lowest rank of a core node
+ * @param m             best path found so far, updated
+ * @param[out] dist     distance of finished node, `UINT64_MAX` if the queue
+ *                      was empty
+ * @return              true if successful, false if memory ran out
+ */
+static bool advance(Search *s, bool forward, Pq *queue, const uint32_t *rank,
+        uint32_t core_rank, struct meeting *m, uint64_t *dist)
+{
+    const Csr *csr = s->csr;
+    struct direction *d = forward ? &s->forward : &s->backward;
+    const struct direction *other = forward ? &s->backward : &s->forward;
+    const uint32_t *offsets = forward ? csr->offsets : csr->rev_offsets;
+    const uint32_t *ends = forward ? csr->targets : csr->rev_sources;
+    const int32_t *weights = forward ? csr->weights : csr->rev_weights;
+    uint32_t current, key;
+    do {
+        if (pq_is_empty(queue)) {
+            *dist = UINT64_MAX;
+            return true;
+        }
+        if (!pq_pop(queue, &current, &key)) {
+            return false;
+        }
+    } while (key != d->dist[current]);      /* Skip stale entries. */
+    *dist = key;
+    if (key >= m->best) {
+        return true;            /* No shorter path leads through the node. */
+    }
+    s->settled++;
+    STATS_ADD(s->counts, STATS_RELAXATIONS,
+            offsets[current + 1] - offsets[current]);
+    bool ok = true;
+    for (uint32_t e = offsets[current]; e < offsets[current + 1]; e++) {
+        uint32_t next = ends[e];
+        Pq *q = !rank || rank[next] >= core_rank ? d->queue : d->below;
+        ok = ok && relax(d, q, s->epoch, next, key + weights[e], current);
+        if (other->stamp[next] == s->epoch
+                && (uint64_t) d->dist[next] + other->dist[next] < m->best) {
+            m->best = (uint64_t) d->dist[next] + other->dist[next];
+            m->node = next;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Run Dijkstra's algorithm from both ends of the path.
+ *
+ * Plain bidirectional search explores the same graph in both directions and
+ * stops as soon as the radii of both searches add up to the best path found.
+ *
+ * Upward search explores different graphs in each direction (see
+ * search_run_upward()). Below the core of the hierarchy each direction only
+ * stops once its closest unfinished node is not closer than the best path.
+ * Core nodes reached meanwhile wait in the main queues. Edges between core
+ * nodes lead both ways, so the core is then searched as a plain graph.
+ *
+ * @param s             search context
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @param rank          rank of each node, NULL for plain search
+ * @param core_rank     lowest rank of a core node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+static bool bidirectional(Search *s, uint32_t source, uint32_t destination,
+        const uint32_t *rank, uint32_t core_rank)
+{
+    const Csr *csr = s->csr;
+    assert(source < csr->nodes_num && destination < csr->nodes_num);
+    if (!s->backward.stamp && !direction_init(s, &s->backward)) {
+        direction_free(&s->backward);
+        return false;
+    }
+    struct direction *f = &s->forward;
+    struct direction *b = &s->backward;
+    if (rank && !f->below) {
+        f->below = pq_new(s->kind, csr->nodes_num, s->width);
+        b->below = pq_new(s->kind, csr->nodes_num, s->width);
+        if (!f->below || !b->below) {
+            pq_free(f->below);
+            pq_free(b->below);
+            f->below = b->below = NULL;
+            return false;
+        }
+    }
+    new_epoch(s);
+    bool ok = start(f, !rank || rank[source] >= core_rank ? f->queue
+                : f->below, s->epoch, source)
+            && start(b, !rank || rank[destination] >= core_rank ? b->queue
+                : b->below, s->epoch, destination);
+    struct meeting m = {
+        .best = source == destination ? 0 : UINT64_MAX,
+        .node = source == destination ? source : CSR_NONE
+    };
+
+    /* Distances of nodes finished last in each direction, `UINT64_MAX` once
+     * its queue runs out. All unfinished nodes are at least this far. */
+    uint64_t radius_f = 0;
+    uint64_t radius_b = 0;
+    if (rank) {
+        /* A direction is done below the core when its queue runs out or
+         * holds no node closer than the best path. */
+        while (ok && (radius_f < m.best || radius_b < m.best)) {
+            bool forward = radius_b >= m.best
+                || (radius_f < m.best && radius_f <= radius_b);
+            ok = advance(s, forward, forward ? f->below : b->below, rank,
+                    core_rank, &m, forward ? &radius_f : &radius_b);
+        }
+        radius_f = radius_b = 0;
+    }
+    /* No path shorter than the sum of radii can be found anymore. */
+    while (ok && radius_f < m.best && radius_b < m.best
+            && radius_f + radius_b < m.best) {
+        bool forward = radius_f <= radius_b;
+        ok = advance(s, forward, forward ? f->queue : b->queue, rank,
+                core_rank, &m, forward ? &radius_f : &radius_b);
+    }
+    if (!ok || m.node == CSR_NONE) {
+        return false;
+    }
+
+    /* Extend the forward tree along the backward part of the path, so that
+     * the path can be read by search_previous() like after search_run(). */
+    for (uint32_t node = m.node; node != destination; node = b->link[node]) {
+        uint32_t next = b->link[node];
+        f->stamp[next] = s->epoch;
+        f->dist[next] = f->dist[node] + (b->dist[node] - b->dist[next]);
+        f->link[next] = node;
+    }
+    return true;
+}
+
+bool search_run_bidirectional(Search *s, uint32_t source,
+        uint32_t destination)
+{
+    if (!s || !s->csr->rev_offsets) return false;
+    return bidirectional(s, source, destination, NULL, 0);
+}
+
+bool search_run_upward(Search *s, uint32_t source, uint32_t destination,
+        const uint32_t *rank, uint32_t core_rank)
+{
+    if (!s || !s->csr->rev_offsets || !rank) return false;
+    return bidirectional(s, source, destination, rank, core_rank);
+}
+
+bool search_set_path(Search *s, const uint32_t *nodes, const uint32_t *dists,
+        size_t len)
+{
+    if (!s || !nodes || !dists || len == 0) return false;
+    /* The count of the last search is added to the totals by the next
+     * epoch, do not add it now as well. */
+    uint32_t settled = s->settled;
+    s->settled = 0;
+    new_epoch(s);
+    s->settled = settled;
+    struct direction *f = &s->forward;
+    for (size_t i = 0; i < len; i++) {
+        assert(nodes[i] < s->csr->nodes_num);
+        f->stamp[nodes[i]] = s->epoch;
+        f->dist[nodes[i]] = dists[i];
+        f->link[nodes[i]] = i > 0 ? nodes[i - 1] : CSR_NONE;
+    }
+    return true;
+}
+
+bool search_trace(Search *s)
+{
+    if (!s) return false;
+    if (!s->order) {
+        s->order = malloc(((size_t) s->csr->nodes_num + 1) * sizeof *s->order);
+    }
+    return s->order != NULL;
+}
+
+bool search_save(Search *s, struct search_tree *t)
+{
+    if (!s || !s->order || !t) return false;
+    struct direction *f = &s->forward;
+    /* Nodes left in the queue follow the finished ones; they are all
+     * different, so the array is large enough. */
+    uint32_t len = s->ordered;
+    uint32_t node, key;
+    while (pq_pop(f->queue, &node, &key)) {
+        if (key == f->dist[node]) {
+            s->order[len++] = node;
+        }
+    }
+    if (!pq_is_empty(f->queue)) return false;
+    /* The search stopped at the destination before relaxing its edges. */
+    if (s->last != CSR_NONE
+            && (s->ordered == 0 || s->order[s->ordered - 1] != s->last)) {
+        s->order[len++] = s->last;
+    }
+    t->len = len;
+    t->settled = s->ordered;
+    t->nodes = malloc(((size_t) len + 1) * sizeof *t->nodes);
+    t->dists = malloc(((size_t) len + 1) * sizeof *t->dists);
+    t->links = malloc(((size_t) len + 1) * sizeof *t->links);
+    if (!t->nodes || !t->dists || !t->links) {
+        search_tree_free(t);
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t n = s->order[i];
+        t->nodes[i] = n;
+        t->dists[i] = f->dist[n];
+        t->links[i] = f->link[n];
+    }
+    return true;
+}
+
+bool search_resume(Search *s, const struct search_tree *t,
+        uint32_t destination)
+{
+    if (!s || !t || t->len == 0) return false;
+    const Csr *csr = s->csr;
+    assert(destination < csr->nodes_num);
+    new_epoch(s);
+    struct direction *f = &s->forward;
+    for (uint32_t i = 0; i < t->settled; i++) {
+        uint32_t n = t->nodes[i];
+        f->stamp[n] = s->epoch;
+        f->dist[n] = t->dists[i];
+        f->link[n] = t->links[i];
+    }
+    if (s->order) {
+        memcpy(s->order, t->nodes, t->settled * sizeof *s->order);
+        s->ordered = t->settled;
+    }
+    if (f->stamp[destination] == s->epoch) {
+        return true;
+    }
+    bool ok = true;
+    for (uint32_t i = t->settled; ok && i < t->len; i++) {
+        uint32_t n = t->nodes[i];
+        f->stamp[n] = s->epoch;
+        f->dist[n] = t->dists[i];
+        f->link[n] = t->links[i];
+        ok = pq_push(f->queue, n, t->dists[i]);
+    }
+    return ok && settle(s, csr->offsets, csr->targets, csr->weights,
+            destination, 0);
+}
+
+void search_tree_free(struct search_tree *t)
+{
+    if (t) {
+        free(t->nodes);
+        free(t->dists);
+        free(t->links);
+        memset(t, 0, sizeof *t);
+    }
+}
+
+uint32_t search_distance(const Search *s, uint32_t node)
+{
+    assert(s && node < s->csr->nodes_num);
+    const struct direction *f = &s->forward;
+    return f->stamp[node] == s->epoch ? f->dist[node] : UINT32_MAX;
+}
+
+uint32_t search_previous(const Search *s, uint32_t node)
+{
+    assert(s && node < s->csr->nodes_num);
+    const struct direction *f = &s->forward;
+    return f->stamp[node] == s->epoch ? f->link[node] : CSR_NONE;
+}
+
+uint32_t search_settled(const Search *s)
+{
+    assert(s);
+    return s->settled;
+}
+
+void search_free(Search *s)
+{
+    if (s) {
+        STATS_ADD(s->counts, STATS_SETTLED, s->settled);
+        STATS_FLUSH(s->counts);
+        direction_free(&s->forward);
+        direction_free(&s->backward);
+        free(s->potential);
+        free(s->target);
+        free(s->order);
+    }
+    free(s);
+}
@@ -0,0 +1,315 @@
+/**
+ * Interface for searching shortest paths in frozen graphs.
+ *
+ * All state of a search (distances, previous nodes and the priority queue)
+ * is kept in a search context, not in the graph. A context belongs to one
+ * graph and can be reused for any number of searches, but only one at a
+ * time. Independent searches over the same graph can run in parallel, each
+ * in its own context.
+ *
+ * @file    search.h
+ */
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "packed.h"
+#include "pq.h"
+
+/**
+ * Search context is an opaque type.
+ * Do not access its members directly, use provided functions.
+ */
+typedef struct search Search;
+
+/**
+ * Pick priority queue suitable for a graph.
+ * Bucket queue is used when edge weights are small non-negative integers,
+ * binary heap otherwise.
+ *
+ * @param csr   graph to be searched
+ * @return      kind of priority queue
+ */
+enum pq_kind search_auto_queue(const Csr *csr);
+
+/**
+ * Create a new search context for a graph.
+ * The graph must not be freed before the context and its edge weights must
+ * not be negative.
+ *
+ * @param csr   graph to be searched
+ * @param queue implementation of priority queue to be used, `PQ_AUTO` picks
+ *              one with search_auto_queue()
+ * @return      new context or NULL if the graph has negative edge weights
+ *              or memory is exhausted
+ */
+Search * search_new(const Csr *csr, enum pq_kind queue);
+
+/**
+ * Get the graph a context belongs to.
+ *
+ * @param s     context to query
+ * @return      searched graph
+ */
+const Csr * search_graph(const Search *s);
+
+/**
+ * Find shortest path between two nodes using Dijkstra's algorithm.
+ * The search stops as soon as the destination is reached, distances of nodes
+ * that were not reached by then are reported as infinite. Edge weights must
+ * not be negative.
+ *
+ * @param s             context to search in
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool search_run(Search *s, uint32_t source, uint32_t destination);
+
+/**
+ * Find shortest path between two nodes over compressed edges.
+ * This is search_run() reading edges from packed form, arrays of edges of
+ * the graph the context was created for are not used. Edges are visited
+ * in a different order, so of several shortest paths another one may be
+ * found.
+ *
+ * @param s             context created for the graph the edges were
+ *                      compressed from
+ * @param p             compressed edges
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool search_run_packed(Search *s, const Packed *p, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Find distances from a node to all nodes, or from all nodes to a node.
+ * The backward search follows edges in reverse and needs reverse edges built
+ * by csr_build_reverse(). Results are reported by search_distance() and
+ * search_previous(), for backward search they describe paths leading to the
+ * starting node.
+ *
+ * @param s         context to search in
+ * @param source    index of starting node
+ * @param backward  follow edges in reverse
+ * @return          true if successful, false if memory ran out or the graph
+ *                  has no reverse edges
+ */
+bool search_run_all(Search *s, uint32_t source, bool backward);
+
+/**
+ * Find distances from a node to several nodes.
+ * The search stops as soon as all targets are finished, results are
+ * reported as after search_run_all() for the targets and all nodes closer
+ * than the farthest one.
+ *
+ * @param s         context to search in
+ * @param source    index of starting node
+ * @param targets   indices of target nodes, duplicates are allowed
+ * @param len       number of targets
+ * @return          true if successful, false if memory ran out
+ */
+bool search_run_targets(Search *s, uint32_t source, const uint32_t *targets,
+        size_t len);
+
+/**
+ * Lower bound of distance between two nodes used to guide A* search.
+ * The bound must be consistent, that is it must not decrease by more than the
+ * weight of an edge when moving along it, otherwise found paths may not be
+ * the shortest ones.
+ *
+ * @param data          data of the heuristic
+ * @param node          index of a node
+ * @param destination   index of destination node
+ * @return              lower bound of distance from the node to the
+ *                      destination or `UINT32_MAX` if the destination is
+ *                      known to be unreachable
+ */
+typedef uint32_t (*search_heuristic)(const void *data, uint32_t node,
+        uint32_t destination);
+
+/**
+ * Find shortest path between two nodes using A* search.
+ * Results are reported as after search_run().
+ *
+ * @param s             context to search in
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @param heuristic     lower bound of remaining distance
+ * @param data          data passed to the heuristic
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool search_run_astar(Search *s, uint32_t source, uint32_t destination,
+        search_heuristic heuristic, const void *data);
+
+/**
+ * Find shortest path between two nodes using bidirectional Dijkstra's
+ * algorithm.
+ * Forward search from the starting node and backward search from the
+ * destination run alternately until no shorter path can be found. The graph
+ * must have reverse edges built by csr_build_reverse().
+ *
+ * After the search, nodes on the found path are reported by
+ * search_distance() and search_previous() as after search_run(). Other nodes
+ * may be reported as unreachable or with distances that are not final.
+ *
+ * @param s             context to search in
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not, memory ran out or the graph has no reverse edges
+ */
+bool search_run_bidirectional(Search *s, uint32_t source,
+        uint32_t destination);
+
+/**
+ * Find shortest path between two nodes in a contraction hierarchy.
+ * The searched graph must hold upward edges of the hierarchy as its edges
+ * and downward edges as its reverse edges (see ch.h). Forward search follows
+ * upward edges from the starting node, backward search follows downward
+ * edges in reverse from the destination and the shortest path is found where
+ * they meet.
+ *
+ * Nodes with rank at least `core_rank` form the core of the hierarchy,
+ * whose edges are both upward and downward; it is searched like by
+ * search_run_bidirectional().
+ *
+ * Results are reported as after search_run_bidirectional(), the path
+ * consists of edges of the hierarchy.
+ *
+ * @param s             context to search in
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @param rank          rank of each node
+ * @param core_rank     lowest rank of a core node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool search_run_upward(Search *s, uint32_t source, uint32_t destination,
+        const uint32_t *rank, uint32_t core_rank);
+
+/**
+ * Saved state of Dijkstra's algorithm, see search_save().
+ * Members can be read directly. Finished nodes come first in the order in
+ * which they were finished, nodes reached but not finished follow.
+ */
+struct search_tree {
+    /** Number of reached nodes */
+    uint32_t len;
+    /** Number of finished nodes */
+    uint32_t settled;
+    /** Index of each node */
+    uint32_t *nodes;
+    /** Distance of each node from the starting node, final for finished
+     * nodes */
+    uint32_t *dists;
+    /** Previous node of each node, `CSR_NONE` for the starting node */
+    uint32_t *links;
+};
+
+/**
+ * Make Dijkstra's algorithm remember the order in which it finished nodes,
+ * which search_save() needs.
+ * This function fails only if memory runs out.
+ *
+ * @param s     search context
+ * @return      true if successful, false otherwise
+ */
+bool search_trace(Search *s);
+
+/**
+ * Copy state of last search started by search_run() or search_resume().
+ * The search can be continued later from the copy by search_resume(), even
+ * in another context for the same graph. The context needs search_trace()
+ * before the search. After search_resume() the state is complete only if
+ * search_settled() is not zero. The queue of the context is emptied, results
+ * of the search are kept.
+ *
+ * @param s     search context
+ * @param t     where to store the state, free it with search_tree_free()
+ * @return      true if successful, false if memory ran out
+ */
+bool search_save(Search *s, struct search_tree *t);
+
+/**
+ * Find shortest path from the starting node of a saved search.
+ * If the destination was finished by the saved search, only finished nodes
+ * are put back and search_settled() reports zero; otherwise the saved search
+ * continues until it finishes the destination. Results are the same as if the
+ * path was found by search_run().
+ *
+ * @param s             context to search in
+ * @param t             saved state of the search
+ * @param destination   index of destination node
+ * @return              true if the destination is reachable, false if it is
+ *                      not or memory ran out
+ */
+bool search_resume(Search *s, const struct search_tree *t,
+        uint32_t destination);
+
+/**
+ * Free arrays of a saved search.
+ *
+ * @param t     saved state to be freed
+ */
+void search_tree_free(struct search_tree *t);
+
+/**
+ * Replace results of last search with a path found by other means.
+ * Nodes of the path are then reported by search_distance() and
+ * search_previous() as if it was found by search_run(); all other nodes are
+ * reported as unreachable. Number of nodes finished by last search is kept.
+ *
+ * @param s     search context
+ * @param nodes indices of nodes on the path, starting with its first node
+ * @param dists distance of each node from the first one
+ * @param len   number of nodes on the path, at least one
+ * @return      true if successful, false if the path is empty
+ */
+bool search_set_path(Search *s, const uint32_t *nodes, const uint32_t *dists,
+        size_t len);
+
+/**
+ * Get distance of a node from the starting node of last search.
+ * Infinity is signalled by `UINT32_MAX`.
+ *
+ * @param s     context to query
+ * @param node  index of the node
+ * @return      total distance
+ */
+uint32_t search_distance(const Search *s, uint32_t node);
+
+/**
+ * Get node from which queried node was reached in last search.
+ * For starting and unreachable nodes this function returns `CSR_NONE`.
+ *
+ * @param s     context to query
+ * @param node  index of the node
+ * @return      index of previous node or `CSR_NONE`
+ */
+uint32_t search_previous(const Search *s, uint32_t node);
+
+/**
+ * Get number of nodes finished by last search.
+ * This is a measure of work done by the search.
+ *
+ * @param s     context to query
+ * @return      number of finished nodes
+ */
+uint32_t search_settled(const Search *s);
+
+/**
+ * Free a search context.
+ *
+ * @param s     context to be freed
+ */
+void search_free(Search *s);
+
+#endif /* end of include guard: SEARCH_H */
@@ -0,0 +1,213 @@
+/**
+ * Functions for storing frozen graphs in binary files.
+ *
+ * The file starts with a fixed size header followed by arrays `offsets`,
+ * `ids`, `targets` and `weights`, laid out as described in binfile.h. All
+ * numbers are stored in native byte order, which is recorded in the header so
+ * that a snapshot from a machine with different endianness is rejected
+ * instead of misread.
+ *
+ * @file    snapshot.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "snapshot.h"
+#include "binfile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Magic bytes identifying a snapshot file */
+static const char SNAPSHOT_MAGIC[8] = "DIMESNAP";
+/** Flag of snapshots of reordered graphs */
+#define SNAPSHOT_REORDERED 1
+
+/** Header of a snapshot file. */
+struct snapshot_header {
+    /** Always `SNAPSHOT_MAGIC` */
+    char magic[8];
+    /** Format version */
+    uint32_t version;
+    /** Always `BINFILE_BYTE_ORDER` in byte order of the writer */
+    uint32_t byte_order;
+    /** Number of nodes */
+    uint64_t nodes_num;
+    /** Number of edges */
+    uint64_t edges_num;
+    /** File positions of the arrays */
+    uint64_t offsets_pos;
+    uint64_t ids_pos;
+    uint64_t targets_pos;
+    uint64_t weights_pos;
+    /** Total size of the file */
+    uint64_t file_size;
+    /** Statistics of edge weights, see struct csr */
+    int32_t min_weight;
+    int32_t max_weight;
+    int32_t typical_weight;
+    /** Combination of `SNAPSHOT_REORDERED` */
+    uint32_t flags;
+    /** Checksum of everything after the header */
+    uint64_t data_checksum;
+    /** Checksum of the header with this member set to zero */
+    uint64_t header_checksum;
+};
+
+/**
+ * Compute checksum of the header.
+ *
+ * @param hdr   header to be hashed
+ * @return      checksum
+ */
+static uint64_t header_checksum(const struct snapshot_header *hdr)
+{
+    struct snapshot_header tmp = *hdr;
+    tmp.header_checksum = 0;
+    return binfile_checksum(BINFILE_CHECKSUM_INIT, &tmp, sizeof tmp);
+}
+
+bool snapshot_save(const Csr *csr, const char *path)
+{
+    if (!csr || !path) return false;
+    struct snapshot_header hdr;
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof hdr.magic);
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.byte_order = BINFILE_BYTE_ORDER;
+    hdr.nodes_num = csr->nodes_num;
+    hdr.edges_num = csr->edges_num;
+    hdr.min_weight = csr->min_weight;
+    hdr.max_weight = csr->max_weight;
+    hdr.typical_weight = csr->typical_weight;
+    hdr.flags = csr->reordered ? SNAPSHOT_REORDERED : 0;
+
+    const void *data[4] = { csr->offsets, csr->ids, csr->targets,
+        csr->weights };
+    size_t lens[4] = {
+        ((size_t) csr->nodes_num + 1) * sizeof *csr->offsets,
+        (size_t) csr->nodes_num * sizeof *csr->ids,
+        (size_t) csr->edges_num * sizeof *csr->targets,
+        (size_t) csr->edges_num * sizeof *csr->weights,
+    };
+    uint64_t *pos[4] = { &hdr.offsets_pos, &hdr.ids_pos, &hdr.targets_pos,
+        &hdr.weights_pos };
+    uint64_t at = binfile_align(sizeof hdr);
+    for (int i = 0; i < 4; i++) {
+        *pos[i] = at;
+        at += binfile_align(lens[i]);
+    }
+    hdr.file_size = at;
+
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    /* Header is written twice, the second time with checksums filled in. */
+    bool ok = binfile_write_section(f, &hdr, sizeof hdr, NULL);
+    hdr.data_checksum = BINFILE_CHECKSUM_INIT;
+    for (int i = 0; ok && i < 4; i++) {
+        ok = binfile_write_section(f, data[i], lens[i], &hdr.data_checksum);
+    }
+    hdr.header_checksum = header_checksum(&hdr);
+    ok = ok && fseek(f, 0, SEEK_SET) == 0
+        && fwrite(&hdr, sizeof hdr, 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+/**
+ * Check header of a mapped snapshot.
+ *
+ * @param hdr   header of the file
+ * @param size  real size of the file
+ * @return      true if the header describes a usable snapshot
+ */
+static bool header_valid(const struct snapshot_header *hdr, size_t size)
+{
+    if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof hdr->magic) != 0
+            || hdr->byte_order != BINFILE_BYTE_ORDER
+            || hdr->version != SNAPSHOT_VERSION
+            || hdr->header_checksum != header_checksum(hdr)
+            || hdr->file_size != size
+            || (hdr->flags & ~SNAPSHOT_REORDERED) != 0
+            || hdr->nodes_num >= UINT32_MAX
+            || hdr->edges_num >= UINT32_MAX) {
+        return false;
+    }
+    return binfile_section_valid(sizeof *hdr, size, hdr->offsets_pos,
+                (hdr->nodes_num + 1) * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->ids_pos,
+                hdr->nodes_num * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->targets_pos,
+                hdr->edges_num * 4)
+        && binfile_section_valid(sizeof *hdr, size, hdr->weights_pos,
+                hdr->edges_num * 4);
+}
+
+/**
+ * Check that edges of each node lie between those of the previous node and
+ * the end of the edge arrays.
+ *
+ * @param csr   graph mapped from a snapshot
+ * @return      true if offsets of edges are valid
+ */
+static bool offsets_valid(const Csr *csr)
+{
+    if (csr->offsets[0] != 0
+            || csr->offsets[csr->nodes_num] != csr->edges_num) {
+        return false;
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        if (csr->offsets[i] > csr->offsets[i + 1]) return false;
+    }
+    return true;
+}
+
+Csr * snapshot_open(const char *path, bool verify)
+{
+    size_t size;
+    void *map = binfile_map(path, sizeof(struct snapshot_header), &size);
+    if (!map) return NULL;
+
+    const struct snapshot_header *hdr = map;
+    const char *base = map;
+    size_t data_pos = binfile_align(sizeof *hdr);
+    if (!header_valid(hdr, size) || (verify && hdr->data_checksum
+                != binfile_checksum(BINFILE_CHECKSUM_INIT, base + data_pos,
+                    size - data_pos))) {
+        munmap(map, size);
+        return NULL;
+    }
+
+    Csr *csr = calloc(1, sizeof *csr);
+    if (!csr) {
+        munmap(map, size);
+        return NULL;
+    }
+    csr->map = map;
+    csr->map_size = size;
+    csr->nodes_num = hdr->nodes_num;
+    csr->edges_num = hdr->edges_num;
+    /* The mapping is read-only, arrays are only declared writable because
+     * the same structure is used for graphs built in memory. */
+    csr->offsets = (uint32_t *) (base + hdr->offsets_pos);
+    csr->ids = (uint32_t *) (base + hdr->ids_pos);
+    csr->targets = (uint32_t *) (base + hdr->targets_pos);
+    csr->weights = (int32_t *) (base + hdr->weights_pos);
+    csr->min_weight = hdr->min_weight;
+    csr->max_weight = hdr->max_weight;
+    csr->typical_weight = hdr->typical_weight;
+    csr->reordered = hdr->flags & SNAPSHOT_REORDERED;
+    /* Data of the file are exactly the hashed arrays of the graph. */
+    csr->checksum = hdr->data_checksum;
+
+    /* Identifiers of reordered graphs can not be searched without the
+     * map. */
+    if (!offsets_valid(csr) || (csr->reordered && !csr_build_idmap(csr))) {
+        csr_free(csr);
+        return NULL;
+    }
+    return csr;
+}
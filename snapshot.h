@@ -0,0 +1,48 @@
+/**
+ * Interface for storing frozen graphs in binary files.
+ *
+ * A snapshot contains all arrays of a frozen graph exactly as they are laid
+ * out in memory, so opening it only maps the file and checks its header. No
+ * parsing or copying takes place and pages are loaded lazily when the search
+ * touches them.
+ *
+ * @file    snapshot.h
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+
+#include "csr.h"
+
+/** Version of the snapshot format written by this program. */
+#define SNAPSHOT_VERSION 3
+
+/**
+ * Write frozen graph into a snapshot file.
+ * Existing file is overwritten.
+ *
+ * @param csr   frozen graph to be stored
+ * @param path  name of the file
+ * @return      true if successful, false otherwise
+ */
+bool snapshot_save(const Csr *csr, const char *path);
+
+/**
+ * Open a snapshot file.
+ * The file is mapped read-only into memory, arrays of the returned graph
+ * point directly into the mapping. Header of the file and offsets of edges
+ * are always checked, checksum of the data is only verified when `verify` is
+ * true, because it needs to read the whole file. Targets of edges are not
+ * checked, so a snapshot opened without `verify` must come from a trusted
+ * source; a damaged one may make searches read outside of the graph.
+ *
+ * Free the returned graph with csr_free().
+ *
+ * @param path      name of the file
+ * @param verify    whether to verify checksum of the data
+ * @return          frozen graph or NULL if the file can not be used
+ */
+Csr * snapshot_open(const char *path, bool verify);
+
+#endif /* end of include guard: SNAPSHOT_H */
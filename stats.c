@@ -0,0 +1,86 @@
+/**
+ * Functions for measuring where the program spends its time.
+ *
+ * @file    stats.c
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/resource.h>
+
+/** Names of phases indexed by enum stats_phase */
+static const char *PHASE_NAMES[STATS_PHASES] = {
+    "snapshot", "load_nodes", "load_edges", "index", "queue", "search",
+    "output"
+};
+
+/** Names of counters indexed by enum stats_counter */
+static const char *COUNTER_NAMES[STATS_COUNTERS] = {
+    "pq_push", "pq_pop", "pq_decrease", "relaxations", "settled"
+};
+
+/** Guards the totals */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/** Time spent in each phase in microseconds */
+static double times[STATS_PHASES];
+/** Total of each counter */
+static uint64_t totals[STATS_COUNTERS];
+
+void stats_add_time(enum stats_phase phase, double micros)
+{
+    if (phase >= STATS_PHASES) return;
+    pthread_mutex_lock(&lock);
+    times[phase] += micros;
+    pthread_mutex_unlock(&lock);
+}
+
+void stats_add_counts(uint64_t *counts)
+{
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < STATS_COUNTERS; i++) {
+        totals[i] += counts[i];
+    }
+    pthread_mutex_unlock(&lock);
+    memset(counts, 0, STATS_COUNTERS * sizeof *counts);
+}
+
+bool stats_enabled(void)
+{
+#ifdef GRAPH_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool stats_write_json(FILE *f)
+{
+    struct rusage usage;
+    long peak = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+
+    pthread_mutex_lock(&lock);
+    fprintf(f, "{\n  \"phases_ms\": {");
+    for (int i = 0; i < STATS_PHASES; i++) {
+        fprintf(f, "%s\n    \"%s\": %.3f", i ? "," : "", PHASE_NAMES[i],
+                times[i] / 1e3);
+    }
+    fprintf(f, "\n  },\n  \"counters\": ");
+    if (stats_enabled()) {
+        fputc('{', f);
+        for (int i = 0; i < STATS_COUNTERS; i++) {
+            fprintf(f, "%s\n    \"%s\": %llu", i ? "," : "", COUNTER_NAMES[i],
+                    (unsigned long long) totals[i]);
+        }
+        fprintf(f, "\n  },\n");
+    } else {
+        fprintf(f, "null,\n");
+    }
+    pthread_mutex_unlock(&lock);
+    /* Linux reports the peak in kibibytes. */
+    fprintf(f, "  \"peak_rss_bytes\": %llu\n}\n",
+            (unsigned long long) peak * 1024);
+    return !ferror(f);
+}
@@ -0,0 +1,102 @@
+/**
+ * Interface for measuring where the program spends its time.
+ *
+ * Time of each phase of the program is added by the caller and costs one
+ * clock reading per phase. Counts of events in the inner loops of searches
+ * are only collected when the program is built with `GRAPH_STATS` defined
+ * (`make STATS=1`); otherwise STATS_ADD() expands to nothing and the
+ * counters do not exist at all.
+ *
+ * Counters are kept in the structure doing the work (a priority queue,
+ * search context or worker), so threads never share them, and added to the
+ * totals when the structure is freed.
+ *
+ * @file    stats.h
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Phases of the program whose time is measured. */
+enum stats_phase {
+    /** Mapping a snapshot */
+    STATS_SNAPSHOT,
+    /** Reading nodes from CSV */
+    STATS_LOAD_NODES,
+    /** Reading and inserting edges from CSV */
+    STATS_LOAD_EDGES,
+    /** Sorting nodes, building arrays and indices of the engine */
+    STATS_INDEX,
+    /** Allocating search contexts and their priority queues */
+    STATS_QUEUE,
+    /** Searching */
+    STATS_SEARCH,
+    /** Formatting and writing results */
+    STATS_OUTPUT,
+    /** Number of phases */
+    STATS_PHASES
+};
+
+/** Counted events. */
+enum stats_counter {
+    /** Entries inserted into priority queues */
+    STATS_PUSHES,
+    /** Entries removed with minimal key, including stale ones */
+    STATS_POPS,
+    /** Keys decreased */
+    STATS_DECREASES,
+    /** Edges relaxed by searches */
+    STATS_RELAXATIONS,
+    /** Nodes finished by searches */
+    STATS_SETTLED,
+    /** Number of counters */
+    STATS_COUNTERS
+};
+
+#ifdef GRAPH_STATS
+/** Add to a counter in an array of `STATS_COUNTERS` elements. */
+#define STATS_ADD(counts, counter, n) ((counts)[counter] += (n))
+/** Add an array of counters to the totals and clear it. */
+#define STATS_FLUSH(counts) stats_add_counts(counts)
+#else
+#define STATS_ADD(counts, counter, n) ((void) 0)
+#define STATS_FLUSH(counts) ((void) 0)
+#endif
+
+/**
+ * Add time spent in a phase.
+ * This function can be called from any thread.
+ *
+ * @param phase     phase of the program
+ * @param micros    duration in microseconds
+ */
+void stats_add_time(enum stats_phase phase, double micros);
+
+/**
+ * Add counters to the totals and clear them.
+ * This function can be called from any thread.
+ *
+ * @param counts    array of `STATS_COUNTERS` counters
+ */
+void stats_add_counts(uint64_t *counts);
+
+/**
+ * Test whether counters are compiled in.
+ *
+ * @return  true if the program was built with `GRAPH_STATS`
+ */
+bool stats_enabled(void);
+
+/**
+ * Write times of phases, counters and peak resident set size as a JSON
+ * object. Counters are `null` unless stats_enabled().
+ *
+ * @param f     file to write to
+ * @return      true if successful, false if writing failed
+ */
+bool stats_write_json(FILE *f);
+
+#endif /* end of include guard: STATS_H */
@@ -0,0 +1,492 @@
+/**
+ * Functions for finding several shortest loopless paths (Yen's algorithm).
+ *
+ * Searches from spur nodes have their own loop instead of search_run_astar()
+ * to skip blocked nodes and edges without slowing down other searches. Each
+ * search starts at the distance of its spur node from the starting node, so
+ * distances of found nodes are distances along the whole path.
+ *
+ * @file    yen.c
+ */
+#include "yen.h"
+#include "pq.h"
+#include "search.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** State of searches from spur nodes owned by one thread. */
+struct spur_worker {
+    /** Epoch of current search, see search.c */
+    uint32_t epoch;
+    /** Epoch in which distance of each node was last written */
+    uint32_t *stamp;
+    /** Distance of each node from the starting node */
+    uint32_t *dist;
+    /** Node from which each node was reached */
+    uint32_t *link;
+    /** Epoch in which each node was last on the shared part of the path */
+    uint32_t *removed;
+    /** Epoch in which edges from the spur node to each node were last
+     * taken by earlier paths */
+    uint32_t *banned;
+    /** Queue of reached but unfinished nodes */
+    Pq *queue;
+    /** Whether memory ran out */
+    bool failed;
+};
+
+/** Found paths and state shared by all threads. */
+struct yen {
+    /** Searched graph */
+    const Csr *csr;
+    /** Index of destination node */
+    uint32_t destination;
+    /** Spur searches stop at paths longer than this, there are enough
+     * shorter candidates */
+    uint32_t limit;
+    /** Distance from each node to the destination, `UINT32_MAX` if it can
+     * not be reached */
+    uint32_t *to_dest;
+    /** Accepted paths, the last one is being spurred from */
+    struct yen_path *paths;
+    uint32_t count;
+    /** Path found from each spur node of the last path, empty if there is
+     * none */
+    struct yen_path *spurs;
+    uint32_t spurs_size;
+    /** Paths waiting to be accepted */
+    struct yen_path *candidates;
+    uint32_t candidates_len;
+    uint32_t candidates_size;
+    /** State of each thread */
+    struct spur_worker *workers;
+    size_t workers_num;
+};
+
+/**
+ * Free a path and mark it empty.
+ *
+ * @param p     path to be freed
+ */
+static void path_free(struct yen_path *p)
+{
+    free(p->nodes);
+    free(p->dists);
+    memset(p, 0, sizeof *p);
+}
+
+/**
+ * Allocate arrays of a path.
+ *
+ * @param p     path to be filled
+ * @param len   number of nodes
+ * @return      true if successful, false if memory ran out
+ */
+static bool path_alloc(struct yen_path *p, uint32_t len)
+{
+    p->nodes = malloc(((size_t) len + 1) * sizeof *p->nodes);
+    p->dists = malloc(((size_t) len + 1) * sizeof *p->dists);
+    p->len = len;
+    if (!p->nodes || !p->dists) {
+        path_free(p);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Get length of a path.
+ *
+ * @param p     non-empty path
+ * @return      distance of its last node
+ */
+static uint32_t path_length(const struct yen_path *p)
+{
+    return p->dists[p->len - 1];
+}
+
+/**
+ * Start a new search of a thread, clearing its marks when epochs wrap.
+ *
+ * @param y     shared state
+ * @param w     state of the thread
+ */
+static void next_epoch(const struct yen *y, struct spur_worker *w)
+{
+    if (++w->epoch == 0) {
+        size_t len = (size_t) y->csr->nodes_num * sizeof *w->stamp;
+        memset(w->stamp, 0, len);
+        memset(w->removed, 0, len);
+        memset(w->banned, 0, len);
+        w->epoch = 1;
+    }
+}
+
+/**
+ * Find the shortest path from a spur node of the last accepted path that
+ * avoids blocked nodes and edges marked in current epoch.
+ *
+ * @param y     shared state
+ * @param w     state of the thread
+ * @param i     position of the spur node in the last path
+ * @param out   where to store the whole path, left empty if there is none
+ */
+static void spur_search(const struct yen *y, struct spur_worker *w,
+        uint32_t i, struct yen_path *out)
+{
+    const Csr *csr = y->csr;
+    const struct yen_path *last = &y->paths[y->count - 1];
+    uint32_t spur = last->nodes[i];
+    pq_clear(w->queue);
+    w->stamp[spur] = w->epoch;
+    w->dist[spur] = last->dists[i];
+    w->link[spur] = CSR_NONE;
+    if (!pq_push(w->queue, spur, last->dists[i] + y->to_dest[spur])) {
+        w->failed = true;
+        return;
+    }
+    bool ok = true;
+    bool found = false;
+    uint32_t current, key;
+    while (ok && pq_pop(w->queue, &current, &key)) {
+        if (key > y->limit) break;
+        if (current == y->destination) {
+            found = true;
+            break;
+        }
+        for (uint32_t e = csr->offsets[current];
+                ok && e < csr->offsets[current + 1]; e++) {
+            uint32_t next = csr->targets[e];
+            if (w->removed[next] == w->epoch || y->to_dest[next] == UINT32_MAX
+                    || (current == spur && w->banned[next] == w->epoch)) {
+                continue;
+            }
+            uint64_t alt = (uint64_t) w->dist[current] + csr->weights[e];
+            if (alt + y->to_dest[next] >= UINT32_MAX) continue;
+            if (w->stamp[next] != w->epoch) {
+                w->stamp[next] = w->epoch;
+                w->dist[next] = alt;
+                w->link[next] = current;
+                ok = pq_push(w->queue, next, alt + y->to_dest[next]);
+            } else if (alt < w->dist[next]) {
+                w->dist[next] = alt;
+                w->link[next] = current;
+                ok = pq_decrease(w->queue, next, alt + y->to_dest[next]);
+            }
+        }
+    }
+    if (!ok) {
+        w->failed = true;
+        return;
+    }
+    if (!found) return;
+
+    uint32_t len = i;
+    for (uint32_t n = y->destination; n != CSR_NONE; n = w->link[n]) {
+        len++;
+    }
+    if (!path_alloc(out, len)) {
+        w->failed = true;
+        return;
+    }
+    memcpy(out->nodes, last->nodes, (size_t) i * sizeof *out->nodes);
+    memcpy(out->dists, last->dists, (size_t) i * sizeof *out->dists);
+    uint32_t at = len;
+    for (uint32_t n = y->destination; n != CSR_NONE; n = w->link[n]) {
+        at--;
+        out->nodes[at] = n;
+        out->dists[at] = w->dist[n];
+    }
+    out->spur = i;
+}
+
+/**
+ * Search from one spur node of the last accepted path, called from the
+ * thread pool.
+ *
+ * @param arg       shared struct yen
+ * @param worker    index of the thread
+ * @param task      index of the spur node counted from the position where
+ *                  the last path left its predecessor
+ */
+static void spur_task(void *arg, size_t worker, size_t task)
+{
+    struct yen *y = arg;
+    struct spur_worker *w = &y->workers[worker];
+    const struct yen_path *last = &y->paths[y->count - 1];
+    uint32_t i = last->spur + task;
+    next_epoch(y, w);
+    for (uint32_t j = 0; j < i; j++) {
+        w->removed[last->nodes[j]] = w->epoch;
+    }
+    for (uint32_t p = 0; p < y->count; p++) {
+        const struct yen_path *other = &y->paths[p];
+        if (other->len > i + 1 && memcmp(other->nodes, last->nodes,
+                    ((size_t) i + 1) * sizeof *other->nodes) == 0) {
+            w->banned[other->nodes[i + 1]] = w->epoch;
+        }
+    }
+    spur_search(y, w, i, &y->spurs[task]);
+}
+
+/**
+ * Check whether two paths have the same nodes.
+ *
+ * @param a     first path
+ * @param b     second path
+ * @return      true if the paths are equal
+ */
+static bool same_path(const struct yen_path *a, const struct yen_path *b)
+{
+    return a->len == b->len && path_length(a) == path_length(b)
+        && memcmp(a->nodes, b->nodes, (size_t) a->len * sizeof *a->nodes)
+        == 0;
+}
+
+/**
+ * Move paths found from spur nodes to candidates, dropping duplicates.
+ *
+ * @param y     shared state
+ * @param spurs number of searched spur nodes
+ * @return      true if successful, false if memory ran out
+ */
+static bool collect_spurs(struct yen *y, uint32_t spurs)
+{
+    for (uint32_t t = 0; t < spurs; t++) {
+        struct yen_path *p = &y->spurs[t];
+        if (p->len == 0) continue;
+        bool duplicate = false;
+        for (uint32_t c = 0; !duplicate && c < y->candidates_len; c++) {
+            duplicate = same_path(p, &y->candidates[c]);
+        }
+        if (duplicate) {
+            path_free(p);
+            continue;
+        }
+        if (y->candidates_len == y->candidates_size) {
+            uint32_t size = y->candidates_size ? 2 * y->candidates_size : 16;
+            struct yen_path *tmp = realloc(y->candidates,
+                    (size_t) size * sizeof *tmp);
+            if (!tmp) return false;
+            y->candidates = tmp;
+            y->candidates_size = size;
+        }
+        y->candidates[y->candidates_len++] = *p;
+        memset(p, 0, sizeof *p);
+    }
+    return true;
+}
+
+/**
+ * Compare lengths for qsort().
+ *
+ * @param a     first length
+ * @param b     second length
+ * @return      negative, zero or positive as for qsort()
+ */
+static int compare_lengths(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Compute the longest path that can still be accepted and drop longer
+ * candidates.
+ * Once there are candidates for all remaining paths, longer paths would
+ * never be accepted.
+ *
+ * @param y     shared state
+ * @param k     highest number of paths
+ * @return      true if successful, false if memory ran out
+ */
+static bool update_limit(struct yen *y, uint32_t k)
+{
+    uint32_t needed = k - y->count;
+    y->limit = UINT32_MAX;
+    if (y->candidates_len < needed) return true;
+    uint32_t *lengths = malloc(((size_t) y->candidates_len + 1)
+            * sizeof *lengths);
+    if (!lengths) return false;
+    for (uint32_t c = 0; c < y->candidates_len; c++) {
+        lengths[c] = path_length(&y->candidates[c]);
+    }
+    qsort(lengths, y->candidates_len, sizeof *lengths, compare_lengths);
+    y->limit = lengths[needed - 1];
+    free(lengths);
+    uint32_t kept = 0;
+    for (uint32_t c = 0; c < y->candidates_len; c++) {
+        if (path_length(&y->candidates[c]) > y->limit) {
+            path_free(&y->candidates[c]);
+        } else {
+            y->candidates[kept++] = y->candidates[c];
+        }
+    }
+    y->candidates_len = kept;
+    return true;
+}
+
+/**
+ * Accept the best candidate as the next path.
+ * Candidates found earlier win ties, which keeps the order deterministic
+ * regardless of the number of threads.
+ *
+ * @param y     shared state with at least one candidate
+ */
+static void accept_best(struct yen *y)
+{
+    uint32_t best = 0;
+    for (uint32_t c = 1; c < y->candidates_len; c++) {
+        if (path_length(&y->candidates[c])
+                < path_length(&y->candidates[best])) {
+            best = c;
+        }
+    }
+    y->paths[y->count++] = y->candidates[best];
+    y->candidates_len--;
+    memmove(y->candidates + best, y->candidates + best + 1,
+            (size_t) (y->candidates_len - best) * sizeof *y->candidates);
+}
+
+/**
+ * Compute distances to the destination and the shortest path.
+ *
+ * @param y         shared state
+ * @param csr       graph with reverse edges
+ * @param source    index of starting node
+ * @return          true if successful, false if memory ran out
+ */
+static bool first_path(struct yen *y, const Csr *csr, uint32_t source)
+{
+    Search *s = search_new(csr, PQ_AUTO);
+    if (!s || !search_run_all(s, y->destination, true)) {
+        search_free(s);
+        return false;
+    }
+    for (uint32_t i = 0; i < csr->nodes_num; i++) {
+        y->to_dest[i] = search_distance(s, i);
+    }
+    bool ok = true;
+    if (y->to_dest[source] != UINT32_MAX) {
+        uint32_t len = 0;
+        for (uint32_t n = source; n != CSR_NONE; n = search_previous(s, n)) {
+            len++;
+        }
+        struct yen_path *p = &y->paths[0];
+        ok = path_alloc(p, len);
+        uint32_t at = 0;
+        for (uint32_t n = source; ok && n != CSR_NONE;
+                n = search_previous(s, n)) {
+            p->nodes[at] = n;
+            p->dists[at] = y->to_dest[source] - y->to_dest[n];
+            at++;
+        }
+        y->count = ok ? 1 : 0;
+    }
+    search_free(s);
+    return ok;
+}
+
+/**
+ * Prepare threads of a search.
+ *
+ * @param y         shared state
+ * @param workers   number of threads
+ * @return          true if successful, false if memory ran out
+ */
+static bool workers_init(struct yen *y, size_t workers)
+{
+    size_t n = (size_t) y->csr->nodes_num + 1;
+    y->workers = calloc(workers, sizeof *y->workers);
+    if (!y->workers) return false;
+    y->workers_num = workers;
+    for (size_t t = 0; t < workers; t++) {
+        struct spur_worker *w = &y->workers[t];
+        w->stamp = calloc(n, sizeof *w->stamp);
+        w->dist = malloc(n * sizeof *w->dist);
+        w->link = malloc(n * sizeof *w->link);
+        w->removed = calloc(n, sizeof *w->removed);
+        w->banned = calloc(n, sizeof *w->banned);
+        w->queue = pq_new(PQ_BINARY, y->csr->nodes_num, 0);
+        if (!w->stamp || !w->dist || !w->link || !w->removed || !w->banned
+                || !w->queue) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool yen_run(Csr *csr, Pool *pool, uint32_t source, uint32_t destination,
+        uint32_t k, struct yen_path *paths, uint32_t *count)
+{
+    *count = 0;
+    if (!csr || csr->min_weight < 0 || !csr_build_reverse(csr)) return false;
+    if (k == 0) return true;
+    struct yen y;
+    memset(&y, 0, sizeof y);
+    y.csr = csr;
+    y.destination = destination;
+    y.paths = paths;
+    y.to_dest = malloc(((size_t) csr->nodes_num + 1) * sizeof *y.to_dest);
+    bool ok = y.to_dest && workers_init(&y, pool_size(pool))
+        && first_path(&y, csr, source);
+
+    while (ok && y.count > 0 && y.count < k) {
+        const struct yen_path *last = &y.paths[y.count - 1];
+        uint32_t spurs = last->len - 1 - last->spur;
+        if (spurs > y.spurs_size) {
+            struct yen_path *tmp = realloc(y.spurs, (size_t) spurs
+                    * sizeof *tmp);
+            if (!tmp) {
+                ok = false;
+                break;
+            }
+            y.spurs = tmp;
+            y.spurs_size = spurs;
+        }
+        memset(y.spurs, 0, (size_t) spurs * sizeof *y.spurs);
+        if (!update_limit(&y, k)) {
+            ok = false;
+            break;
+        }
+        pool_run(pool, spurs, spur_task, &y);
+        for (size_t t = 0; t < y.workers_num; t++) {
+            ok = ok && !y.workers[t].failed;
+        }
+        ok = ok && collect_spurs(&y, spurs);
+        for (uint32_t t = 0; t < spurs; t++) {
+            path_free(&y.spurs[t]);
+        }
+        if (!ok || y.candidates_len == 0) break;
+        accept_best(&y);
+    }
+
+    yen_free_paths(y.candidates, y.candidates_len);
+    free(y.candidates);
+    free(y.spurs);
+    for (size_t t = 0; y.workers && t < y.workers_num; t++) {
+        free(y.workers[t].stamp);
+        free(y.workers[t].dist);
+        free(y.workers[t].link);
+        free(y.workers[t].removed);
+        free(y.workers[t].banned);
+        pq_free(y.workers[t].queue);
+    }
+    free(y.workers);
+    free(y.to_dest);
+    if (!ok) {
+        yen_free_paths(paths, y.count);
+        return false;
+    }
+    *count = y.count;
+    return true;
+}
+
+void yen_free_paths(struct yen_path *paths, uint32_t count)
+{
+    for (uint32_t i = 0; paths && i < count; i++) {
+        path_free(&paths[i]);
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * Interface for finding several shortest loopless paths (Yen's algorithm).
+ *
+ * The first path is the shortest one. Each following path is the shortest
+ * among candidates that leave some earlier path at one of its nodes (the
+ * spur node): they share the part of the path up to the spur node and
+ * continue by the shortest path from the spur node that avoids the shared
+ * part and edges already taken from the spur node by earlier paths with the
+ * same shared part. Only spur nodes from the point where the last path left
+ * its own predecessor are tried (Lawler's improvement).
+ *
+ * Distances from all nodes to the destination are computed once by a
+ * backward search. Searches from spur nodes use them as A* lower bounds,
+ * which are exact unless the shortest path is blocked, so they finish little
+ * more than the nodes of the found path. Blocked nodes and edges are marked
+ * in arrays of each thread and skipped while searching, the graph is not
+ * copied. Searches from all spur nodes of a path run in parallel.
+ *
+ * Only graphs without negative edge weights can be searched.
+ *
+ * @file    yen.h
+ */
+#ifndef YEN_H
+#define YEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csr.h"
+#include "pool.h"
+
+/** Path found by yen_run(). */
+struct yen_path {
+    /** Indices of nodes on the path, starting with the starting node */
+    uint32_t *nodes;
+    /** Distance of each node from the starting node along the path */
+    uint32_t *dists;
+    /** Number of nodes on the path */
+    uint32_t len;
+    /** Position of the spur node where the path left the path it was found
+     * from, 0 for the shortest path */
+    uint32_t spur;
+};
+
+/**
+ * Find shortest loopless paths between two nodes, shorter paths first.
+ * Paths of equal length are reported in the order they were found. Reverse
+ * edges of the graph are built if they do not exist yet.
+ *
+ * @param csr           frozen graph without negative edge weights
+ * @param pool          threads running searches from spur nodes, may be NULL
+ * @param source        index of starting node
+ * @param destination   index of destination node
+ * @param k             highest number of paths
+ * @param[out] paths    array of at least `k` paths to be filled, free them
+ *                      with yen_free_paths()
+ * @param[out] count    number of found paths, lower than `k` if there are no
+ *                      more loopless paths
+ * @return              true if successful, false if memory ran out or the
+ *                      graph has negative weights
+ */
+bool yen_run(Csr *csr, Pool *pool, uint32_t source, uint32_t destination,
+        uint32_t k, struct yen_path *paths, uint32_t *count);
+
+/**
+ * Free paths found by yen_run().
+ *
+ * @param paths     array of paths, the array itself is not freed
+ * @param count     number of paths
+ */
+void yen_free_paths(struct yen_path *paths, uint32_t count);
+
+#endif /* end of include guard: YEN_H */